@@ -0,0 +1,43 @@
+//
+// Occupancy of a sub-allocator, as BuddyAllocator, VariableSizeAllocationsManager and the descriptor heaps
+// report it. Sizes are in bytes except for allocators that hand out other units, such as descriptors, which
+// say so. The allocators keep the counters up to date on every allocation; gathering them is cheap enough to
+// do every frame, which EngineProfiling does for the allocators registered with it.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+struct AllocatorStats
+{
+    size_t Capacity = 0;
+    size_t UsedSize = 0;            // Handed out, pending frees and padding included
+    size_t PeakUsedSize = 0;        // High-water mark of UsedSize since creation
+    size_t PaddingSize = 0;         // The part of UsedSize lost to rounding up and aligning allocations
+    size_t PendingFreeSize = 0;     // The part of UsedSize freed but waiting on a fence
+    size_t FreeBlockCount = 0;
+    size_t LargestFreeBlock = 0;
+    uint64_t AllocationCount = 0;   // Since creation
+    uint64_t FreeCount = 0;         // Since creation, counted when the block is actually released
+
+    // Filled in by EngineProfiling: the counts of the last frame sampled.
+    uint64_t FrameAllocationCount = 0;
+    uint64_t FrameFreeCount = 0;
+
+    size_t FreeSize() const { return Capacity - UsedSize; }
+
+    // How much of the used space is padding.
+    float InternalFragmentation() const
+    {
+        return UsedSize == 0 ? 0.0f : float(PaddingSize) / float(UsedSize);
+    }
+
+    // How much of the free space cannot be handed out in one block: 0 when it is all one block, towards 1 as it
+    // scatters.
+    float ExternalFragmentation() const
+    {
+        return FreeSize() == 0 ? 0.0f : 1.0f - float(LargestFreeBlock) / float(FreeSize());
+    }
+};
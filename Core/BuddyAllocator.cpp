@@ -16,6 +16,7 @@
 #include "GraphicsCore.h"
 #include "CommandListManager.h"
 #include "CommandContext.h"
+#include <thread>
 
 using namespace Graphics;
 using namespace std;
@@ -51,29 +52,68 @@ void BuddyBlock::InitFromResource(ByteAddressBuffer* pBuffer, uint32_t numElemen
 void BuddyBlock::Destroy()
 {
     m_pBuffer->Destroy();
+    delete m_pBuffer;
     m_pBuffer = nullptr;
 }
 
-BuddyAllocator::BuddyAllocator(kBuddyAllocationStrategy allocationStrategy, D3D12_HEAP_TYPE heapType, size_t maxBlockSize, size_t MinBlockSize, size_t baseOffset)
+BuddyAllocator::BuddyAllocator(kBuddyAllocationStrategy allocationStrategy, D3D12_HEAP_TYPE heapType, size_t maxBlockSize, size_t MinBlockSize, size_t baseOffset, uint32_t shardCount)
     : m_allocationStrategy(allocationStrategy)
     , m_heapType(heapType)
     , m_baseOffset(baseOffset)
     , m_maxBlockSize(maxBlockSize)
     , m_minBlockSize(MinBlockSize)
     , m_pBackingHeap(nullptr)
-#if defined(PROFILE) || defined(_DEBUG)
     , m_SpaceUsed(0)
+    , m_PeakSpaceUsed(0)
     , m_InternalFragmentation(0)
-#endif
+    , m_PendingSpace(0)
+    , m_AllocationCount(0)
+    , m_FreeCount(0)
 {
     ASSERT(Math::IsDivisible(maxBlockSize, m_minBlockSize));
     ASSERT(Math::IsPowerOfTwo(maxBlockSize / m_minBlockSize));
 
+    ASSERT(shardCount > 0 && Math::IsPowerOfTwo(shardCount));
+
     m_maxOrder = UnitSizeToOrder(SizeToUnitSize(maxBlockSize));
 
+    // A shard is at least one block of the minimum size
+    m_shardCount = min<size_t>(shardCount, OrderToUnitSize(m_maxOrder));
+    m_shardOrder = m_maxOrder - Math::Log2(m_shardCount);
+    m_shards.reset(new Shard[m_shardCount]);
+
     Reset();
 }
 
+void BuddyAllocator::Reset()
+{
+    for (size_t i = 0; i < m_shardCount; ++i)
+    {
+        m_shards[i].m_freeBlockCount = 1;
+
+        std::queue<BuddyBlock>& pending = m_shards[i].m_deferredDeletionQueue;
+        for (; !pending.empty(); pending.pop())
+        {
+            if (m_allocationStrategy == kBuddyAllocationStrategy::kPlacedResourceStrategy)
+            {
+                pending.front().Destroy();
+            }
+        }
+    }
+
+    // Mark every node free, as if the pool were a single free block of max block size
+    m_freeTree.resize(OrderToUnitSize(m_maxOrder + 1));
+    for (UINT order = 0; order <= m_maxOrder; ++order)
+    {
+        const size_t firstNode = OrderToUnitSize(m_maxOrder - order);
+        std::fill_n(m_freeTree.begin() + firstNode, firstNode, uint8_t(order + 1));
+    }
+
+    m_SpaceUsed = 0;
+    m_InternalFragmentation = 0;
+    m_PendingSpace = 0;
+}
+
 void BuddyAllocator::Initialize()
 {
     if (m_allocationStrategy == kBuddyAllocationStrategy::kPlacedResourceStrategy)
@@ -108,157 +148,329 @@ void BuddyAllocator::Destroy()
 
 size_t BuddyAllocator::AllocateBlock(UINT order)
 {
-    size_t offset;
-
     if (order > m_maxOrder)
     {
-        throw(std::bad_alloc()); // Can't allocate a block that large  
+        return kInvalidOffset; // Can't allocate a block that large
+    }
+    if (order > m_shardOrder)
+    {
+        return AllocateShards(order);
     }
 
-    auto it = m_freeBlocks[order].begin();
-
-    if (it == m_freeBlocks[order].end())
+    // Each thread starts at its own shard and moves on to the next ones when it is full
+    const size_t firstShard = hash<thread::id>()(this_thread::get_id());
+    for (size_t i = 0; i < m_shardCount; ++i)
     {
-        // No free nodes in the requested pool.  Try to find a higher-order block and split it.  
-        size_t left = AllocateBlock(order + 1);
+        const size_t shard = (firstShard + i) & (m_shardCount - 1);
 
-        size_t size = OrderToUnitSize(order);
+        lock_guard<mutex> lock(m_shards[shard].m_mutex);
+        const size_t offset = AllocateFromShard(shard, order);
+        if (offset != kInvalidOffset)
+        {
+            return offset;
+        }
+    }
 
-        size_t right = left + size;
+    return kInvalidOffset;
+}
 
-        m_freeBlocks[order].insert(right); // Add the right block to the free pool  
+void BuddyAllocator::DeallocateBlock(size_t offset, UINT order)
+{
+    if (order > m_shardOrder)
+    {
+        DeallocateShards(offset, order);
+        return;
+    }
 
-        offset = left; // Return the left block  
+    lock_guard<mutex> lock(m_shards[offset >> m_shardOrder].m_mutex);
+    DeallocateFromShard(offset, order);
+}
+
+size_t BuddyAllocator::AllocateFromShard(size_t shard, UINT order)
+{
+    const size_t root = m_shardCount + shard;
+    if (m_freeTree[root] <= order)
+    {
+        return kInvalidOffset; // No free block is large enough
     }
 
-    else
+    // Walk down to a free node of the requested order. When both children have a large enough
+    // block, take the one whose largest free block is smaller so that large blocks stay whole.
+    // The first wholly free node on the way is the free block being split.
+    UINT splitOrder = order;
+    size_t node = root;
+    for (UINT nodeOrder = m_shardOrder; nodeOrder > order; --nodeOrder)
     {
-        offset = *it;
+        if (splitOrder == order && m_freeTree[node] == nodeOrder + 1)
+        {
+            splitOrder = nodeOrder;
+        }
+
+        const size_t left = node * 2;
+        const uint8_t leftFree = m_freeTree[left];
+        const uint8_t rightFree = m_freeTree[left + 1];
 
-        // Remove the block from the free list  
-        m_freeBlocks[order].erase(it);
+        node = (leftFree > order && (rightFree <= order || leftFree <= rightFree)) ? left : left + 1;
+    }
+
+    m_freeTree[node] = 0;
+    const size_t offset = (node - OrderToUnitSize(m_maxOrder - order)) << order;
+
+    // The split block is gone, leaving one free buddy per level it was split
+    m_shards[shard].m_freeBlockCount += splitOrder - order;
+    m_shards[shard].m_freeBlockCount -= 1;
+
+    // Update the largest free block of the ancestors up to the shard root, stopping once one does not change
+    while (node > root)
+    {
+        node /= 2;
+        const uint8_t largest = max(m_freeTree[node * 2], m_freeTree[node * 2 + 1]);
+        if (m_freeTree[node] == largest)
+        {
+            break;
+        }
+        m_freeTree[node] = largest;
     }
 
     return offset;
 }
 
-void BuddyAllocator::DeallocateBlock(size_t offset, UINT order)
+void BuddyAllocator::DeallocateFromShard(size_t offset, UINT order)
 {
-    // See if the buddy block is free  
-    size_t size = OrderToUnitSize(order);
+    const size_t shard = offset >> m_shardOrder;
+    const size_t root = m_shardCount + shard;
 
-    size_t buddy = GetBuddyOffset(offset, size);
+    size_t node = OrderToUnitSize(m_maxOrder - order) + (offset >> order);
+    ASSERT(m_freeTree[node] == 0, "Buddy block freed twice");
 
-    auto it = m_freeBlocks[order].find(buddy);
+    m_freeTree[node] = uint8_t(order + 1);
+    m_shards[shard].m_freeBlockCount += 1;
 
-    if (it != m_freeBlocks[order].end())
-    {
-        // Deallocate merged blocks  
-        DeallocateBlock(min(offset, buddy), order + 1);
-        // Remove the buddy from the free list  
-        m_freeBlocks[order].erase(it);
-    }
-    else
+    // Walk up to the shard root, merging with the buddy whenever both halves of a node are free
+    for (UINT nodeOrder = order + 1; node > root; ++nodeOrder)
     {
-        // Add the block to the free list  
-        m_freeBlocks[order].insert(offset); // throw(std::bad_alloc) 
+        node /= 2;
+        const uint8_t leftFree = m_freeTree[node * 2];
+        const uint8_t rightFree = m_freeTree[node * 2 + 1];
+
+        if (leftFree == nodeOrder && rightFree == nodeOrder)
+        {
+            m_freeTree[node] = uint8_t(nodeOrder + 1);
+            m_shards[shard].m_freeBlockCount -= 1;
+        }
+        else
+        {
+            m_freeTree[node] = max(leftFree, rightFree);
+        }
     }
 }
 
-BuddyBlock* BuddyAllocator::Allocate(uint32_t numElements, uint32_t elementSize, const void* initialData)
+size_t BuddyAllocator::AllocateShards(UINT order)
 {
-    size_t size = numElements * elementSize;
-    size_t unitSize = SizeToUnitSize(size);
-    UINT order = UnitSizeToOrder(unitSize);
+    const size_t shardsPerBlock = OrderToUnitSize(order - m_shardOrder);
+    const uint8_t wholeShard = uint8_t(m_shardOrder + 1);
 
-    try
+    for (size_t i = 0; i < m_shardCount; ++i)
     {
-        size_t offset = AllocateBlock(order);
-        uint32_t paddedSize = uint32_t(OrderToUnitSize(order) * m_minBlockSize);
-
-        uint32_t blockOffset = uint32_t(m_baseOffset + (offset * m_minBlockSize));
-
-        INCREASE_BUDDY_COUNTER(m_SpaceUsed, paddedSize);
-        INCREASE_BUDDY_COUNTER(m_InternalFragmentation, (paddedSize - size));
+        m_shards[i].m_mutex.lock();
+    }
 
-        BuddyBlock* pBlock = new BuddyBlock(blockOffset, //offset
-            paddedSize, //total size (padded to fit a block)
-            numElements * elementSize);
-            
-        if (m_allocationStrategy == kBuddyAllocationStrategy::kPlacedResourceStrategy)
+    size_t offset = kInvalidOffset;
+    for (size_t first = 0; first < m_shardCount && offset == kInvalidOffset; first += shardsPerBlock)
+    {
+        size_t shard = first;
+        while (shard < first + shardsPerBlock && m_freeTree[m_shardCount + shard] == wholeShard)
         {
-            pBlock->InitPlaced(m_pBackingHeap, numElements, elementSize, initialData);
+            ++shard;
         }
-        else
+        if (shard == first + shardsPerBlock)
         {
-            //TODO: To be truely thread-safe this operation should be atomic to guard against
-            //      the case in which blocks from this allocator are used on multiple threads 
-            //      (because it's really only 1 resource underneath)
-            pBlock->InitFromResource(&m_BackingResource, numElements, elementSize, initialData);
+            for (shard = first; shard < first + shardsPerBlock; ++shard)
+            {
+                m_freeTree[m_shardCount + shard] = 0;
+                m_shards[shard].m_freeBlockCount = 0;
+            }
+            offset = first << m_shardOrder;
         }
+    }
 
-        return pBlock;
+    for (size_t i = 0; i < m_shardCount; ++i)
+    {
+        m_shards[i].m_mutex.unlock();
     }
 
-    catch (std::bad_alloc&)
+    return offset;
+}
+
+void BuddyAllocator::DeallocateShards(size_t offset, UINT order)
+{
+    const size_t shardsPerBlock = OrderToUnitSize(order - m_shardOrder);
+    const size_t first = offset >> m_shardOrder;
+
+    for (size_t shard = first; shard < first + shardsPerBlock; ++shard)
+    {
+        lock_guard<mutex> lock(m_shards[shard].m_mutex);
+        ASSERT(m_freeTree[m_shardCount + shard] == 0, "Buddy block freed twice");
+        m_freeTree[m_shardCount + shard] = uint8_t(m_shardOrder + 1);
+        m_shards[shard].m_freeBlockCount = 1;
+    }
+}
+
+BuddyBlock BuddyAllocator::Allocate(uint32_t numElements, uint32_t elementSize, const void* initialData)
+{
+    size_t size = numElements * elementSize;
+    size_t unitSize = SizeToUnitSize(size);
+    UINT order = UnitSizeToOrder(unitSize);
+
+    size_t offset = AllocateBlock(order);
+    if (offset == kInvalidOffset)
     {
         // There are no blocks available for the requested size so  
         // return the NULL block type  
-        return new BuddyBlock();
+        return BuddyBlock();
     }
+
+    uint32_t paddedSize = uint32_t(OrderToUnitSize(order) * m_minBlockSize);
+
+    uint32_t blockOffset = uint32_t(m_baseOffset + (offset * m_minBlockSize));
+
+    const size_t spaceUsed = m_SpaceUsed += paddedSize;
+    for (size_t peak = m_PeakSpaceUsed; spaceUsed > peak && !m_PeakSpaceUsed.compare_exchange_weak(peak, spaceUsed);)
+    {
+    }
+    m_InternalFragmentation += paddedSize - size;
+    ++m_AllocationCount;
+
+    BuddyBlock block(blockOffset, //offset
+        paddedSize, //total size (padded to fit a block)
+        numElements * elementSize);
+
+    if (m_allocationStrategy == kBuddyAllocationStrategy::kPlacedResourceStrategy)
+    {
+        block.InitPlaced(m_pBackingHeap, numElements, elementSize, initialData);
+    }
+    else
+    {
+        // Every block shares the state of the one resource underneath, so the transitions
+        // around the copy into it must not interleave between threads
+        lock_guard<mutex> lock(m_BackingResourceMutex);
+        block.InitFromResource(&m_BackingResource, numElements, elementSize, initialData);
+    }
+
+    return block;
+}
+
+void BuddyAllocator::Deallocate(BuddyBlock& block)
+{
+    Deallocate(block, g_CommandManager.GetGraphicsQueue().GetNextFenceValue());
 }
 
-/*
-void BuddyAllocator::Deallocate(BuddyBlock* pBlock)
+void BuddyAllocator::Deallocate(BuddyBlock& block, uint64_t fenceValue)
 {
-    pBlock->m_fenceValue = g_CommandManager.GetNextFenceValue();
-    m_deferredDeletionQueue.push(pBlock);
+    if (block.IsNull())
+    {
+        return;
+    }
+
+    ASSERT(IsOwner(block));
+
+    block.m_fenceValue = fenceValue;
+    m_PendingSpace += block.GetSize();
+
+    Shard& shard = m_shards[SizeToUnitSize(block.GetOffset() - m_baseOffset) >> m_shardOrder];
+    {
+        lock_guard<mutex> lock(shard.m_mutex);
+        shard.m_deferredDeletionQueue.push(block);
+    }
+    block = BuddyBlock();
 }
-*/
 
-void BuddyAllocator::DeallocateInternal(BuddyBlock* pBlock)
+void BuddyAllocator::DeallocateInternal(BuddyBlock& block)
 {
-    ASSERT(IsOwner(*pBlock));
+    ASSERT(IsOwner(block));
 
-    size_t offset = SizeToUnitSize(pBlock->GetOffset() - m_baseOffset);
+    size_t offset = SizeToUnitSize(block.GetOffset() - m_baseOffset);
 
-    size_t size = SizeToUnitSize(pBlock->GetSize());
+    size_t size = SizeToUnitSize(block.GetSize());
 
     UINT order = UnitSizeToOrder(size);
 
-    try
+    // Before the space can be handed out again, so that the counters never add up to more than the capacity
+    m_SpaceUsed -= block.GetSize();
+    m_InternalFragmentation -= block.GetSize() - block.m_unpaddedSize;
+    ++m_FreeCount;
+
+    DeallocateBlock(offset, order);
+
+    if (m_allocationStrategy == kBuddyAllocationStrategy::kPlacedResourceStrategy)
+    {
+        // Release the resource
+        block.Destroy();
+    }
+    block = BuddyBlock();
+};
+
+void BuddyAllocator::CleanUpAllocations()
+{
+    // Each queue is in the order the blocks were freed, so it stops at the first fence still pending
+    for (size_t i = 0; i < m_shardCount; ++i)
     {
-        DeallocateBlock(offset, order); // throw(std::bad_alloc)
+        Shard& shard = m_shards[i];
 
-        DECREASE_BUDDY_COUNTER(m_SpaceUsed, size);
-        DECREASE_BUDDY_COUNTER(m_InternalFragmentation, (size - pBlock->m_unpaddedSize));
-        
-        if (m_allocationStrategy == kBuddyAllocationStrategy::kPlacedResourceStrategy)
+        lock_guard<mutex> lock(shard.m_mutex);
+        while (shard.m_deferredDeletionQueue.empty() == false &&
+            g_CommandManager.IsFenceComplete(shard.m_deferredDeletionQueue.front().m_fenceValue))
         {
-            // Release the resource
-            pBlock->Destroy();
+            m_completedBlocks.push_back(shard.m_deferredDeletionQueue.front());
+            shard.m_deferredDeletionQueue.pop();
         }
-        delete(pBlock);
     }
 
-    catch (std::bad_alloc&)
+    // Free them outside the queue locks; blocks spanning several shards take all of their locks
+    for (BuddyBlock& block : m_completedBlocks)
     {
-        // Deallocate failed trying to add the free block to the pool  
-        // resulting in a leak.  Unfortunately there is not much we can do.  
-        // Fortunately this is expected to be extremely rare as the storage  
-        // needed for each deallocate is very small.  
+        m_PendingSpace -= block.GetSize();
+        DeallocateInternal(block);
     }
-};
+    m_completedBlocks.clear();
+}
 
-/*
-void BuddyAllocator::CleanUpAllocations()
+AllocatorStats BuddyAllocator::GetStats()
 {
-    while (m_deferredDeletionQueue.empty() == false &&
-        g_CommandManager.IsFenceComplete(m_deferredDeletionQueue.front()->m_fenceValue))
+    AllocatorStats stats;
+    stats.Capacity = m_maxBlockSize;
+    stats.UsedSize = m_SpaceUsed;
+    stats.PeakUsedSize = m_PeakSpaceUsed;
+    stats.PaddingSize = m_InternalFragmentation;
+    stats.PendingFreeSize = m_PendingSpace;
+    stats.AllocationCount = m_AllocationCount;
+    stats.FreeCount = m_FreeCount;
+
+    // The largest free block is in one shard, unless a run of whole free shards makes a larger one
+    UINT largestOrder = 0;
+    size_t wholeShards = 0;
+    for (size_t i = 0; i < m_shardCount; ++i)
     {
-        BuddyBlock* pBlock = m_deferredDeletionQueue.front();
-        m_deferredDeletionQueue.pop();
+        lock_guard<mutex> lock(m_shards[i].m_mutex);
+        const uint8_t largestFree = m_freeTree[m_shardCount + i];
 
-        DeallocateInternal(pBlock);
+        stats.FreeBlockCount += m_shards[i].m_freeBlockCount;
+        if (largestFree > 0)
+        {
+            stats.LargestFreeBlock = max(stats.LargestFreeBlock, OrderToUnitSize(largestFree - 1) * m_minBlockSize);
+        }
+
+        // Only aligned runs of shards can be allocated as one block
+        wholeShards = largestFree == m_shardOrder + 1 ? wholeShards + 1 : 0;
+        while (OrderToUnitSize(largestOrder + 1) <= wholeShards && Math::IsDivisible(i + 1, OrderToUnitSize(largestOrder + 1)))
+        {
+            ++largestOrder;
+        }
     }
-}*/
+    if (largestOrder > 0)
+    {
+        stats.LargestFreeBlock = max(stats.LargestFreeBlock, OrderToUnitSize(m_shardOrder + largestOrder) * m_minBlockSize);
+    }
+
+    return stats;
+}
@@ -16,27 +16,34 @@
 // When a block is de-allocated an attempt is made to merge it with it's 
 // neighbour (buddy) if it is contiguous and free.
 // Based on reference implementation by Bill Kristiansen
+//
+// The blocks are tracked in an implicit binary tree stored as an array, one
+// byte per node: each node holds one more than the order of the largest free
+// block below it, or zero when none is left. Allocation walks down from the
+// root and deallocation walks up from the leaf, so both are O(log n) without
+// recursion or allocating any memory. The tree takes two bytes per block of
+// the minimum size, so allocators with a tiny minimum block size over a large
+// range pay for it.
+//
+// The range is split into shards, each a subtree with its own lock and its own
+// queue of blocks waiting on a fence, so loader threads allocating and freeing
+// at the same time mostly take different locks. Blocks larger than a shard
+// take every shard they span.
 //  
 
 #pragma once
 
 #include "GpuBuffer.h"
+#include "AllocatorStats.h"
 #include <vector>
 #include <queue>
 #include <mutex>
-#include <set>
+#include <memory>
+#include <atomic>
 
 // Unfortunately the api restricts the minimum size of a placed buffer resource to 64k
 #define MIN_PLACED_BUFFER_SIZE (64 * 1024)
 
-#if defined(PROFILE) || defined(_DEBUG)
-#define INCREASE_BUDDY_COUNTER(A, B) (A = A + B);
-#define DECREASE_BUDDY_COUNTER(A, B) (A = A - B);
-#else
-#define INCREASE_BUDDY_COUNTER(A, B)
-#define DECREASE_BUDDY_COUNTER(A, B)
-#endif
-
 enum kBuddyAllocationStrategy
 {
     // This strategy uses Placed Resources to sub-allocate a buffer out of an underlying ID3D12Heap.
@@ -63,6 +70,7 @@ struct BuddyBlock
 
     inline size_t GetOffset() const { return m_offset; }
     inline size_t GetSize() const { return m_size; }
+    inline bool IsNull() const { return m_size == 0; }
 
     BuddyBlock() : m_pBuffer(nullptr), m_pBackingHeap(nullptr), m_offset(0), m_size(0), m_unpaddedSize(0), m_fenceValue(0) {};
 
@@ -79,42 +87,54 @@ class BuddyAllocator
 {
 public:
 
-    BuddyAllocator(kBuddyAllocationStrategy allocationStrategy, D3D12_HEAP_TYPE heapType, size_t maxBlockSize, size_t minBlockSize = MIN_PLACED_BUFFER_SIZE, size_t baseOffset = 0);
+    BuddyAllocator(kBuddyAllocationStrategy allocationStrategy, D3D12_HEAP_TYPE heapType, size_t maxBlockSize, size_t minBlockSize = MIN_PLACED_BUFFER_SIZE, size_t baseOffset = 0, uint32_t shardCount = 4);
 
     void Initialize();
 
     void Destroy();
 
-    BuddyBlock* Allocate(uint32_t numElements, uint32_t elementSize, const void* initialData = nullptr);
+    // Returns a null block when no free block is large enough. Thread-safe.
+    BuddyBlock Allocate(uint32_t numElements, uint32_t elementSize, const void* initialData = nullptr);
 
-    void Deallocate(BuddyBlock* pBlock);
+    // Queues the block to be freed once the GPU has passed fenceValue, by default the next
+    // fence of the graphics queue, and nulls the handle. Thread-safe.
+    void Deallocate(BuddyBlock& block);
+    void Deallocate(BuddyBlock& block, uint64_t fenceValue);
 
     inline bool IsOwner(const BuddyBlock &block)
     {
         return block.GetOffset() >= m_baseOffset && block.GetSize() <= m_maxBlockSize;
     }
 
-    inline void Reset()
-    {
-        // Clear the free blocks collection  
-        m_freeBlocks.clear();
-
-        // Initialize the pool with a free inner block of max inner block size  
-        m_freeBlocks.resize(m_maxOrder + 1);
-        m_freeBlocks[m_maxOrder].insert((size_t)0);
-    }
+    // Frees every block, pending or not. Only when neither the GPU nor another thread uses the allocator.
+    void Reset();
 
+    // Frees the queued blocks whose fence has completed. Call once per frame from one thread.
     void CleanUpAllocations();
 
+    // Thread-safe; takes each shard lock in turn.
+    AllocatorStats GetStats();
+
 private:
     ID3D12Heap* m_pBackingHeap;
     ByteAddressBuffer m_BackingResource;
 
     const D3D12_HEAP_TYPE m_heapType;
 
-    std::queue<BuddyBlock*> m_deferredDeletionQueue;
-    std::vector<std::set<size_t>> m_freeBlocks;
+    struct Shard
+    {
+        std::mutex m_mutex; // Guards the subtree of the shard and its queue
+        std::queue<BuddyBlock> m_deferredDeletionQueue; // Blocks starting in the shard
+        size_t m_freeBlockCount = 1;
+    };
+
+    std::unique_ptr<Shard[]> m_shards;
+    std::vector<BuddyBlock> m_completedBlocks; // Scratch of CleanUpAllocations()
+    std::mutex m_BackingResourceMutex; // The manual strategy shares one resource state
+    std::vector<uint8_t> m_freeTree; // Node 1 is the root, the children of node n are 2n and 2n + 1
     UINT m_maxOrder;
+    UINT m_shardOrder; // The roots of the shards are nodes m_shardCount to 2 * m_shardCount - 1
+    size_t m_shardCount;
     const size_t m_baseOffset;
     const size_t m_maxBlockSize;
     const size_t m_minBlockSize;
@@ -136,14 +156,27 @@ private:
         return offset ^ size;
     }
 
-    void DeallocateInternal(BuddyBlock* pBlock);
+    void DeallocateInternal(BuddyBlock& block);
+
+    static const size_t kInvalidOffset = ~(size_t)0;
 
     size_t OrderToUnitSize(UINT order) const { return ((size_t)1) << order; }
-    size_t AllocateBlock(UINT order);
+    size_t AllocateBlock(UINT order); // Returns kInvalidOffset when no block of the order is free
     void DeallocateBlock(size_t offset, UINT order);
 
-#if defined(PROFILE) || defined(_DEBUG)
-    size_t m_SpaceUsed;
-    size_t m_InternalFragmentation;
-#endif
+    // The same within one shard, whose lock the caller holds.
+    size_t AllocateFromShard(size_t shard, UINT order);
+    void DeallocateFromShard(size_t offset, UINT order);
+
+    // Blocks larger than a shard: whole shards, all locked in ascending order.
+    size_t AllocateShards(UINT order);
+    void DeallocateShards(size_t offset, UINT order);
+
+    // Statistics
+    std::atomic<size_t> m_SpaceUsed;
+    std::atomic<size_t> m_PeakSpaceUsed;
+    std::atomic<size_t> m_InternalFragmentation;
+    std::atomic<size_t> m_PendingSpace;
+    std::atomic<uint64_t> m_AllocationCount;
+    std::atomic<uint64_t> m_FreeCount;
 };
@@ -163,7 +163,7 @@ CommandContext::CommandContext(D3D12_COMMAND_LIST_TYPE Type) :
     m_Type(Type),
     m_DynamicViewDescriptorHeap(*this, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV),
     m_DynamicSamplerDescriptorHeap(*this, D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER),
-    m_CpuLinearAllocator(kCpuWritable), 
+    m_CpuLinearAllocator(kCpuWritable, true),
     m_GpuLinearAllocator(kGpuExclusive)
 {
     //m_OwningManager = nullptr;
@@ -421,6 +421,69 @@ void CommandContext::BeginResourceTransition(GpuResource& Resource, D3D12_RESOUR
         FlushResourceBarriers();
 }
 
+void CommandContext::TransitionSubresources(GpuResource& Resource, UINT FirstMip, UINT NumMips, UINT FirstSlice, UINT NumSlices,
+    D3D12_RESOURCE_STATES OldState, D3D12_RESOURCE_STATES NewState, D3D12_RESOURCE_BARRIER_FLAGS Flags)
+{
+    if (m_Type == D3D12_COMMAND_LIST_TYPE_COMPUTE)
+    {
+        ASSERT((OldState & VALID_COMPUTE_QUEUE_RESOURCE_STATES) == OldState);
+        ASSERT((NewState & VALID_COMPUTE_QUEUE_RESOURCE_STATES) == NewState);
+    }
+
+    if (OldState == NewState)
+    {
+        if (NewState == D3D12_RESOURCE_STATE_UNORDERED_ACCESS && Flags != D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY)
+            InsertUAVBarrier(Resource);
+        return;
+    }
+
+    const D3D12_RESOURCE_DESC Desc = Resource.GetResource()->GetDesc();
+    const UINT MipLevels = Desc.MipLevels;
+    const UINT ArraySize = Desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D ? 1 : Desc.DepthOrArraySize;
+
+    if (FirstMip == 0 && FirstSlice == 0 && NumMips >= MipLevels && NumSlices >= ArraySize)
+    {
+        D3D12_RESOURCE_BARRIER& BarrierDesc = m_ResourceBarrierBuffer[m_NumBarriersToFlush++];
+
+        BarrierDesc.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+        BarrierDesc.Flags = Flags;
+        BarrierDesc.Transition.pResource = Resource.GetResource();
+        BarrierDesc.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+        BarrierDesc.Transition.StateBefore = OldState;
+        BarrierDesc.Transition.StateAfter = NewState;
+
+        if (Flags != D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY)
+            Resource.m_UsageState = NewState;
+
+        if (m_NumBarriersToFlush == 16)
+            FlushResourceBarriers();
+        return;
+    }
+
+    for (UINT Slice = FirstSlice; Slice < ArraySize && Slice - FirstSlice < NumSlices; ++Slice)
+    {
+        for (UINT Mip = FirstMip; Mip < MipLevels && Mip - FirstMip < NumMips; ++Mip)
+        {
+            D3D12_RESOURCE_BARRIER& BarrierDesc = m_ResourceBarrierBuffer[m_NumBarriersToFlush++];
+
+            BarrierDesc.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+            BarrierDesc.Flags = Flags;
+            BarrierDesc.Transition.pResource = Resource.GetResource();
+            BarrierDesc.Transition.Subresource = D3D12CalcSubresource(Mip, Slice, 0, MipLevels, ArraySize);
+            BarrierDesc.Transition.StateBefore = OldState;
+            BarrierDesc.Transition.StateAfter = NewState;
+
+            if (m_NumBarriersToFlush == 16)
+                FlushResourceBarriers();
+        }
+    }
+}
+
+void CommandContext::AssumeResourceState(GpuResource& Resource, D3D12_RESOURCE_STATES State)
+{
+    Resource.m_UsageState = State;
+}
+
 void CommandContext::InsertUAVBarrier(GpuResource& Resource, bool FlushImmediate)
 {
     ASSERT(m_NumBarriersToFlush < 16, "Exceeded arbitrary limit on buffered barriers");
@@ -448,6 +511,25 @@ void CommandContext::InsertAliasBarrier(GpuResource& Before, GpuResource& After,
         FlushResourceBarriers();
 }
 
+void CommandContext::ActivatePlacedResource(GpuResource& Resource, D3D12_RESOURCE_STATES DiscardState)
+{
+    ASSERT(m_NumBarriersToFlush < 16, "Exceeded arbitrary limit on buffered barriers");
+    D3D12_RESOURCE_BARRIER& BarrierDesc = m_ResourceBarrierBuffer[m_NumBarriersToFlush++];
+
+    // No particular resource before: whatever overlaps the new one is done with the memory.
+    BarrierDesc.Type = D3D12_RESOURCE_BARRIER_TYPE_ALIASING;
+    BarrierDesc.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+    BarrierDesc.Aliasing.pResourceBefore = nullptr;
+    BarrierDesc.Aliasing.pResourceAfter = Resource.GetResource();
+
+    if (DiscardState == D3D12_RESOURCE_STATE_COMMON)
+        return;
+
+    ASSERT(m_Type == D3D12_COMMAND_LIST_TYPE_DIRECT, "Only graphics command lists can discard resources");
+    TransitionResource(Resource, DiscardState, true);
+    m_CommandList->DiscardResource(Resource.GetResource(), nullptr);
+}
+
 void CommandContext::WriteBuffer( GpuResource& Dest, size_t DestOffset, const void* BufferData, size_t NumBytes )
 {
     ASSERT(BufferData != nullptr && Math::IsAligned(BufferData, 16));
@@ -146,8 +146,18 @@ public:
 
     void TransitionResource(GpuResource& Resource, D3D12_RESOURCE_STATES NewState, bool FlushImmediate = false);
     void BeginResourceTransition(GpuResource& Resource, D3D12_RESOURCE_STATES NewState, bool FlushImmediate = false);
+    // Transitions a box of mips and array slices from a state the caller tracks for them. The state tracked for the
+    // whole resource only follows NewState when the box covers all of it; once transitions of smaller boxes have
+    // brought every subresource to one state, the caller hands that state over with AssumeResourceState().
+    void TransitionSubresources(GpuResource& Resource, UINT FirstMip, UINT NumMips, UINT FirstSlice, UINT NumSlices,
+        D3D12_RESOURCE_STATES OldState, D3D12_RESOURCE_STATES NewState, D3D12_RESOURCE_BARRIER_FLAGS Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE);
+    void AssumeResourceState(GpuResource& Resource, D3D12_RESOURCE_STATES State);
     void InsertUAVBarrier(GpuResource& Resource, bool FlushImmediate = false);
     void InsertAliasBarrier(GpuResource& Before, GpuResource& After, bool FlushImmediate = false);
+    // Starts the life of a placed resource in heap memory that other resources used before it.  Render targets and
+    // depth buffers must be cleared, copied to or discarded before anything reads them, so unless DiscardState is
+    // COMMON the resource is also discarded in that state, which takes a graphics command list.
+    void ActivatePlacedResource(GpuResource& Resource, D3D12_RESOURCE_STATES DiscardState = D3D12_RESOURCE_STATE_COMMON);
     inline void FlushResourceBarriers(void);
 
     void InsertTimeStamp( ID3D12QueryHeap* pQueryHeap, uint32_t QueryIdx );
@@ -30,7 +30,7 @@ namespace LearnRenderer
         m_HeapDesc{ HeapDesc },
         m_DescriptorSize{ DeviceD3D12->GetDescriptorHandleIncrementSize(m_HeapDesc.Type) },
         m_NumDescriptorsInAllocation{ HeapDesc.NumDescriptors },
-        m_FreeBlockManager{ HeapDesc.NumDescriptors }
+        m_FreeBlockManager{ HeapDesc.NumDescriptors, VariableSizeAllocationsManager::BackendType::TLSF }
     {
         Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> pd3d12DescriptorHeap;
         ASSERT_SUCCEEDED(DeviceD3D12->CreateDescriptorHeap(&HeapDesc, MY_IID_PPV_ARGS(&pd3d12DescriptorHeap)));
@@ -57,7 +57,7 @@ namespace LearnRenderer
         m_HeapDesc{ pd3d12DescriptorHeap->GetDesc() },
         m_DescriptorSize{ DeviceD3D12->GetDescriptorHandleIncrementSize(m_HeapDesc.Type) },
         m_NumDescriptorsInAllocation{ NumDescriptors },
-        m_FreeBlockManager{ NumDescriptors },
+        m_FreeBlockManager{ NumDescriptors, VariableSizeAllocationsManager::BackendType::TLSF },
         m_pd3d12DescriptorHeap{ pd3d12DescriptorHeap }
     {
         m_FirstCPUHandle = pd3d12DescriptorHeap->GetCPUDescriptorHandleForHeapStart();
@@ -120,6 +120,12 @@ namespace LearnRenderer
         Allocation.Reset();
     }
 
+    AllocatorStats DescriptorHeapAllocationManager::GetStats()
+    {
+        std::lock_guard<std::mutex> LockGuard(m_FreeBlockManagerMutex);
+        return m_FreeBlockManager.GetStats();
+    }
+
 
 
     //
@@ -263,4 +269,24 @@ namespace LearnRenderer
         m_AvailableHeaps.insert(ManagerId);
     }
 
+    AllocatorStats CPUDescriptorHeap::GetStats()
+    {
+        std::lock_guard<std::mutex> LockGuard(m_HeapPoolMutex);
+
+        AllocatorStats Stats;
+        for (auto& Heap : m_HeapPool)
+        {
+            const AllocatorStats HeapStats = Heap.GetStats();
+            Stats.Capacity += HeapStats.Capacity;
+            Stats.UsedSize += HeapStats.UsedSize;
+            Stats.PaddingSize += HeapStats.PaddingSize;
+            Stats.FreeBlockCount += HeapStats.FreeBlockCount;
+            Stats.LargestFreeBlock = std::max(Stats.LargestFreeBlock, HeapStats.LargestFreeBlock);
+            Stats.AllocationCount += HeapStats.AllocationCount;
+            Stats.FreeCount += HeapStats.FreeCount;
+        }
+        Stats.PeakUsedSize = m_MaxSize;
+        return Stats;
+    }
+
 }
\ No newline at end of file
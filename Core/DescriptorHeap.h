@@ -218,7 +218,8 @@ namespace LearnRenderer
     };
 
     // The class performs suballocations within one D3D12 descriptor heap.
-    // It uses VariableSizeAllocationsManager to manage free space in the heap
+    // It uses VariableSizeAllocationsManager with the TLSF backend to manage free space in the heap, so that
+    // allocating and freeing descriptors takes constant time and does not allocate memory
     //
     // |  X  X  X  X  O  O  O  X  X  O  O  X  O  O  O  O  |  D3D12 descriptor heap
     //
@@ -290,6 +291,9 @@ namespace LearnRenderer
         size_t GetMaxAllocatedSize()       const { return m_MaxAllocatedSize; }
         // clang-format on
 
+        // In descriptors
+        AllocatorStats GetStats();
+
     private:
         IDescriptorAllocator& m_ParentAllocator;
         ID3D12Device*         m_DeviceD3D12;
@@ -365,6 +369,9 @@ namespace LearnRenderer
         virtual void                     Free(DescriptorHeapAllocation&& Allocation) override final;
         virtual UINT32                   GetDescriptorSize() const override final { return m_DescriptorSize; }
 
+        // In descriptors, summed over the pool of descriptor heaps
+        AllocatorStats GetStats();
+
     private:
         void FreeAllocation(DescriptorHeapAllocation&& Allocation);
 
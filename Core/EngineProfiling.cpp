@@ -22,6 +22,7 @@
 #include <vector>
 #include <unordered_map>
 #include <array>
+#include <mutex>
 
 using namespace Graphics;
 using namespace GraphRenderer;
@@ -425,7 +426,31 @@ namespace EngineProfiling
     BoolVar DrawProfiler("Display Profiler", false);
     //BoolVar DrawPerfGraph("Display Performance Graph", false);
     const bool DrawPerfGraph = false;
-    
+    BoolVar DrawAllocatorStats("Display Allocator Stats", false);
+
+    struct RegisteredAllocator
+    {
+        const void* Allocator;
+        wstring Name;
+        function<AllocatorStats()> GetStats;
+        AllocatorStats LastStats;
+    };
+
+    mutex AllocatorMutex;
+    vector<RegisteredAllocator> Allocators;
+
+    void SampleAllocators( void )
+    {
+        lock_guard<mutex> Guard(AllocatorMutex);
+        for (auto& Entry : Allocators)
+        {
+            AllocatorStats Stats = Entry.GetStats();
+            Stats.FrameAllocationCount = Stats.AllocationCount - Entry.LastStats.AllocationCount;
+            Stats.FrameFreeCount = Stats.FreeCount - Entry.LastStats.FreeCount;
+            Entry.LastStats = Stats;
+        }
+    }
+
     void Update( void )
     {
         if (GameInput::IsFirstPressed( GameInput::kStartButton ) 
@@ -434,6 +459,55 @@ namespace EngineProfiling
             Paused = !Paused;
         }
         NestedTimingTree::UpdateTimes();
+        SampleAllocators();
+    }
+
+    void RegisterAllocator(const void* Allocator, const wstring& Name, function<AllocatorStats()> GetStats)
+    {
+        lock_guard<mutex> Guard(AllocatorMutex);
+        RegisteredAllocator Entry{ Allocator, Name, std::move(GetStats) };
+        Entry.LastStats = Entry.GetStats();
+        Allocators.push_back(std::move(Entry));
+    }
+
+    void UnregisterAllocator(const void* Allocator)
+    {
+        lock_guard<mutex> Guard(AllocatorMutex);
+        Allocators.erase(remove_if(Allocators.begin(), Allocators.end(),
+            [Allocator](const RegisteredAllocator& Entry) { return Entry.Allocator == Allocator; }), Allocators.end());
+    }
+
+    vector<pair<wstring, AllocatorStats>> GetAllocatorStats()
+    {
+        lock_guard<mutex> Guard(AllocatorMutex);
+        vector<pair<wstring, AllocatorStats>> Stats;
+        Stats.reserve(Allocators.size());
+        for (auto& Entry : Allocators)
+            Stats.emplace_back(Entry.Name, Entry.LastStats);
+        return Stats;
+    }
+
+    bool DumpAllocatorStats(const wstring& FilePath)
+    {
+        FILE* File = nullptr;
+        if (_wfopen_s(&File, FilePath.c_str(), L"wb") != 0 || File == nullptr)
+            return false;
+
+        fprintf(File, "allocator,capacity,used,peak,padding,pending,free blocks,largest free block,"
+            "internal fragmentation,external fragmentation,allocations,frees,frame allocations,frame frees\r\n");
+        for (auto& Entry : GetAllocatorStats())
+        {
+            const AllocatorStats& Stats = Entry.second;
+            fprintf(File, "\"%s\",%zu,%zu,%zu,%zu,%zu,%zu,%zu,%.4f,%.4f,%llu,%llu,%llu,%llu\r\n",
+                Utility::WideStringToUTF8(Entry.first).c_str(), Stats.Capacity, Stats.UsedSize, Stats.PeakUsedSize,
+                Stats.PaddingSize, Stats.PendingFreeSize, Stats.FreeBlockCount, Stats.LargestFreeBlock,
+                Stats.InternalFragmentation(), Stats.ExternalFragmentation(),
+                (unsigned long long)Stats.AllocationCount, (unsigned long long)Stats.FreeCount,
+                (unsigned long long)Stats.FrameAllocationCount, (unsigned long long)Stats.FrameFreeCount);
+        }
+
+        fclose(File);
+        return true;
     }
 
     void BeginBlock(const wstring& name, CommandContext* Context)
@@ -493,6 +567,27 @@ namespace EngineProfiling
             NestedTimingTree::Display( Text, x );
         }
 
+        if (DrawAllocatorStats)
+        {
+            Text.SetColor( Color(0.5f, 1.0f, 1.0f) );
+            Text.DrawString("Allocators");
+            Text.NewLine();
+            Text.SetTextSize(20.0f);
+            Text.SetColor( Color(1.0f, 1.0f, 1.0f) );
+
+            for (auto& Entry : GetAllocatorStats())
+            {
+                // The name has no length limit, so it is drawn on its own: DrawFormattedString() formats into 256
+                // characters, which the numbers alone stay well under.
+                const AllocatorStats& Stats = Entry.second;
+                Text.DrawString(Entry.first + L": ");
+                Text.DrawFormattedString("%zu / %zu (peak %zu), %zu free blocks, largest %zu, frag %.2f int %.2f ext, %llu+ %llu-\n",
+                    Stats.UsedSize, Stats.Capacity, Stats.PeakUsedSize, Stats.FreeBlockCount, Stats.LargestFreeBlock,
+                    Stats.InternalFragmentation(), Stats.ExternalFragmentation(),
+                    (unsigned long long)Stats.FrameAllocationCount, (unsigned long long)Stats.FrameFreeCount);
+            }
+        }
+
         Text.GetCommandContext().SetScissor(0, 0, g_DisplayWidth, g_DisplayHeight);
     }
 
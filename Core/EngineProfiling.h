@@ -14,7 +14,10 @@
 #pragma once
 
 #include <string>
+#include <vector>
+#include <functional>
 #include "TextRenderer.h"
+#include "AllocatorStats.h"
 
 class CommandContext;
 
@@ -29,6 +32,17 @@ namespace EngineProfiling
     void DisplayPerfGraph(GraphicsContext& Text);
     void Display(TextContext& Text, float x, float y, float w, float h);
     bool IsPaused();
+
+    // Allocators registered here are sampled once per frame by Update(). Allocator is only a key; GetStats is
+    // called from the thread calling Update() and must stay valid until the allocator is unregistered.
+    void RegisterAllocator(const void* Allocator, const std::wstring& Name, std::function<AllocatorStats()> GetStats);
+    void UnregisterAllocator(const void* Allocator);
+
+    // The statistics of every registered allocator as of the last Update()
+    std::vector<std::pair<std::wstring, AllocatorStats>> GetAllocatorStats();
+
+    // Writes the last sample as CSV, one line per allocator, to size heaps from real runs
+    bool DumpAllocatorStats(const std::wstring& FilePath);
 }
 
 #ifdef RELEASE
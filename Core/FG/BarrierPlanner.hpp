@@ -0,0 +1,399 @@
+#pragma once
+#ifndef FG_BARRIER_PLANNER_HPP_
+#define FG_BARRIER_PLANNER_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "ResourceAccess.hpp"
+
+namespace FG
+{
+	constexpr auto kNoStep = static_cast<std::size_t>(-1);
+
+	struct ResourceUse
+	{
+		std::size_t       resource;
+		ResourceAccess    access;
+		SubresourceRange  range = SubresourceRange();
+	};
+
+	struct PlannedBarrier
+	{
+		std::size_t     resource;
+		ResourceAccess  before; // None when the planner does not know the state, e.g. on first use.
+		ResourceAccess  after;
+		BarrierPhase    phase;
+		std::size_t       previousStep = kNoStep; // The step that used the resource last, if any.
+		SubresourceRange  range = SubresourceRange();
+	};
+
+	struct BarrierStats
+	{
+		std::size_t emitted = 0; // Transitions and UAV barriers recorded.
+		std::size_t avoided = 0; // Tracked uses that needed no barrier, e.g. repeated reads in the same state.
+		std::size_t split   = 0; // Emitted transitions split across steps that do not touch the resource.
+
+		BarrierStats& operator+=(const BarrierStats& that)
+		{
+			emitted += that.emitted;
+			avoided += that.avoided;
+			split   += that.split;
+			return *this;
+		}
+	};
+
+	struct StepBarriers
+	{
+		std::vector<PlannedBarrier> before; // Full and End barriers, batched ahead of the pass.
+		std::vector<PlannedBarrier> after;  // Begin halves of split barriers, recorded once the pass is done.
+		std::vector<PlannedBarrier> handoff; // Transitions the step's queue cannot record, recorded on the graphics queue ahead of it.
+	};
+
+	struct BarrierPlan
+	{
+		std::vector<StepBarriers>    steps; // Parallel to the steps passed in.
+		BarrierStats                 stats;
+		std::vector<ResourceAccess>  states; // Per resource, or subresource: the state the plan leaves it in, None when unknown.
+		std::vector<std::size_t>     lastSteps; // Per resource, or subresource: the step that used it last, if any.
+	};
+
+	// Collapses the uses of each resource range within one step into a single use: reads combine, a write replaces them.
+	inline void MergeResourceUses(const std::vector<ResourceUse>& uses, std::vector<ResourceUse>& merged)
+	{
+		merged.clear();
+		for (auto& use : uses)
+		{
+			auto iteratee = merged.begin();
+			while (iteratee != merged.end() && (iteratee->resource != use.resource || iteratee->range != use.range))
+				++iteratee;
+			if (iteratee == merged.end())
+			{
+				merged.push_back(use);
+				continue;
+			}
+
+			if (IsWriteAccess(use.access))
+				iteratee->access = use.access;
+			else if (!IsWriteAccess(iteratee->access))
+				iteratee->access = iteratee->access | use.access;
+		}
+	}
+
+	// Computes the transitions needed to give every step the access it declared, in step order, after merging the uses
+	// within each step. Resources are tracked as a whole; see PlanSubresourceBarriers() for ranges. When the previous use of a resource is more than one step away the transition is split, so the
+	// GPU can overlap it with the steps in between. Untracked uses (ResourceAccess::None) emit nothing but make the state
+	// unknown to the following use.
+	// Steps may run on other queues than graphics (stepQueues, empty for all graphics). Barriers are never split across
+	// queues, and a transition the step's queue cannot record is appended to the previous use when that ran on the
+	// graphics queue, or handed off to the graphics queue right before the step otherwise. Both halves of a split
+	// barrier go into one command list, so neither is it split across the submission batches of the steps
+	// (stepBatches, empty for one batch).
+	inline BarrierPlan PlanBarriers(const std::size_t resourceCount, const std::vector<std::vector<ResourceUse>>& steps, const bool splitBarriers = true, const std::vector<QueueType>& stepQueues = {}, const std::vector<std::size_t>& stepBatches = {})
+	{
+		const auto queueOf = [&stepQueues](const std::size_t step)
+		{
+			return step < stepQueues.size() ? stepQueues[step] : QueueType::Graphics;
+		};
+		const auto batchOf = [&stepBatches](const std::size_t step)
+		{
+			return step < stepBatches.size() ? stepBatches[step] : 0;
+		};
+
+		BarrierPlan plan;
+		plan.steps.resize(steps.size());
+
+		std::vector<ResourceAccess> states(resourceCount, ResourceAccess::None);
+		std::vector<std::size_t> lastSteps(resourceCount, kNoStep);
+		std::vector<ResourceUse> uses;
+		for (std::size_t step = 0; step < steps.size(); ++step)
+		{
+			MergeResourceUses(steps[step], uses);
+			for (auto& use : uses)
+			{
+				const auto resource = use.resource;
+				const auto before = states[resource];
+				const auto after = use.access;
+				const auto lastStep = lastSteps[resource];
+				lastSteps[resource] = step;
+				states[resource] = after;
+
+				if (after == ResourceAccess::None)
+					continue;
+
+				if (before != ResourceAccess::None && !IsWriteAccess(before) && !IsWriteAccess(after) && (before & after) == after)
+				{
+					states[resource] = before; // Already in a read state covering this use.
+					plan.stats.avoided++;
+					continue;
+				}
+				if (before == after && after != ResourceAccess::UnorderedAccess)
+				{
+					plan.stats.avoided++;
+					continue;
+				}
+
+				plan.stats.emitted++;
+				const auto queue = queueOf(step);
+				if (!QueueSupportsAccess(queue, before) || !QueueSupportsAccess(queue, after))
+				{
+					if (lastStep != kNoStep && queueOf(lastStep) == QueueType::Graphics)
+						plan.steps[lastStep].after.push_back(PlannedBarrier{ resource, before, after, BarrierPhase::Full, lastStep });
+					else
+						plan.steps[step].handoff.push_back(PlannedBarrier{ resource, before, after, BarrierPhase::Full, lastStep });
+				}
+				else if (splitBarriers && before != ResourceAccess::None && before != after && lastStep + 1 < step && queueOf(lastStep) == queue && batchOf(lastStep) == batchOf(step))
+				{
+					plan.steps[lastStep].after.push_back(PlannedBarrier{ resource, before, after, BarrierPhase::Begin, lastStep });
+					plan.steps[step].before.push_back(PlannedBarrier{ resource, before, after, BarrierPhase::End, lastStep });
+					plan.stats.split++;
+				}
+				else
+					plan.steps[step].before.push_back(PlannedBarrier{ resource, before, after, BarrierPhase::Full, lastStep });
+			}
+		}
+
+		plan.states = std::move(states);
+		plan.lastSteps = std::move(lastSteps);
+		return plan;
+	}
+
+	// Numbers the subresources of all resources consecutively: those of a resource follow each other from its offset
+	// on, mips first, so a subresource can stand in for a resource in the planners.
+	struct SubresourceIndexing
+	{
+		std::vector<SubresourceLayout>  layouts;
+		std::vector<std::size_t>        offsets; // Per resource, followed by the number of subresources.
+
+		std::size_t Count() const
+		{
+			return offsets.back();
+		}
+		std::size_t Index(const std::size_t resource, const std::uint32_t mip, const std::uint32_t slice) const
+		{
+			return offsets[resource] + std::size_t(slice) * layouts[resource].mipCount + mip;
+		}
+		std::size_t Resource(const std::size_t index) const
+		{
+			return std::size_t(std::upper_bound(offsets.begin(), offsets.end(), index) - offsets.begin()) - 1;
+		}
+	};
+
+	inline SubresourceIndexing IndexSubresources(const std::vector<SubresourceLayout>& layouts)
+	{
+		SubresourceIndexing indexing{ layouts, std::vector<std::size_t>(1, 0) };
+		for (auto& layout : layouts)
+			indexing.offsets.push_back(indexing.offsets.back() + std::size_t(layout.mipCount) * layout.sliceCount);
+		return indexing;
+	}
+
+	// Rewrites the uses of resource ranges into uses of the subresources they cover. The state of a resource is only
+	// known per subresource from its first tracked use on: that use is widened to the whole resource, and an untracked
+	// use, after which the pass may have transitioned any of it, stands for the whole resource as well.
+	inline std::vector<std::vector<ResourceUse>> ExpandSubresourceUses(const SubresourceIndexing& indexing, const std::vector<std::vector<ResourceUse>>& steps)
+	{
+		std::vector<bool> known(indexing.layouts.size(), false);
+		std::vector<std::vector<ResourceUse>> expanded(steps.size());
+		for (std::size_t step = 0; step < steps.size(); ++step)
+		{
+			for (auto& use : steps[step])
+			{
+				const auto& layout = indexing.layouts[use.resource];
+				auto range = use.range;
+				if (use.access == ResourceAccess::None || !known[use.resource])
+					range = SubresourceRange();
+				known[use.resource] = use.access != ResourceAccess::None;
+
+				for (auto slice = range.firstSlice; slice < std::min(range.SliceEnd(), layout.sliceCount); ++slice)
+					for (auto mip = range.firstMip; mip < std::min(range.MipEnd(), layout.mipCount); ++mip)
+						expanded[step].push_back(ResourceUse{ indexing.Index(use.resource, mip, slice), use.access });
+			}
+		}
+		return expanded;
+	}
+
+	// Plans the barriers of subresource uses from ExpandSubresourceUses(), so uses of disjoint ranges of a resource
+	// leave each other alone, then merges the barriers of neighbouring subresources back into ranges of the resources;
+	// a range covering a whole resource becomes All(). Outside the plan a resource has a single state, so a resource
+	// left in differing states is brought to the state of its last use after the last use of each subresource,
+	// unless the queues involved cannot record that. Wherever transitions of ranges bring all of a resource to one
+	// state, a Settled barrier follows them.
+	inline BarrierPlan PlanSubresourceBarriers(const SubresourceIndexing& indexing, const std::vector<std::vector<ResourceUse>>& steps, const bool splitBarriers = true, const std::vector<QueueType>& stepQueues = {}, const std::vector<std::size_t>& stepBatches = {})
+	{
+		const auto queueOf = [&stepQueues](const std::size_t step)
+		{
+			return step < stepQueues.size() ? stepQueues[step] : QueueType::Graphics;
+		};
+		const auto sameTransition = [](const PlannedBarrier& lhs, const PlannedBarrier& rhs)
+		{
+			return lhs.resource == rhs.resource && lhs.before == rhs.before && lhs.after == rhs.after && lhs.phase == rhs.phase && lhs.previousStep == rhs.previousStep;
+		};
+
+		auto plan = PlanBarriers(indexing.Count(), steps, splitBarriers, stepQueues, stepBatches);
+
+		for (std::size_t resource = 0; resource < indexing.layouts.size(); ++resource)
+		{
+			const auto first = indexing.offsets[resource];
+			const auto end = indexing.offsets[resource + 1];
+			if (std::any_of(plan.states.begin() + first, plan.states.begin() + end, [](const ResourceAccess state) { return state == ResourceAccess::None; }) ||
+				std::all_of(plan.states.begin() + first, plan.states.begin() + end, [&plan, first](const ResourceAccess state) { return state == plan.states[first]; }))
+				continue;
+
+			// Candidates in order of preference: the state of the last use first, then the others.
+			auto last = first;
+			for (auto index = first; index < end; ++index)
+				if (plan.lastSteps[index] > plan.lastSteps[last])
+					last = index;
+			std::vector<ResourceAccess> targets(1, plan.states[last]);
+			for (auto index = first; index < end; ++index)
+				if (std::find(targets.begin(), targets.end(), plan.states[index]) == targets.end())
+					targets.push_back(plan.states[index]);
+
+			for (auto target : targets)
+			{
+				const auto recordable = [&](const std::size_t index)
+				{
+					const auto queue = queueOf(plan.lastSteps[index]);
+					return plan.states[index] == target || (QueueSupportsAccess(queue, plan.states[index]) && QueueSupportsAccess(queue, target));
+				};
+				bool feasible = true;
+				for (auto index = first; index < end && feasible; ++index)
+					feasible = recordable(index);
+				if (!feasible)
+					continue;
+
+				for (auto index = first; index < end; ++index)
+				{
+					if (plan.states[index] == target)
+						continue;
+					const auto step = plan.lastSteps[index];
+					plan.steps[step].after.push_back(PlannedBarrier{ index, plan.states[index], target, BarrierPhase::Full, step });
+					plan.states[index] = target;
+				}
+				break;
+			}
+		}
+
+		for (auto& barriers : plan.steps)
+		{
+			for (auto list : { &barriers.before, &barriers.after, &barriers.handoff })
+			{
+				// Runs of mips within a slice first, then runs of slices covering the same mips.
+				std::vector<PlannedBarrier> rows;
+				for (auto barrier : *list)
+				{
+					const auto resource = indexing.Resource(barrier.resource);
+					const auto local = barrier.resource - indexing.offsets[resource];
+					const auto mip = std::uint32_t(local % indexing.layouts[resource].mipCount);
+					const auto slice = std::uint32_t(local / indexing.layouts[resource].mipCount);
+					barrier.resource = resource;
+					barrier.range = SubresourceRange{ mip, 1, slice, 1 };
+
+					if (!rows.empty() && sameTransition(rows.back(), barrier) && rows.back().range.firstSlice == slice && rows.back().range.MipEnd() == mip)
+						rows.back().range.mipCount++;
+					else
+						rows.push_back(barrier);
+				}
+
+				list->clear();
+				for (auto& row : rows)
+				{
+					if (!list->empty() && sameTransition(list->back(), row) && list->back().range.firstMip == row.range.firstMip &&
+						list->back().range.mipCount == row.range.mipCount && list->back().range.SliceEnd() == row.range.firstSlice)
+						list->back().range.sliceCount++;
+					else
+						list->push_back(row);
+				}
+
+				for (auto& barrier : *list)
+				{
+					const auto& layout = indexing.layouts[barrier.resource];
+					if (barrier.range == SubresourceRange{ 0, layout.mipCount, 0, layout.sliceCount })
+						barrier.range = SubresourceRange();
+				}
+
+				// Transitions from an unknown state rely on the single state the resource has outside the plan, so when
+				// a widened first use leaves parts of a resource in different states, the whole resource is transitioned
+				// to the first of them and the other parts on from there.
+				for (std::size_t i = 0; i < list->size(); ++i)
+				{
+					const auto& unknown = (*list)[i];
+					if (unknown.before != ResourceAccess::None || unknown.range.All())
+						continue;
+
+					const auto resource = unknown.resource;
+					const auto state = unknown.after;
+					(*list)[i].range = SubresourceRange();
+					for (auto j = i + 1; j < list->size(); )
+					{
+						auto& barrier = (*list)[j];
+						if (barrier.resource != resource || barrier.before != ResourceAccess::None)
+							++j;
+						else if (barrier.after == state)
+							list->erase(list->begin() + j);
+						else
+						{
+							barrier.before = state;
+							++j;
+						}
+					}
+				}
+			}
+		}
+
+		// Follows the state of every subresource through the lists in the order they are recorded in. A transition that
+		// is not All() leaves the resource unsettled until the whole of it is in one state again.
+		std::vector<ResourceAccess> states(indexing.Count(), ResourceAccess::None);
+		std::vector<bool> unsettled(indexing.layouts.size(), false);
+		std::vector<std::size_t> touched;
+		for (auto& barriers : plan.steps)
+		{
+			for (auto list : { &barriers.handoff, &barriers.before, &barriers.after })
+			{
+				touched.clear();
+				for (auto& barrier : *list)
+				{
+					if (barrier.phase == BarrierPhase::Begin)
+						continue;
+
+					const auto& layout = indexing.layouts[barrier.resource];
+					for (auto slice = barrier.range.firstSlice; slice < std::min(barrier.range.SliceEnd(), layout.sliceCount); ++slice)
+						for (auto mip = barrier.range.firstMip; mip < std::min(barrier.range.MipEnd(), layout.mipCount); ++mip)
+							states[indexing.Index(barrier.resource, mip, slice)] = barrier.after;
+					unsettled[barrier.resource] = !barrier.range.All();
+					touched.push_back(barrier.resource);
+				}
+
+				for (auto resource : touched)
+				{
+					const auto first = states.begin() + indexing.offsets[resource];
+					const auto end = states.begin() + indexing.offsets[resource + 1];
+					if (!unsettled[resource] || *first == ResourceAccess::None || std::any_of(first, end, [first](const ResourceAccess state) { return state != *first; }))
+						continue;
+
+					list->push_back(PlannedBarrier{ resource, ResourceAccess::None, *first, BarrierPhase::Settled });
+					unsettled[resource] = false;
+				}
+			}
+		}
+
+		// Counted again after merging, one per recorded transition; avoided uses stay counted per subresource.
+		plan.stats.emitted = 0;
+		plan.stats.split = 0;
+		for (auto& barriers : plan.steps)
+		{
+			for (auto list : { &barriers.before, &barriers.after, &barriers.handoff })
+			{
+				for (auto& barrier : *list)
+				{
+					plan.stats.emitted += barrier.phase != BarrierPhase::Begin && barrier.phase != BarrierPhase::Settled ? 1 : 0;
+					plan.stats.split += barrier.phase == BarrierPhase::End ? 1 : 0;
+				}
+			}
+		}
+		return plan;
+	}
+}
+
+#endif
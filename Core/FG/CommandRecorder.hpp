@@ -0,0 +1,42 @@
+#pragma once
+#ifndef FG_COMMAND_RECORDER_HPP_
+#define FG_COMMAND_RECORDER_HPP_
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "ResourceAccess.hpp"
+
+namespace FG
+{
+	// Hands out the command contexts the framegraph records passes into, and submits them.
+	class CommandRecorder
+	{
+	public:
+		CommandRecorder() = default;
+		CommandRecorder(const CommandRecorder& that) = delete;
+		CommandRecorder(CommandRecorder&& temp) = default;
+		virtual ~CommandRecorder() = default;
+		CommandRecorder& operator=(const CommandRecorder& that) = delete;
+		CommandRecorder& operator=(CommandRecorder&& temp) = default;
+
+		virtual CommandContext& Begin(const std::string& name, QueueType queue) = 0;
+		// Submits the recorded work to the queue it was begun for and returns the fence that signals its completion.
+		virtual std::uint64_t Finish(CommandContext& context) = 0;
+		// Makes the queue wait on the GPU, without blocking the CPU, until a fence from another queue has completed.
+		// Applies to the work submitted to the queue from then on.
+		virtual void Wait(QueueType queue, std::uint64_t fence) = 0;
+		// Bracket the commands of a pass in its context, e.g. for GPU timing. Called on the thread recording the context.
+		virtual void BeginPass(CommandContext&, std::string_view, QueueType)
+		{
+
+		}
+		virtual void EndPass(CommandContext&, QueueType)
+		{
+
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,187 @@
+#pragma once
+#ifndef FG_DEPENDENCY_GRAPH_HPP_
+#define FG_DEPENDENCY_GRAPH_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <vector>
+
+namespace FG
+{
+	enum class DependencyKind : std::uint8_t
+	{
+		ReadAfterWrite,  // The pass reads a version the other one wrote.
+		WriteAfterRead,  // The pass writes over a version the other one reads.
+		WriteAfterWrite, // The pass writes over a version the other one wrote.
+	};
+
+	struct DependencyEdge
+	{
+		std::size_t     from; // Pass index, runs first.
+		std::size_t     to;   // Pass index.
+		DependencyKind  kind;
+	};
+
+	// Successors and in-degrees of the passes that are not excluded, ignoring edges to and from excluded passes.
+	inline void CountEdges(const std::size_t passCount, const std::vector<DependencyEdge>& edges, const std::vector<bool>& excluded, std::vector<std::vector<std::size_t>>& successors, std::vector<std::size_t>& inDegrees)
+	{
+		successors.assign(passCount, std::vector<std::size_t>());
+		inDegrees.assign(passCount, 0);
+		for (auto& edge : edges)
+		{
+			if (excluded[edge.from] || excluded[edge.to] || edge.from == edge.to)
+				continue;
+			successors[edge.from].push_back(edge.to);
+			inDegrees[edge.to]++;
+		}
+	}
+
+	// Orders the passes that are not excluded so that every edge between them points forward. Among the passes that
+	// are ready the one declared first goes first, so edges that already point forward keep the declaration order.
+	// Passes on a cycle, and passes depending on them, are left out; FrameGraph::Compile() reports them.
+	inline std::vector<std::size_t> TopologicalOrder(const std::size_t passCount, const std::vector<DependencyEdge>& edges, const std::vector<bool>& excluded)
+	{
+		std::vector<std::vector<std::size_t>> successors;
+		std::vector<std::size_t> inDegrees;
+		CountEdges(passCount, edges, excluded, successors, inDegrees);
+
+		std::priority_queue<std::size_t, std::vector<std::size_t>, std::greater<std::size_t>> ready;
+		for (std::size_t pass = 0; pass < passCount; ++pass)
+			if (!excluded[pass] && inDegrees[pass] == 0)
+				ready.push(pass);
+
+		std::vector<std::size_t> order;
+		while (!ready.empty())
+		{
+			const auto pass = ready.top();
+			ready.pop();
+			order.push_back(pass);
+			for (auto successor : successors[pass])
+				if (--inDegrees[successor] == 0)
+					ready.push(successor);
+		}
+		return order;
+	}
+
+	// A transient as pass ordering sees it: alive from the first of its passes to run through the last one.
+	struct TransientUsers
+	{
+		std::size_t               size = 0;
+		std::vector<std::size_t>  passes; // Each pass once, the creator included.
+	};
+
+	struct PassOrderStats
+	{
+		std::size_t declarationPeak = 0; // Most bytes of transients alive at once in declaration order.
+		std::size_t scheduledPeak   = 0; // The same in the order compiled.
+	};
+
+	// The most bytes of transients alive at once when the passes run in order. Passes missing from order do not count
+	// as users.
+	inline std::size_t PeakLiveBytes(const std::size_t passCount, const std::vector<std::size_t>& order, const std::vector<TransientUsers>& transients)
+	{
+		constexpr auto kUnordered = static_cast<std::size_t>(-1);
+		std::vector<std::size_t> positions(passCount, kUnordered);
+		for (std::size_t i = 0; i < order.size(); ++i)
+			positions[order[i]] = i;
+
+		std::vector<std::size_t> started(order.size(), 0);
+		std::vector<std::size_t> ended(order.size(), 0);
+		for (auto& transient : transients)
+		{
+			auto first = kUnordered;
+			std::size_t last = 0;
+			for (auto pass : transient.passes)
+			{
+				if (positions[pass] == kUnordered)
+					continue;
+				first = std::min(first, positions[pass]);
+				last = std::max(last, positions[pass]);
+			}
+			if (first == kUnordered)
+				continue;
+			started[first] += transient.size;
+			ended[last] += transient.size;
+		}
+
+		std::size_t live = 0;
+		std::size_t peak = 0;
+		for (std::size_t i = 0; i < order.size(); ++i)
+		{
+			live += started[i];
+			peak = std::max(peak, live);
+			live -= ended[i];
+		}
+		return peak;
+	}
+
+	// Orders the passes like TopologicalOrder(), except that among the ready passes it picks the one adding the fewest
+	// bytes to the live transients: those it is the first user of, less those it is the last user of. Ties go to the
+	// pass declared first, so the order only depends on the graph. Being greedy it may still end up with a higher peak
+	// than the declaration order; compare with PeakLiveBytes() before using it.
+	inline std::vector<std::size_t> MemoryAwareOrder(const std::size_t passCount, const std::vector<DependencyEdge>& edges, const std::vector<bool>& excluded, const std::vector<TransientUsers>& transients)
+	{
+		std::vector<std::vector<std::size_t>> successors;
+		std::vector<std::size_t> inDegrees;
+		CountEdges(passCount, edges, excluded, successors, inDegrees);
+
+		std::vector<std::vector<std::size_t>> passTransients(passCount);
+		std::vector<std::size_t> remainingUsers(transients.size(), 0);
+		std::vector<bool> alive(transients.size(), false);
+		for (std::size_t transient = 0; transient < transients.size(); ++transient)
+		{
+			for (auto pass : transients[transient].passes)
+			{
+				if (excluded[pass])
+					continue;
+				passTransients[pass].push_back(transient);
+				remainingUsers[transient]++;
+			}
+		}
+
+		std::vector<std::size_t> ready;
+		for (std::size_t pass = 0; pass < passCount; ++pass)
+			if (!excluded[pass] && inDegrees[pass] == 0)
+				ready.push_back(pass);
+
+		std::vector<std::size_t> order;
+		while (!ready.empty())
+		{
+			auto best = ready.begin();
+			std::int64_t bestGrowth = 0;
+			for (auto candidate = ready.begin(); candidate != ready.end(); ++candidate)
+			{
+				std::int64_t growth = 0;
+				for (auto transient : passTransients[*candidate])
+				{
+					const auto size = std::int64_t(transients[transient].size);
+					growth += alive[transient] ? 0 : size;
+					growth -= remainingUsers[transient] == 1 ? size : 0;
+				}
+				if (candidate == ready.begin() || growth < bestGrowth || (growth == bestGrowth && *candidate < *best))
+				{
+					best = candidate;
+					bestGrowth = growth;
+				}
+			}
+
+			const auto pass = *best;
+			ready.erase(best);
+			order.push_back(pass);
+			for (auto transient : passTransients[pass])
+			{
+				alive[transient] = true;
+				remainingUsers[transient]--;
+			}
+			for (auto successor : successors[pass])
+				if (--inDegrees[successor] == 0)
+					ready.push_back(successor);
+		}
+		return order;
+	}
+}
+
+#endif
@@ -0,0 +1,42 @@
+#pragma once
+#ifndef FG_DESCRIPTION_HASH_HPP_
+#define FG_DESCRIPTION_HASH_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace FG
+{
+	inline std::size_t HashCombine(const std::size_t seed, const std::size_t value)
+	{
+		return seed ^ (value + std::size_t(0x9e3779b9) + (seed << 6) + (seed >> 2));
+	}
+
+	inline std::size_t HashBytes(const void* data, const std::size_t size) // FNV-1a.
+	{
+		auto bytes = static_cast<const unsigned char*>(data);
+		std::uint64_t hash = 14695981039346656037ull;
+		for (std::size_t i = 0; i < size; ++i)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+		return std::size_t(hash);
+	}
+
+	template<typename _DescriptionType>
+	struct MissingHashDescriptionImplementation : std::false_type {};
+
+	// Descriptions without padding are hashed bytewise. Anything else (padding, pointers, strings) needs a specialization
+	// that hashes the members one by one, otherwise equal descriptions could hash differently.
+	template<typename _DescriptionType>
+	std::size_t HashDescription(const _DescriptionType& description)
+	{
+		static_assert(std::has_unique_object_representations<_DescriptionType>::value || MissingHashDescriptionImplementation<_DescriptionType>::value,
+			"Missing hash implementation for a description that is not bytewise comparable.");
+		return HashBytes(&description, sizeof(description));
+	}
+}
+
+#endif
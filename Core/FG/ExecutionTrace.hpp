@@ -0,0 +1,109 @@
+#pragma once
+#ifndef FG_EXECUTION_TRACE_HPP_
+#define FG_EXECUTION_TRACE_HPP_
+
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+#include "ResourceAccess.hpp"
+
+namespace FG
+{
+	using TraceClock = std::chrono::steady_clock;
+
+	// A stretch of CPU time, empty when nothing ran.
+	struct TraceSpan
+	{
+		TraceClock::time_point  begin;
+		TraceClock::time_point  end;
+
+		bool Empty() const
+		{
+			return begin == end;
+		}
+		double Milliseconds() const
+		{
+			return std::chrono::duration<double, std::milli>(end - begin).count();
+		}
+	};
+
+	// Where the CPU time of a step went in the last Execute().
+	struct StepTiming
+	{
+		TraceSpan    realize;    // Realizing the transients the step creates.
+		TraceSpan    record;     // Running the pass.
+		TraceSpan    submit;     // Submitting the batch the step ends, waits on other queues included.
+		TraceSpan    derealize;  // Releasing the transients the step used last, after its batch was submitted.
+		std::size_t  thread = 0; // The worker that ran the pass, 0 for the calling thread.
+	};
+
+	struct ResourceTiming
+	{
+		TraceSpan  realize;
+		TraceSpan  derealize;
+	};
+
+	struct ExecutionTimes
+	{
+		double realizeMs   = 0.0;
+		double recordMs    = 0.0;
+		double submitMs    = 0.0;
+		double derealizeMs = 0.0;
+		double totalMs     = 0.0; // The whole Execute(), everything the steps do not account for included.
+	};
+
+	inline ExecutionTimes SumStepTimings(const std::vector<StepTiming>& timings, const TraceSpan& frame)
+	{
+		ExecutionTimes times;
+		for (auto& timing : timings)
+		{
+			times.realizeMs += timing.realize.Milliseconds();
+			times.recordMs += timing.record.Milliseconds();
+			times.submitMs += timing.submit.Milliseconds();
+			times.derealizeMs += timing.derealize.Milliseconds();
+		}
+		times.totalMs = frame.Milliseconds();
+		return times;
+	}
+
+	constexpr const char* QueueName(const QueueType queue)
+	{
+		return queue == QueueType::Compute ? "Compute" : queue == QueueType::Copy ? "Copy" : "Graphics";
+	}
+
+	// Writes name as the contents of a JSON string.
+	inline void WriteJsonString(std::ostream& stream, const std::string_view name)
+	{
+		constexpr char kHexDigits[] = "0123456789abcdef";
+		for (auto c : name)
+		{
+			if (c == '"' || c == '\\')
+				stream << '\\' << c;
+			else if (static_cast<unsigned char>(c) < 0x20)
+				stream << "\\u00" << kHexDigits[(c >> 4) & 0xf] << kHexDigits[c & 0xf];
+			else
+				stream << c;
+		}
+	}
+
+	// Writes a complete event of the Chrome trace event format, as chrome://tracing and Perfetto load it. Times are
+	// in microseconds since origin; the step, its queue and its batch go along as arguments. Empty spans are skipped.
+	inline void WriteTraceEvent(std::ostream& stream, bool& first, const std::string_view name, const char* category, const std::size_t thread, const TraceSpan& span, const TraceClock::time_point origin, const std::size_t step, const QueueType queue, const std::size_t batch)
+	{
+		if (span.Empty())
+			return;
+
+		using Microseconds = std::chrono::duration<double, std::micro>;
+		stream << (first ? "\n" : ",\n") << "{\"name\":\"";
+		WriteJsonString(stream, name);
+		stream << "\",\"cat\":\"" << category << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << thread
+			<< ",\"ts\":" << Microseconds(span.begin - origin).count() << ",\"dur\":" << Microseconds(span.end - span.begin).count()
+			<< ",\"args\":{\"step\":" << step << ",\"queue\":\"" << QueueName(queue) << "\",\"batch\":" << batch << "}}";
+		first = false;
+	}
+}
+
+#endif
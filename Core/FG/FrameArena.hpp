@@ -0,0 +1,128 @@
+#pragma once
+#ifndef FG_FRAME_ARENA_HPP_
+#define FG_FRAME_ARENA_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace FG
+{
+	// A linear allocator for everything a framegraph builds in a frame. Deallocation does nothing; Reset() releases all
+	// of it at once. When a frame overflows the first block, Reset() replaces the blocks with one block as large as
+	// their sum, so a frame that repeats the last one is served from a single block without touching the heap.
+	class FrameArena : public std::pmr::memory_resource
+	{
+	public:
+		explicit FrameArena(const std::size_t blockSize = 64 * 1024) : _blockSize(blockSize), _offset(0), _used(0), _peak(0)
+		{
+
+		}
+		FrameArena(const FrameArena& that) = delete;
+		FrameArena(FrameArena&& temp) = delete;
+		virtual ~FrameArena() = default;
+		FrameArena& operator=(const FrameArena& that) = delete;
+		FrameArena& operator=(FrameArena&& temp) = delete;
+
+		// Releases everything allocated since the last Reset(). Nothing allocated from the arena may be used afterwards.
+		void Reset()
+		{
+			if (_blocks.size() > 1)
+			{
+				std::size_t capacity = 0;
+				for (auto& block : _blocks)
+					capacity += block.size;
+				_blocks.clear();
+				_blocks.push_back(Block{ std::make_unique<std::byte[]>(capacity), capacity });
+			}
+			_offset = 0;
+			_used = 0;
+		}
+
+		std::size_t BytesUsed() const // Since the last Reset().
+		{
+			return _used;
+		}
+		std::size_t PeakBytesUsed() const
+		{
+			return _peak;
+		}
+		std::size_t Capacity() const
+		{
+			std::size_t capacity = 0;
+			for (auto& block : _blocks)
+				capacity += block.size;
+			return capacity;
+		}
+
+	protected:
+		struct Block
+		{
+			std::unique_ptr<std::byte[]>  memory;
+			std::size_t                   size;
+		};
+
+		void* do_allocate(const std::size_t bytes, const std::size_t alignment) override
+		{
+			if (_blocks.empty() || AlignedOffset(_blocks.back(), alignment) + bytes > _blocks.back().size)
+			{
+				const auto size = std::max({ _blockSize, Capacity(), bytes + alignment });
+				_blocks.push_back(Block{ std::make_unique<std::byte[]>(size), size });
+				_offset = 0;
+			}
+
+			auto& block = _blocks.back();
+			const auto offset = AlignedOffset(block, alignment);
+			_offset = offset + bytes;
+			_used += bytes;
+			_peak = std::max(_peak, _used);
+			return block.memory.get() + offset;
+		}
+		void do_deallocate(void*, const std::size_t, const std::size_t) override
+		{
+
+		}
+		bool do_is_equal(const std::pmr::memory_resource& that) const noexcept override
+		{
+			return this == &that;
+		}
+
+		std::size_t AlignedOffset(const Block& block, const std::size_t alignment) const
+		{
+			const auto base = reinterpret_cast<std::uintptr_t>(block.memory.get());
+			return (base + _offset + alignment - 1) / alignment * alignment - base;
+		}
+
+		std::vector<Block>  _blocks;
+		std::size_t         _blockSize;
+		std::size_t         _offset; // Into the last block.
+		std::size_t         _used;
+		std::size_t         _peak;
+	};
+
+	// Destroys an object living in a FrameArena without freeing its memory, which goes with the next Reset().
+	struct ArenaDeleter
+	{
+		template<typename Type>
+		void operator()(Type* object) const
+		{
+			object->~Type();
+		}
+	};
+
+	template<typename Type>
+	using ArenaPtr = std::unique_ptr<Type, ArenaDeleter>;
+
+	template<typename Type, typename... ArgumentTypes>
+	ArenaPtr<Type> MakeArenaObject(FrameArena& arena, ArgumentTypes&&... arguments)
+	{
+		return ArenaPtr<Type>(new (arena.allocate(sizeof(Type), alignof(Type))) Type(std::forward<ArgumentTypes>(arguments)...));
+	}
+}
+
+#endif
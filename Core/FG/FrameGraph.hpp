@@ -3,24 +3,40 @@
 #define FG_FRAMEGRAPH_HPP_
 
 #include <algorithm>
+#include <cstdint>
 #include <fstream>
 #include <iterator>
 #include <memory>
-#include <stack>
+#include <memory_resource>
 #include <string>
+#include <string_view>
 #include <type_traits>
 #include <vector>
 
+#include "BarrierPlanner.hpp"
+#include "CommandRecorder.hpp"
+#include "DependencyGraph.hpp"
+#include "DescriptionHash.hpp"
+#include "ExecutionTrace.hpp"
+#include "FrameArena.hpp"
+#include "QueueScheduler.hpp"
+#include "RecordingScheduler.hpp"
+#include "WorkerPool.hpp"
 #include "FrameGraphPass.hpp"
 #include "FrameGraphBuilder.hpp"
 #include "FrameGraphResource.hpp"
+#include "FrameGraphHistory.hpp"
+#include "TransientAliasing.hpp"
 
 namespace FG
 {
 	class FrameGraph
 	{
 	public:
-		FrameGraph() = default;
+		FrameGraph() : _arena(std::make_unique<FrameArena>())
+		{
+
+		}
 		FrameGraph(const FrameGraph& that) = delete;
 		FrameGraph(FrameGraph&& temp) = default;
 		virtual ~FrameGraph() = default;
@@ -30,8 +46,9 @@ namespace FG
 		template<typename DataType, typename... ArgumentTypes>
 		FrameGraphPass<DataType>* AddRenderPass(ArgumentTypes&&... arguments)
 		{
-			_renderPasses.emplace_back(std::make_unique<FrameGraphPass<DataType>>(arguments...));
+			_renderPasses.emplace_back(MakeArenaObject<FrameGraphPass<DataType>>(*_arena, std::forward<ArgumentTypes>(arguments)..., _arena.get()));
 			auto renderPass = _renderPasses.back().get();
+			renderPass->_index = _renderPasses.size() - 1;
 
 			FrameGraphBuilder builder(this, renderPass);
 			renderPass->Setup(builder);
@@ -39,140 +56,468 @@ namespace FG
 			return static_cast<FG::FrameGraphPass<DataType>*>(renderPass);
 		}
 		template<typename DescriptionType, typename ActualType>
-		FrameGraphResource<DescriptionType, ActualType>* AddRetainedResource(const std::string& name, const DescriptionType& description, ActualType* actual = nullptr)
+		FrameGraphResource<DescriptionType, ActualType>* AddRetainedResource(const std::string_view name, const DescriptionType& description, ActualType* actual = nullptr)
 		{
-			_resources.emplace_back(std::make_unique<FrameGraphResource<DescriptionType, ActualType>>(name, description, actual));
+			_resources.emplace_back(MakeArenaObject<FrameGraphResource<DescriptionType, ActualType>>(*_arena, name, description, actual, _arena.get()));
+			_resources.back()->_index = _resources.size() - 1;
 			return static_cast<FrameGraphResource<DescriptionType, ActualType>*>(_resources.back().get());
 		}
-		void Compile()
+		// Imports a resource that survives into the next frame. The framegraph keeps count actuals across Clear(), which
+		// moves on to the next one, so passes write this frame's content through current and read last frame's through
+		// previous. A different description or count than last time starts the history over.
+		template<typename DescriptionType, typename ActualType>
+		HistoryResource<FrameGraphResource<DescriptionType, ActualType>> AddHistoryResource(const std::string_view name, const DescriptionType& description, const std::size_t count = 2)
+		{
+			using HistoryType = FrameGraphHistory<DescriptionType, ActualType>;
+
+			auto iteratee = std::find_if(_histories.begin(), _histories.end(), [name](const std::unique_ptr<FrameGraphHistoryBase>& history) { return history->Name() == name; });
+			if (iteratee == _histories.end())
+				iteratee = _histories.insert(iteratee, std::make_unique<HistoryType>(name, description, count));
+			else if (dynamic_cast<HistoryType*>(iteratee->get()) == nullptr)
+				*iteratee = std::make_unique<HistoryType>(name, description, count);
+
+			auto history = static_cast<HistoryType*>(iteratee->get());
+			if (!(history->Description() == description) || history->Count() != count)
+				history->Reset(description, count);
+			history->_used = true;
+
+			const auto current = AddRetainedResource(history->Name(), description, history->_actuals[history->_current].get());
+			const auto previous = AddRetainedResource(history->_previousName, description, history->_actuals[history->Previous()].get());
+			current->_history = history;
+			previous->_history = history;
+			return HistoryResource<FrameGraphResource<DescriptionType, ActualType>>{ current, previous, history->PreviousValid() };
+		}
+		// Hands the actuals of a history resource back once the GPU is done with them.
+		void ReleaseHistory(const std::string_view name)
 		{
-			// Reference counting.
+			_histories.erase(std::remove_if(_histories.begin(), _histories.end(), [name](const std::unique_ptr<FrameGraphHistoryBase>& history) { return history->Name() == name; }), _histories.end());
+		}
+		// Returns false for a graph whose dependencies form a cycle, see CyclicPasses(); nothing of it is scheduled, so
+		// Execute() records nothing.
+		bool Compile()
+		{
+			// The graph is usually rebuilt identically every frame, so culling and the timeline are reused as long as
+			// the topology and the descriptions hash the same as on the last full compilation. The counts are compared
+			// as well, since the cache is indexed by them and a hash collision must not read past it.
+			const auto topologyHash = HashTopology();
+			if (_compilationCache.valid && _compilationCache.topologyHash == topologyHash &&
+				_compilationCache.passCount == _renderPasses.size() && _compilationCache.resourceCount == _resources.size() && _compilationCache.versionCount == _versions.size())
+			{
+				RestoreCompilation();
+				_compileCacheHits++;
+				return _cyclicPasses.empty();
+			}
+			_compileCacheMisses++;
+
+			const auto passCount = _renderPasses.size();
+			const auto resourceCount = _resources.size();
+
+			// Reference counting, per version. A write reads the version it goes over, so that one stays referenced
+			// as long as the writer lives.
+			std::vector<bool> culledPasses(passCount);
 			for (auto& renderPass : _renderPasses)
+			{
 				renderPass->_refCount = renderPass->_creates.size() + renderPass->_writes.size();
-			for (auto& resource : _resources)
-				resource->_refCount = resource->_readers.size();
+				culledPasses[renderPass->_index] = renderPass->_refCount == 0 && !renderPass->CullImmune();
+			}
+			for (auto versions : { &_resources, &_versions })
+				for (auto& version : *versions)
+					version->_refCount = version->_readers.size();
 
-			// Culling via flood fill from unreferenced resources.
-			std::stack<FrameGraphResourceBase*> unreferencedResources;
-			for (auto& resource : _resources)
-				if (resource->_refCount == 0 && resource->Transient())
-					unreferencedResources.push(resource.get());
-			while (!unreferencedResources.empty())
+			// Culling via flood fill from unreferenced versions. A producer is culled once its last output loses its
+			// last reader, which in turn releases everything it reads.
+			std::vector<FrameGraphResourceBase*> unreferencedVersions;
+			for (auto versions : { &_resources, &_versions })
+				for (auto& version : *versions)
+					if (version->_refCount == 0 && version->Transient())
+						unreferencedVersions.push_back(version.get());
+
+			const auto releaseOutput = [this, &culledPasses, &unreferencedVersions](const FrameGraphPassBase* producer)
+			{
+				auto& renderPass = *_renderPasses[producer->_index];
+				if (renderPass._refCount == 0 || --renderPass._refCount > 0 || renderPass.CullImmune())
+					return;
+
+				culledPasses[renderPass._index] = true;
+				for (auto read : renderPass._reads)
+					if (read->_refCount > 0 && --read->_refCount == 0 && read->Transient())
+						unreferencedVersions.push_back(read);
+			};
+			while (!unreferencedVersions.empty())
 			{
-				auto unreferencedResource = unreferencedResources.top();
-				unreferencedResources.pop();
+				auto unreferencedVersion = unreferencedVersions.back();
+				unreferencedVersions.pop_back();
+
+				if (unreferencedVersion->_producer)
+					releaseOutput(unreferencedVersion->_producer);
+			}
 
-				auto creator = const_cast<FrameGraphPassBase*>(unreferencedResource->_creator);
-				if (creator->_refCount > 0)
-					creator->_refCount--;
-				if (creator->_refCount == 0 && !creator->CullImmune())
+			// Declaration order, unless a version is read after a later one was written over it, or reordering keeps
+			// fewer bytes of transients alive at once.
+			ComputeDependencies(culledPasses);
+			auto order = TopologicalOrder(passCount, _dependencies, culledPasses);
+
+			// A read of a version orders the pass ahead of the later writes over it, which can form a cycle: P1 reads T
+			// and writes R while P2 reads the first version of R and writes T, so each has to run before the other. The
+			// passes on a cycle and those depending on them are missing from the order. Running them anyway would have
+			// some reads see the wrong version, so the whole graph is rejected and they are reported.
+			_cyclicPasses.clear();
+			const auto livePassCount = std::size_t(std::count(culledPasses.begin(), culledPasses.end(), false));
+			if (order.size() < livePassCount)
+			{
+				std::vector<bool> ordered(passCount);
+				for (auto pass : order)
+					ordered[pass] = true;
+				for (std::size_t pass = 0; pass < passCount; ++pass)
 				{
-					for (auto iteratee : creator->_reads)
-					{
-						auto readResource = const_cast<FrameGraphResourceBase*>(iteratee);
-						if (readResource->_refCount > 0)
-							readResource->_refCount--;
-						if (readResource->_refCount == 0 && readResource->Transient())
-							unreferencedResources.push(readResource);
-					}
+					if (culledPasses[pass] || ordered[pass])
+						continue;
+					_cyclicPasses.push_back(pass);
 				}
+				order.clear();
+			}
 
-				for (auto c_writer : unreferencedResource->_writers)
+			const auto transients = CollectTransientUsers(culledPasses);
+			_passOrderStats.declarationPeak = PeakLiveBytes(passCount, order, transients);
+			_passOrderStats.scheduledPeak = _passOrderStats.declarationPeak;
+			if (_reorderPasses && _cyclicPasses.empty())
+			{
+				auto reordered = MemoryAwareOrder(passCount, _dependencies, culledPasses, transients);
+				const auto peak = PeakLiveBytes(passCount, reordered, transients);
+				if (peak < _passOrderStats.declarationPeak)
 				{
-					auto writer = const_cast<FrameGraphPassBase*>(c_writer);
-					if (writer->_refCount > 0)
-						writer->_refCount--;
-					if (writer->_refCount == 0 && !writer->CullImmune())
-					{
-						for (auto iteratee : writer->_reads)
-						{
-							auto readResource = const_cast<FrameGraphResourceBase*>(iteratee);
-							if (readResource->_refCount > 0)
-								readResource->_refCount--;
-							if (readResource->_refCount == 0 && readResource->Transient())
-								unreferencedResources.push(readResource);
-						}
-					}
+					order = std::move(reordered);
+					_passOrderStats.scheduledPeak = peak;
 				}
 			}
 
+			// Last live user of every resource in a single sweep. The creator counts as a user, so a transient that
+			// nobody consumes is released right after the pass that created it.
+			constexpr auto kNoUser = static_cast<std::size_t>(-1);
+			std::vector<std::size_t> lastUsers(resourceCount, kNoUser);
+			for (auto pass : order)
+			{
+				auto& renderPass = _renderPasses[pass];
+				for (auto resources : { &renderPass->_creates, &renderPass->_reads, &renderPass->_writes })
+					for (auto resource : *resources)
+						lastUsers[resource->_index] = renderPass->_index;
+			}
+
 			// Timeline computation.
 			_timeline.clear();
-			for (auto& renderPass : _renderPasses)
+			std::vector<bool> derealized(resourceCount);
+			for (auto pass : order)
 			{
-				if (renderPass->_refCount == 0 && !renderPass->CullImmune())
-					continue;
-
-				std::vector<FrameGraphResourceBase*> realizedResources, derealizedResources;
+				auto& renderPass = _renderPasses[pass];
 
+				Step step(renderPass.get(), _arena.get());
 				for (auto resource : renderPass->_creates)
-				{
-					realizedResources.push_back(const_cast<FrameGraphResourceBase*>(resource));
-					if (resource->_readers.empty() && resource->_writers.empty())
-						derealizedResources.push_back(const_cast<FrameGraphResourceBase*>(resource));
-				}
+					step.realizedResources.push_back(_resources[resource->_index].get());
 
-				auto reads_writes = renderPass->_reads;
-				reads_writes.insert(reads_writes.end(), renderPass->_writes.begin(), renderPass->_writes.end());
-				for (auto resource : reads_writes)
+				for (auto resources : { &renderPass->_creates, &renderPass->_reads, &renderPass->_writes })
 				{
-					if (!resource->Transient())
-						continue;
-
-					bool valid = false;
-					std::size_t last_index;
-					if (!resource->_readers.empty())
-					{
-						auto last_reader = std::find_if(
-							_renderPasses.begin(),
-							_renderPasses.end(),
-							[&resource](const std::unique_ptr<FrameGraphPassBase>& iteratee)
-							{
-								return iteratee.get() == resource->_readers.back();
-							});
-						if (last_reader != _renderPasses.end())
-						{
-							valid = true;
-							last_index = std::distance(_renderPasses.begin(), last_reader);
-						}
-					}
-					if (!resource->_writers.empty())
+					for (auto resource : *resources)
 					{
-						auto last_writer = std::find_if(
-							_renderPasses.begin(),
-							_renderPasses.end(),
-							[&resource](const std::unique_ptr<FrameGraphPassBase>& iteratee)
-							{
-								return iteratee.get() == resource->_writers.back();
-							});
-						if (last_writer != _renderPasses.end())
-						{
-							valid = true;
-							last_index = std::max(last_index, std::size_t(std::distance(_renderPasses.begin(), last_writer)));
-						}
+						const auto index = resource->_index;
+						if (!resource->Transient() || derealized[index] || lastUsers[index] != renderPass->_index || culledPasses[resource->_creator->_index])
+							continue;
+
+						derealized[index] = true;
+						step.derealizedResources.push_back(_resources[index].get());
 					}
+				}
+
+				_timeline.push_back(std::move(step));
+			}
 
-					if (valid && _renderPasses[last_index] == renderPass)
-						derealizedResources.push_back(const_cast<FrameGraphResourceBase*>(resource));
+			PlanExecution();
+			PlanTransientMemory();
+			StoreCompilation(topologyHash);
+			return _cyclicPasses.empty();
+		}
+		// Records the steps batch by batch, each batch into one context on the queue of its passes: per step the
+		// activation of the transients it places in the transient heaps and the planned barriers first, then the pass,
+		// then the first halves of split barriers that end in a later step. Before a
+		// batch is submitted its queue waits for the steps it depends on from other queues. Resources released by the
+		// steps of a batch are tagged with its fence once it is submitted. With pass profiling each pass is bracketed
+		// by the recorder's BeginPass()/EndPass() and the contexts are begun unnamed; otherwise they are named after
+		// their batch.
+		void Execute(CommandRecorder& recorder) const
+		{
+			BeginTiming();
+			std::vector<std::uint64_t> fences(_timeline.size());
+			CommandContext* context = nullptr;
+			for (std::size_t i = 0; i < _timeline.size(); ++i)
+			{
+				auto& step = _timeline[i];
+				auto& barriers = _barrierPlan.steps[i];
+				const auto queue = step.renderPass->Queue();
+
+				RealizeStep(i);
+
+				if (BatchBegins(i))
+				{
+					SubmitHandoff(recorder, i, RecordHandoff(recorder, i), fences);
+					context = &recorder.Begin(_profilePasses ? std::string() : BatchName(i), queue);
 				}
 
-				_timeline.push_back(Step{ renderPass.get(), realizedResources, derealizedResources });
+				ActivateStep(i, *context);
+				for (auto& barrier : barriers.before)
+					RecordBarrier(*context, barrier);
+				if (_profilePasses)
+					recorder.BeginPass(*context, step.renderPass->Name(), queue);
+				RecordStep(i, *context, 0);
+				if (_profilePasses)
+					recorder.EndPass(*context, queue);
+				for (auto& barrier : barriers.after)
+					RecordBarrier(*context, barrier);
+
+				if (BatchEnds(i))
+					SubmitBatch(recorder, i, *context, fences);
 			}
+			_frameTiming.end = TraceClock::now();
 		}
-		void Execute() const
+		// Records the steps of each dependency level concurrently on the workers, one context per batch. Contexts are
+		// begun, given their barriers and submitted on the calling thread, the latter in timeline order; the workers
+		// only run the passes, which therefore must not touch unsynchronized CPU state such as EngineProfiling, and
+		// passes get no BeginPass()/EndPass(), only the CPU timings of StepTimings() and ExportChromeTrace(). The
+		// steps of a level that share a batch are recorded by one worker in timeline order, so smaller batches spread
+		// better over the workers (see SetMaxPassesPerSubmission()). Across levels a batch is
+		// recorded in level order, which only moves steps ahead of steps they do not conflict with. The contexts
+		// overlap, so they are begun unnamed to keep profiling blocks from nesting into each other.
+		void Execute(CommandRecorder& recorder, WorkerPool& workers) const
 		{
-			for (auto& step : _timeline)
+			const auto schedule = ScheduleRecording(_recordingLevels, _timeline.size(), workers.WorkerCount(), _stepBatches);
+			std::vector<CommandContext*> contexts(_timeline.empty() ? 0 : _stepBatches.back() + 1);
+			std::vector<CommandContext*> handoffs(_timeline.size());
+			std::vector<std::uint64_t> fences(_timeline.size());
+			OrderedSubmission submission(_timeline.size());
+			BeginTiming();
+
+			for (auto& level : schedule.levels)
 			{
-				for (auto resource : step.realizedResources) resource->Realize();
-				int fence = step.renderPass->Execute();
-				for (auto resource : step.derealizedResources) resource->DeRealize(fence);
+				for (auto i : level)
+				{
+					RealizeStep(i);
+
+					auto& context = contexts[_stepBatches[i]];
+					if (BatchBegins(i))
+						handoffs[i] = RecordHandoff(recorder, i);
+					if (context == nullptr)
+						context = &recorder.Begin(std::string(), _timeline[i].renderPass->Queue());
+					ActivateStep(i, *context);
+					for (auto& barrier : _barrierPlan.steps[i].before)
+						RecordBarrier(*context, barrier);
+				}
+
+				workers.Run(std::min(level.size(), workers.WorkerCount()), [&](const std::size_t worker)
+				{
+					for (auto i : level)
+						if (schedule.stepWorkers[i] == worker)
+							RecordStep(i, *contexts[_stepBatches[i]], worker);
+				});
+
+				for (auto i : level)
+				{
+					for (auto& barrier : _barrierPlan.steps[i].after)
+						RecordBarrier(*contexts[_stepBatches[i]], barrier);
+					submission.Recorded(i);
+				}
+
+				submission.SubmitReady([&](const std::size_t i)
+				{
+					if (BatchBegins(i))
+						SubmitHandoff(recorder, i, handoffs[i], fences);
+					if (BatchEnds(i))
+						SubmitBatch(recorder, i, *contexts[_stepBatches[i]], fences);
+				});
 			}
+			_frameTiming.end = TraceClock::now();
 		}
+		// Keeps the compilation cache, so the next identical graph skips compilation, and the capacity of the arena and
+		// the containers, so the next graph of the same size is set up and compiled without touching the heap. History
+		// resources are kept as well and move on to their next actual.
 		void Clear()
 		{
+			for (auto& history : _histories)
+				if (history->_used)
+					history->Advance();
+
+			_timeline.clear();
 			_renderPasses.clear();
+			_versions.clear();
 			_resources.clear();
+			_arena->Reset();
+		}
+		void InvalidateCompilationCache()
+		{
+			_compilationCache = CompilationCache();
+		}
+		std::size_t CompileCacheHits() const
+		{
+			return _compileCacheHits;
+		}
+		std::size_t CompileCacheMisses() const
+		{
+			return _compileCacheMisses;
+		}
+		const std::vector<DependencyEdge>& Dependencies() const // Between live passes, computed through framegraph compilation.
+		{
+			return _dependencies;
+		}
+		// Passes whose dependencies form a cycle, or that depend on such passes, by index. Empty unless the graph is
+		// malformed and Compile() rejected it; computed through framegraph compilation.
+		const std::vector<std::size_t>& CyclicPasses() const
+		{
+			return _cyclicPasses;
+		}
+		// Lets compilation move passes away from declaration order, within their dependencies, when that lowers the
+		// bytes of transients alive at once. Takes effect on the next Compile().
+		bool ReorderPasses() const
+		{
+			return _reorderPasses;
+		}
+		void SetReorderPasses(const bool reorderPasses)
+		{
+			_reorderPasses = reorderPasses;
+		}
+		const PassOrderStats& PassOrder() const // Computed through framegraph compilation.
+		{
+			return _passOrderStats;
+		}
+		std::size_t PassCount() const // Declared this frame, culled ones included.
+		{
+			return _renderPasses.size();
+		}
+		std::size_t ResourceCount() const // Created or imported this frame, not counting later versions.
+		{
+			return _resources.size();
+		}
+		const FrameArena& Arena() const // Holds the passes and resources of the current frame.
+		{
+			return *_arena;
+		}
+
+		// Transients are packed into heaps of at most this many bytes (0 for unbounded). Takes effect on the next Compile().
+		std::size_t MaxTransientHeapSize() const
+		{
+			return _maxTransientHeapSize;
+		}
+		void SetMaxTransientHeapSize(const std::size_t maxTransientHeapSize)
+		{
+			_maxTransientHeapSize = maxTransientHeapSize;
+		}
+		const std::vector<std::size_t>& TransientHeapSizes() const // Computed through framegraph compilation.
+		{
+			return _transientHeapSizes;
+		}
+		const TransientMemoryStats& TransientMemory() const // Computed through framegraph compilation.
+		{
+			return _transientMemory;
+		}
+
+		// Splitting lets the GPU start a transition while unrelated passes of the same submission run. Takes effect on the next Compile().
+		bool SplitBarriers() const
+		{
+			return _splitBarriers;
+		}
+		void SetSplitBarriers(const bool splitBarriers)
+		{
+			_splitBarriers = splitBarriers;
+		}
+		const BarrierStats& BarrierCounts() const // Barriers every Execute() records, computed through framegraph compilation.
+		{
+			return _barrierPlan.stats;
+		}
+		const QueueSchedule& Queues() const // Per-queue timelines and cross-queue waits, computed through framegraph compilation.
+		{
+			return _queueSchedule;
+		}
+
+		// Consecutive passes on one queue are recorded into one context and submitted together, up to this many (0 for
+		// no limit). Batches also end where work crosses queues. Takes effect on the next Compile().
+		std::size_t MaxPassesPerSubmission() const
+		{
+			return _maxPassesPerSubmission;
+		}
+		void SetMaxPassesPerSubmission(const std::size_t maxPassesPerSubmission)
+		{
+			_maxPassesPerSubmission = maxPassesPerSubmission;
+		}
+		std::size_t SubmissionsPerFrame() const // Command lists every Execute() submits, computed through framegraph compilation.
+		{
+			return _submissionCount;
+		}
+
+		// Opens a profiling block around every pass through the recorder's BeginPass()/EndPass(), instead of one
+		// around every batch. Takes effect on the next Execute().
+		bool ProfilePasses() const
+		{
+			return _profilePasses;
+		}
+		void SetProfilePasses(const bool profilePasses)
+		{
+			_profilePasses = profilePasses;
+		}
+		const std::vector<StepTiming>& StepTimings() const // CPU time of the last Execute(), by step index.
+		{
+			return _stepTimings;
+		}
+		ExecutionTimes Timings() const // CPU time of the last Execute().
+		{
+			return SumStepTimings(_stepTimings, _frameTiming);
 		}
+		// Writes the CPU timings of the last Execute() in the Chrome trace event format, for chrome://tracing or
+		// Perfetto: a track per worker holding the passes it recorded, realizations and releases broken down by
+		// resource, and the submissions. Needs the executed graph, so call it before Clear().
+		void ExportChromeTrace(const std::string& filepath) const
+		{
+			std::ofstream stream(filepath);
+			stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+			auto first = true;
+			std::size_t threadCount = 1;
+			for (auto& timing : _stepTimings)
+				threadCount = std::max(threadCount, timing.thread + 1);
+			for (std::size_t thread = 0; thread < threadCount; ++thread)
+			{
+				stream << (first ? "\n" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << thread
+					<< ",\"args\":{\"name\":\"" << (thread == 0 ? std::string("Framegraph") : "Worker " + std::to_string(thread)) << "\"}}";
+				first = false;
+			}
+
+			const auto origin = _frameTiming.begin;
+			std::string name;
+			for (std::size_t i = 0; i < _timeline.size() && i < _stepTimings.size(); ++i)
+			{
+				auto& step = _timeline[i];
+				auto& timing = _stepTimings[i];
+				const auto queue = step.renderPass->Queue();
+				const auto batch = _stepBatches[i];
+				const auto passName = step.renderPass->Name();
+
+				name.assign("Realize ").append(passName);
+				WriteTraceEvent(stream, first, name, "realize", 0, timing.realize, origin, i, queue, batch);
+				for (auto resource : step.realizedResources)
+					WriteTraceEvent(stream, first, resource->Name(), "realize", 0, _resourceTimings[resource->_index].realize, origin, i, queue, batch);
+
+				WriteTraceEvent(stream, first, passName, "pass", timing.thread, timing.record, origin, i, queue, batch);
+
+				if (!timing.submit.Empty())
+					name.assign("Submit ").append(BatchName(BatchFirstStep(i)));
+				WriteTraceEvent(stream, first, name, "submit", 0, timing.submit, origin, i, queue, batch);
+
+				name.assign("DeRealize ").append(passName);
+				WriteTraceEvent(stream, first, name, "derealize", 0, timing.derealize, origin, i, queue, batch);
+				for (auto resource : step.derealizedResources)
+					WriteTraceEvent(stream, first, resource->Name(), "derealize", 0, _resourceTimings[resource->_index].derealize, origin, i, queue, batch);
+			}
+
+			name.assign("Execute");
+			WriteTraceEvent(stream, first, name, "frame", 0, _frameTiming, origin, 0, QueueType::Graphics, 0);
+			stream << "\n]}\n";
+		}
+
 		void ExportGraphviz(const std::string& filepath)
 		{
 			std::ofstream stream(filepath);
@@ -182,75 +527,530 @@ namespace FG
 			stream << "bgcolor = black\n\n";
 			stream << "node [shape=rectangle, fontname=\"helvetica\", fontsize=12]\n\n";
 
+			// Later versions get their own node, chained to the version they were written over.
+			const auto versionName = [](const FrameGraphResourceBase* version)
+			{
+				std::string name(version->Name());
+				return version->_version == 0 ? name : name + " v" + std::to_string(version->_version);
+			};
+
 			for (auto& renderPass : _renderPasses)
 				stream << "\"" << renderPass->Name() << "\" [label=\"" << renderPass->Name() << "\\nRefs: " << renderPass->_refCount << "\", style=filled, fillcolor=darkorange]\n";
 			stream << "\n";
 
-			for (auto& resource : _resources)
-				stream << "\"" << resource->Name() << "\" [label=\"" << resource->Name() << "\\nRefs: " << resource->_refCount << "\\nID: " << resource->Id() << "\", style=filled, fillcolor= " << (resource->Transient() ? "skyblue" : "steelblue") << "]\n";
+			for (auto versions : { &_resources, &_versions })
+				for (auto& resource : *versions)
+					stream << "\"" << versionName(resource.get()) << "\" [label=\"" << versionName(resource.get()) << "\\nRefs: " << resource->_refCount << "\\nID: " << resource->Id() << "\", style=filled, fillcolor= " << (resource->Transient() ? "skyblue" : "steelblue") << "]\n";
 			stream << "\n";
 
 			for (auto& renderPass : _renderPasses)
 			{
 				stream << "\"" << renderPass->Name() << "\" -> { ";
 				for (auto& resource : renderPass->_creates)
-					stream << "\"" << resource->Name() << "\" ";
+					stream << "\"" << versionName(resource) << "\" ";
 				stream << "} [color=seagreen]\n";
 
 				stream << "\"" << renderPass->Name() << "\" -> { ";
 				for (auto& resource : renderPass->_writes)
-					stream << "\"" << resource->Name() << "\" ";
+					stream << "\"" << versionName(resource) << "\" ";
 				stream << "} [color=gold]\n";
 			}
 			stream << "\n";
 
-			for (auto& resource : _resources)
+			for (auto versions : { &_resources, &_versions })
 			{
-				stream << "\"" << resource->Name() << "\" -> { ";
-				for (auto& renderPass : resource->_readers)
-					stream << "\"" << renderPass->Name() << "\" ";
-				stream << "} [color=firebrick]\n";
+				for (auto& resource : *versions)
+				{
+					stream << "\"" << versionName(resource.get()) << "\" -> { ";
+					for (auto& reader : resource->_readers)
+						stream << "\"" << reader.pass->Name() << "\" ";
+					stream << "} [color=firebrick]\n";
+				}
 			}
+			stream << "\n";
+
+			for (auto& version : _versions)
+				stream << "\"" << versionName(version->_previous) << "\" -> \"" << versionName(version.get()) << "\" [color=gray, style=dashed]\n";
 			stream << "}";
 		}
 
 	protected:
 		friend FrameGraphBuilder;
 
+		// The live passes using each transient, and its size, for ordering the passes by memory.
+		std::vector<TransientUsers> CollectTransientUsers(const std::vector<bool>& culledPasses) const
+		{
+			std::vector<TransientUsers> transients(_resources.size());
+			for (auto& resource : _resources)
+				if (resource->Transient())
+					transients[resource->_index].size = resource->MemoryRequirements().size;
+
+			for (auto& renderPass : _renderPasses)
+			{
+				if (culledPasses[renderPass->_index])
+					continue;
+				for (auto resources : { &renderPass->_creates, &renderPass->_reads, &renderPass->_writes })
+				{
+					for (auto resource : *resources)
+					{
+						auto& passes = transients[resource->_index].passes;
+						if (resource->Transient() && (passes.empty() || passes.back() != renderPass->_index))
+							passes.push_back(renderPass->_index);
+					}
+				}
+			}
+			return transients;
+		}
+		// Registers the pass as a reader of the versions whose writes make up the range of version: walking back from
+		// it, every version that wrote part of the range, up to one that wrote all of it. A writer does not read what it
+		// wrote itself.
+		void AddRead(FrameGraphPassBase* renderPass, FrameGraphResourceBase* version, const SubresourceRange& range, const bool write)
+		{
+			for (auto source = version; source; source = source->_previous)
+			{
+				if (Overlaps(source->_range, range) && !(write && source->_producer == renderPass))
+				{
+					source->_readers.push_back(FrameGraphResourceBase::Reader{ renderPass, range, version->_version, write });
+					renderPass->_reads.push_back(source);
+				}
+				if (Contains(source->_range, range))
+					break;
+			}
+		}
+		// Derives the ordering constraints between the live passes from the versions they read and write.
+		void ComputeDependencies(const std::vector<bool>& culledPasses)
+		{
+			_dependencies.clear();
+			for (auto versions : { &_resources, &_versions })
+			{
+				for (auto& version : *versions)
+				{
+					const auto producer = version->_producer;
+					if (producer && culledPasses[producer->_index])
+						continue;
+
+					for (auto& reader : version->_readers)
+					{
+						const auto pass = reader.pass;
+						if (culledPasses[pass->_index])
+							continue;
+						if (producer)
+							_dependencies.push_back(DependencyEdge{ producer->_index, pass->_index, reader.write ? DependencyKind::WriteAfterWrite : DependencyKind::ReadAfterWrite });
+						if (reader.write)
+							continue; // Later writes over the range read this writer's version instead.
+
+						// The writes over the range after the version the pass read, up to one covering all of it. Only
+						// done from the newest version the read depends on, which comes last among those overlapping.
+						for (auto later = version->_next; later; later = later->_next)
+						{
+							if (!Overlaps(later->_range, reader.range))
+								continue;
+							if (later->_version <= reader.version)
+								break;
+							const auto writer = later->_producer;
+							if (writer != pass && !culledPasses[writer->_index])
+								_dependencies.push_back(DependencyEdge{ pass->_index, writer->_index, DependencyKind::WriteAfterRead });
+							if (Contains(later->_range, reader.range))
+								break;
+						}
+					}
+				}
+			}
+		}
+		// Barriers, recording levels and queue timelines, all derived from the accesses each step declared. They are
+		// planned per subresource, so steps using disjoint ranges of a resource neither wait for each other nor
+		// transition each other's subresources.
+		void PlanExecution()
+		{
+			std::vector<SubresourceLayout> layouts;
+			for (auto& resource : _resources)
+				layouts.push_back(resource->Subresources());
+			const auto indexing = IndexSubresources(layouts);
+
+			std::vector<std::vector<ResourceUse>> uses(_timeline.size());
+			std::vector<QueueType> queues(_timeline.size());
+			for (std::size_t i = 0; i < _timeline.size(); ++i)
+			{
+				for (auto& access : _timeline[i].renderPass->_accesses)
+					uses[i].push_back(ResourceUse{ access.resource->_index, access.access, access.range });
+				queues[i] = _timeline[i].renderPass->Queue();
+			}
+			const auto subresourceUses = ExpandSubresourceUses(indexing, uses);
+
+			// The batches depend on the handoffs only, which splitting leaves alone, and bound where barriers can be
+			// split in turn; so they come from a plan without splitting, and splitting is planned within them.
+			_barrierPlan = PlanSubresourceBarriers(indexing, subresourceUses, false, queues);
+			_recordingLevels = ComputeDependencyLevels(indexing.Count(), subresourceUses);
+			std::vector<bool> handoffSteps(_timeline.size());
+			for (std::size_t i = 0; i < _timeline.size(); ++i)
+				handoffSteps[i] = !_barrierPlan.steps[i].handoff.empty();
+			_queueSchedule = ScheduleQueues(indexing.Count(), subresourceUses, queues, handoffSteps);
+			_stepBatches = PlanSubmissionBatches(_barrierPlan, _queueSchedule, queues, _maxPassesPerSubmission);
+			if (_splitBarriers)
+				_barrierPlan = PlanSubresourceBarriers(indexing, subresourceUses, true, queues, _stepBatches);
+
+			_submissionCount = _timeline.empty() ? 0 : _stepBatches.back() + 1;
+			for (auto handoff : handoffSteps)
+				_submissionCount += handoff ? 1 : 0;
+		}
+		// Records the transitions the queue of a step cannot record itself into a graphics context. Null if there are none.
+		CommandContext* RecordHandoff(CommandRecorder& recorder, const std::size_t i) const
+		{
+			auto& handoff = _barrierPlan.steps[i].handoff;
+			if (handoff.empty())
+				return nullptr;
+
+			auto& context = recorder.Begin(std::string(), QueueType::Graphics);
+			for (auto& barrier : handoff)
+				RecordBarrier(context, barrier);
+			return &context;
+		}
+		void RecordBarrier(CommandContext& context, const PlannedBarrier& barrier) const
+		{
+			_resources[barrier.resource]->Transition(context, barrier.before, barrier.after, barrier.range, barrier.phase);
+		}
+		// Submits the handoff of a step once the previous users of its resources are done, and holds the step's queue
+		// until the handoff is.
+		void SubmitHandoff(CommandRecorder& recorder, const std::size_t i, CommandContext* handoff, const std::vector<std::uint64_t>& fences) const
+		{
+			if (handoff == nullptr)
+				return;
+
+			for (auto& barrier : _barrierPlan.steps[i].handoff)
+				if (barrier.previousStep != kNoStep && _timeline[barrier.previousStep].renderPass->Queue() != QueueType::Graphics)
+					recorder.Wait(QueueType::Graphics, fences[barrier.previousStep]);
+			recorder.Wait(_timeline[i].renderPass->Queue(), recorder.Finish(*handoff));
+		}
+		bool BatchBegins(const std::size_t i) const
+		{
+			return i == 0 || _stepBatches[i - 1] != _stepBatches[i];
+		}
+		bool BatchEnds(const std::size_t i) const
+		{
+			return i + 1 == _timeline.size() || _stepBatches[i + 1] != _stepBatches[i];
+		}
+		std::size_t BatchFirstStep(std::size_t i) const
+		{
+			while (!BatchBegins(i))
+				i--;
+			return i;
+		}
+		std::string BatchName(const std::size_t first) const
+		{
+			auto last = first;
+			while (!BatchEnds(last))
+				last++;
+			std::string name(_timeline[first].renderPass->Name());
+			if (last != first)
+				name.append("..").append(_timeline[last].renderPass->Name());
+			return name;
+		}
+		// Submits the batch ending with step last once its queue waits for the other queues, then releases the
+		// resources of all its steps against its fence.
+		void SubmitBatch(CommandRecorder& recorder, const std::size_t last, CommandContext& context, std::vector<std::uint64_t>& fences) const
+		{
+			const auto first = BatchFirstStep(last);
+			auto& submit = _stepTimings[last].submit;
+			submit.begin = TraceClock::now();
+			const auto queue = _timeline[first].renderPass->Queue();
+			for (auto& wait : _queueSchedule.waits[first])
+				recorder.Wait(queue, fences[wait.step]);
+			const auto fence = recorder.Finish(context);
+			submit.end = TraceClock::now();
+
+			for (auto i = first; i <= last; ++i)
+			{
+				fences[i] = fence;
+				DeRealizeStep(i, fence);
+				for (auto& access : _timeline[i].renderPass->_accesses)
+					if (access.resource->_history)
+						access.resource->_history->_fence = fence;
+			}
+		}
+		void BeginTiming() const
+		{
+			_stepTimings.assign(_timeline.size(), StepTiming());
+			_resourceTimings.assign(_resources.size(), ResourceTiming());
+			_frameTiming.begin = TraceClock::now();
+			_frameTiming.end = _frameTiming.begin;
+		}
+		void RealizeStep(const std::size_t i) const
+		{
+			auto& resources = _timeline[i].realizedResources;
+			if (resources.empty())
+				return;
+
+			auto& span = _stepTimings[i].realize;
+			span.begin = TraceClock::now();
+			for (auto resource : resources)
+			{
+				auto& timing = _resourceTimings[resource->_index].realize;
+				timing.begin = TraceClock::now();
+				resource->Realize();
+				timing.end = TraceClock::now();
+			}
+			span.end = TraceClock::now();
+		}
+		void ActivateStep(const std::size_t i, CommandContext& context) const
+		{
+			for (auto resource : _timeline[i].realizedResources)
+				if (resource->_placement.heap != kUnplacedHeap)
+					resource->Activate(context);
+		}
+		// Called on the worker recording the step.
+		void RecordStep(const std::size_t i, CommandContext& context, const std::size_t worker) const
+		{
+			auto& timing = _stepTimings[i];
+			timing.thread = worker;
+			timing.record.begin = TraceClock::now();
+			_timeline[i].renderPass->Execute(context);
+			timing.record.end = TraceClock::now();
+		}
+		void DeRealizeStep(const std::size_t i, const std::uint64_t fence) const
+		{
+			auto& resources = _timeline[i].derealizedResources;
+			if (resources.empty())
+				return;
+
+			auto& span = _stepTimings[i].derealize;
+			span.begin = TraceClock::now();
+			for (auto resource : resources)
+			{
+				auto& timing = _resourceTimings[resource->_index].derealize;
+				timing.begin = TraceClock::now();
+				resource->DeRealize(fence);
+				timing.end = TraceClock::now();
+			}
+			span.end = TraceClock::now();
+		}
+		// Turns the realize/derealize steps of the timeline into lifetimes and packs them into the transient heaps. Only
+		// transients that no pass touches outside the graphics queue are placed: the queues run concurrently, so memory
+		// passed from one queue to another would need a fence between the last use and the next, and activating a
+		// render target or depth buffer in aliased memory takes a discard that only graphics lists can record.
+		void PlanTransientMemory()
+		{
+			std::vector<bool> graphicsOnly(_resources.size(), true);
+			for (auto& step : _timeline)
+			{
+				if (step.renderPass->Queue() == QueueType::Graphics)
+					continue;
+				for (auto resources : { &step.renderPass->_creates, &step.renderPass->_reads, &step.renderPass->_writes })
+					for (auto resource : *resources)
+						graphicsOnly[resource->_index] = false;
+			}
+
+			std::vector<FrameGraphResourceBase*> transients;
+			std::vector<TransientAllocation> allocations;
+			std::vector<std::size_t> allocationIndices(_resources.size());
+			for (std::size_t i = 0; i < _timeline.size(); ++i)
+			{
+				for (auto resource : _timeline[i].realizedResources)
+				{
+					const auto requirements = resource->MemoryRequirements();
+					resource->_placement = TransientPlacement();
+					allocationIndices[resource->_index] = allocations.size();
+					transients.push_back(resource);
+					const auto size = graphicsOnly[resource->_index] ? requirements.size : 0;
+					allocations.push_back(TransientAllocation{ size, requirements.alignment, i, _timeline.size() - 1 });
+				}
+				for (auto resource : _timeline[i].derealizedResources)
+					allocations[allocationIndices[resource->_index]].lastStep = i;
+			}
+
+			auto plan = PlanTransientAliasing(allocations, _maxTransientHeapSize);
+			for (std::size_t i = 0; i < transients.size(); ++i)
+				transients[i]->_placement = plan.placements[i];
+			_transientHeapSizes = std::move(plan.heapSizes);
+			_transientMemory = plan.stats;
+		}
+
 		struct Step
 		{
+			Step(FrameGraphPassBase* renderPass, std::pmr::memory_resource* memory)
+				: renderPass(renderPass), realizedResources(memory), derealizedResources(memory)
+			{
+
+			}
+
 			FrameGraphPassBase* renderPass;
-			std::vector<FrameGraphResourceBase*> realizedResources;
-			std::vector<FrameGraphResourceBase*> derealizedResources;
+			std::pmr::vector<FrameGraphResourceBase*> realizedResources;
+			std::pmr::vector<FrameGraphResourceBase*> derealizedResources;
+		};
+
+		// Compilation results by pass and resource index, so they outlive the passes and resources of a frame.
+		struct CompilationCache
+		{
+			struct CachedStep
+			{
+				std::size_t renderPass;
+				std::vector<std::size_t> realizedResources;
+				std::vector<std::size_t> derealizedResources;
+			};
+
+			bool                             valid = false;
+			std::size_t                      topologyHash = 0;
+			std::size_t                      passCount = 0;
+			std::size_t                      resourceCount = 0;
+			std::size_t                      versionCount = 0;
+			std::vector<std::size_t>         passRefCounts;
+			std::vector<std::size_t>         resourceRefCounts;
+			std::vector<std::size_t>         versionRefCounts;
+			std::vector<TransientPlacement>  placements;
+			std::vector<CachedStep>          timeline;
 		};
 
-		std::vector<std::unique_ptr<FrameGraphPassBase>>      _renderPasses;
-		std::vector<std::unique_ptr<FrameGraphResourceBase>>  _resources;
+		std::size_t HashTopology() const
+		{
+			auto hash = HashCombine(HashCombine(_renderPasses.size(), _resources.size()), _versions.size());
+			hash = HashCombine(hash, _maxTransientHeapSize);
+			hash = HashCombine(hash, _splitBarriers);
+			hash = HashCombine(hash, _maxPassesPerSubmission);
+			hash = HashCombine(hash, _reorderPasses);
+			for (auto& resource : _resources)
+			{
+				hash = HashCombine(hash, resource->Transient());
+				hash = HashCombine(hash, resource->DescriptionHash());
+			}
+			for (auto& renderPass : _renderPasses)
+			{
+				hash = HashCombine(hash, renderPass->CullImmune());
+				hash = HashCombine(hash, std::size_t(renderPass->Queue()));
+				for (auto resources : { &renderPass->_creates, &renderPass->_reads, &renderPass->_writes })
+				{
+					hash = HashCombine(hash, resources->size());
+					for (auto resource : *resources)
+						hash = HashCombine(HashCombine(hash, resource->_index), resource->_version);
+				}
+				for (auto& access : renderPass->_accesses)
+				{
+					hash = HashCombine(hash, std::size_t(access.access));
+					hash = HashCombine(HashCombine(hash, access.range.firstMip), access.range.mipCount);
+					hash = HashCombine(HashCombine(hash, access.range.firstSlice), access.range.sliceCount);
+				}
+			}
+			return hash;
+		}
+		void StoreCompilation(const std::size_t topologyHash)
+		{
+			auto& cache = _compilationCache;
+			cache.valid = true;
+			cache.topologyHash = topologyHash;
+			cache.passCount = _renderPasses.size();
+			cache.resourceCount = _resources.size();
+			cache.versionCount = _versions.size();
+
+			cache.passRefCounts.clear();
+			for (auto& renderPass : _renderPasses)
+				cache.passRefCounts.push_back(renderPass->_refCount);
+			cache.resourceRefCounts.clear();
+			cache.placements.clear();
+			for (auto& resource : _resources)
+			{
+				cache.resourceRefCounts.push_back(resource->_refCount);
+				cache.placements.push_back(resource->_placement);
+			}
+			cache.versionRefCounts.clear();
+			for (auto& version : _versions)
+				cache.versionRefCounts.push_back(version->_refCount);
+
+			cache.timeline.clear();
+			for (auto& step : _timeline)
+			{
+				CompilationCache::CachedStep cachedStep{ step.renderPass->_index, {}, {} };
+				for (auto resource : step.realizedResources)
+					cachedStep.realizedResources.push_back(resource->_index);
+				for (auto resource : step.derealizedResources)
+					cachedStep.derealizedResources.push_back(resource->_index);
+				cache.timeline.push_back(std::move(cachedStep));
+			}
+		}
+		void RestoreCompilation()
+		{
+			auto& cache = _compilationCache;
+			for (std::size_t i = 0; i < _renderPasses.size(); ++i)
+				_renderPasses[i]->_refCount = cache.passRefCounts[i];
+			for (std::size_t i = 0; i < _resources.size(); ++i)
+			{
+				_resources[i]->_refCount = cache.resourceRefCounts[i];
+				_resources[i]->_placement = cache.placements[i];
+			}
+			for (std::size_t i = 0; i < _versions.size(); ++i)
+				_versions[i]->_refCount = cache.versionRefCounts[i];
+
+			_timeline.clear();
+			for (auto& cachedStep : cache.timeline)
+			{
+				Step step(_renderPasses[cachedStep.renderPass].get(), _arena.get());
+				for (auto index : cachedStep.realizedResources)
+					step.realizedResources.push_back(_resources[index].get());
+				for (auto index : cachedStep.derealizedResources)
+					step.derealizedResources.push_back(_resources[index].get());
+				_timeline.push_back(std::move(step));
+			}
+		}
+
+		std::vector<std::unique_ptr<FrameGraphHistoryBase>>   _histories; // Kept across frames.
+		std::unique_ptr<FrameArena>                           _arena; // Destroyed after everything below, which may live in it.
+		std::vector<ArenaPtr<FrameGraphPassBase>>             _renderPasses;
+		std::vector<ArenaPtr<FrameGraphResourceBase>>         _resources; // First versions.
+		std::vector<ArenaPtr<FrameGraphResourceBase>>         _versions; // Later versions, in the order they were written.
+		std::vector<DependencyEdge>                           _dependencies; // Computed through framegraph compilation.
+		std::vector<std::size_t>                              _cyclicPasses; // Computed through framegraph compilation.
+		bool                                                  _reorderPasses = false;
+		PassOrderStats                                        _passOrderStats; // Computed through framegraph compilation.
 		std::vector<Step>                                     _timeline; // Computed through framegraph compilation.
+		std::size_t                                           _maxTransientHeapSize = 256 * 1024 * 1024;
+		std::vector<std::size_t>                              _transientHeapSizes;
+		TransientMemoryStats                                  _transientMemory;
+		bool                                                  _splitBarriers = true;
+		BarrierPlan                                           _barrierPlan; // Computed through framegraph compilation, by resource index.
+		std::vector<std::vector<std::size_t>>                 _recordingLevels; // Computed through framegraph compilation, by step index.
+		QueueSchedule                                         _queueSchedule; // Computed through framegraph compilation, by step index.
+		std::size_t                                           _maxPassesPerSubmission = 8;
+		std::vector<std::size_t>                              _stepBatches; // Computed through framegraph compilation, by step index.
+		std::size_t                                           _submissionCount = 0; // Computed through framegraph compilation.
+		bool                                                  _profilePasses = true;
+		mutable std::vector<StepTiming>                       _stepTimings; // Recorded through Execute(), by step index.
+		mutable std::vector<ResourceTiming>                   _resourceTimings; // Recorded through Execute(), by resource index.
+		mutable TraceSpan                                     _frameTiming; // Recorded through Execute().
+		CompilationCache                                      _compilationCache;
+		std::size_t                                           _compileCacheHits = 0;
+		std::size_t                                           _compileCacheMisses = 0;
 	};
 
 	template<typename ResourceType, typename DescriptionType>
-	ResourceType* FrameGraphBuilder::Create(const std::string& name, const DescriptionType& description)
+	ResourceType* FrameGraphBuilder::Create(const std::string_view name, const DescriptionType& description, ResourceAccess access)
 	{
 		static_assert(std::is_same<typename ResourceType::DescriptionType, DescriptionType>::value, "Description does not match the resource.");
-		_framegraph->_resources.emplace_back(std::make_unique<ResourceType>(name, _renderpass, description));
+		_framegraph->_resources.emplace_back(MakeArenaObject<ResourceType>(*_framegraph->_arena, name, _renderpass, description, _framegraph->_arena.get()));
 		const auto resource = _framegraph->_resources.back().get();
+		resource->_index = _framegraph->_resources.size() - 1;
 		_renderpass->_creates.push_back(resource);
+		_renderpass->_accesses.push_back(FrameGraphPassBase::Access{ resource, access, SubresourceRange() });
 		return static_cast<ResourceType*>(resource);
 	}
 	template<typename ResourceType>
-	ResourceType* FrameGraphBuilder::Read(ResourceType* resource)
+	ResourceType* FrameGraphBuilder::Read(ResourceType* resource, ResourceAccess access, const SubresourceRange& range)
 	{
-		resource->_readers.push_back(_renderpass);
-		_renderpass->_reads.push_back(resource);
+		_framegraph->AddRead(_renderpass, resource, range, false);
+		_renderpass->_accesses.push_back(FrameGraphPassBase::Access{ resource, access, range });
 		return resource;
 	}
 	template<typename ResourceType>
-	ResourceType* FrameGraphBuilder::Write(ResourceType* resource)
+	ResourceType* FrameGraphBuilder::Write(ResourceType* resource, ResourceAccess access, const SubresourceRange& range)
 	{
-		resource->_writers.push_back(_renderpass);
-		_renderpass->_writes.push_back(resource);
-		return resource;
+		const auto previous = static_cast<ResourceType*>(resource->LatestVersion());
+		_framegraph->AddRead(_renderpass, previous, range, true);
+
+		_framegraph->_versions.emplace_back(MakeArenaObject<ResourceType>(*_framegraph->_arena, *previous, _renderpass, range, _framegraph->_arena.get()));
+		const auto version = _framegraph->_versions.back().get();
+		_renderpass->_writes.push_back(version);
+		_renderpass->_accesses.push_back(FrameGraphPassBase::Access{ version, access, range });
+		return static_cast<ResourceType*>(version);
+	}
+	inline void FrameGraphBuilder::SetQueue(const QueueType queue)
+	{
+		_renderpass->SetQueue(queue);
 	}
 }
 
@@ -0,0 +1,717 @@
+#pragma once
+#ifndef FG_FRAME_GRAPH_BENCHMARK_HPP_
+#define FG_FRAME_GRAPH_BENCHMARK_HPP_
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "FrameGraph.hpp"
+#include "WorkerPool.hpp"
+
+// Synthetic workloads for timing the framegraph itself: declaring, compiling and executing graphs whose resources are
+// realized to nothing and whose passes record nothing. Only the framegraph headers are needed, no renderer and no GPU,
+// so the benchmark builds on any platform; Tests/FrameGraphBenchmark.cpp runs it for CI to track regressions.
+//
+// Heap allocations per frame are only reported when BenchmarkOptions::allocationCount is given, e.g. a counter bumped
+// by a replaced global operator new in the same program.
+namespace FG
+{
+	// A texture, or a buffer with a height of one. Sizes are in elements.
+	struct BenchmarkDescription
+	{
+		std::uint32_t width           = 1;
+		std::uint32_t height          = 1;
+		std::uint32_t bytesPerElement = 4;
+		std::uint32_t mipCount        = 1;
+		std::uint32_t sliceCount      = 1;
+	};
+
+	inline bool operator==(const BenchmarkDescription& lhs, const BenchmarkDescription& rhs)
+	{
+		return lhs.width == rhs.width && lhs.height == rhs.height && lhs.bytesPerElement == rhs.bytesPerElement && lhs.mipCount == rhs.mipCount && lhs.sliceCount == rhs.sliceCount;
+	}
+
+	struct BenchmarkActual
+	{
+		BenchmarkDescription description;
+	};
+
+	using BenchmarkResource = FrameGraphResource<BenchmarkDescription, BenchmarkActual>;
+
+	// Derealized actuals, handed out again so that realizing does not touch the heap once the pool has grown.
+	inline std::vector<std::unique_ptr<BenchmarkActual>> g_BenchmarkActualPool;
+
+	template<>
+	inline std::unique_ptr<BenchmarkActual> Realize(const BenchmarkDescription& description)
+	{
+		if (g_BenchmarkActualPool.empty())
+			return std::make_unique<BenchmarkActual>(BenchmarkActual{ description });
+
+		auto actual = std::move(g_BenchmarkActualPool.back());
+		g_BenchmarkActualPool.pop_back();
+		actual->description = description;
+		return actual;
+	}
+
+	template<>
+	inline void DeRealize(const BenchmarkDescription&, std::unique_ptr<BenchmarkActual>& actual_ptr, std::uint64_t)
+	{
+		if (actual_ptr)
+			g_BenchmarkActualPool.push_back(std::move(actual_ptr));
+	}
+
+	// Sized like a placed D3D12 resource: every mip and slice, aligned to 64KB.
+	template<>
+	inline TransientMemoryRequirements MemoryRequirements<BenchmarkDescription, BenchmarkActual>(const BenchmarkDescription& description)
+	{
+		std::size_t size = 0;
+		for (std::uint32_t mip = 0; mip < std::max(description.mipCount, 1u); ++mip)
+			size += std::size_t(std::max(description.width >> mip, 1u)) * std::max(description.height >> mip, 1u) * description.bytesPerElement;
+		size *= std::max(description.sliceCount, 1u);
+
+		TransientMemoryRequirements requirements;
+		requirements.alignment = 64 * 1024;
+		requirements.size = AlignTransientOffset(size, requirements.alignment);
+		return requirements;
+	}
+
+	template<>
+	inline SubresourceLayout Subresources<BenchmarkDescription, BenchmarkActual>(const BenchmarkDescription& description)
+	{
+		return SubresourceLayout{ std::max(description.mipCount, 1u), std::max(description.sliceCount, 1u) };
+	}
+
+	inline BenchmarkDescription BenchmarkTexture(const std::uint32_t width, const std::uint32_t height, const std::uint32_t bytesPerElement, const std::uint32_t mipCount = 1, const std::uint32_t sliceCount = 1)
+	{
+		return BenchmarkDescription{ std::max(width, 1u), std::max(height, 1u), bytesPerElement, mipCount, sliceCount };
+	}
+	inline BenchmarkDescription BenchmarkBuffer(const std::uint32_t elementCount, const std::uint32_t elementSize)
+	{
+		return BenchmarkDescription{ std::max(elementCount, 1u), 1, elementSize, 1, 1 };
+	}
+
+	// Hands out a context that nothing ever records into: the benchmark passes and transitions ignore it.
+	class NullCommandRecorder : public CommandRecorder
+	{
+	public:
+		CommandContext& Begin(const std::string&, const QueueType) override
+		{
+			_begun++;
+			return *reinterpret_cast<CommandContext*>(&_context);
+		}
+		std::uint64_t Finish(CommandContext&) override
+		{
+			return ++_fence;
+		}
+		void Wait(const QueueType, const std::uint64_t) override
+		{
+			_waits++;
+		}
+
+		std::size_t Begun() const
+		{
+			return _begun;
+		}
+		std::size_t Waits() const
+		{
+			return _waits;
+		}
+
+	protected:
+		std::max_align_t  _context;
+		std::uint64_t     _fence = 0;
+		std::size_t       _begun = 0;
+		std::size_t       _waits = 0;
+	};
+
+	struct BenchmarkPassData
+	{
+
+	};
+
+	template<typename SetupType>
+	FrameGraphPass<BenchmarkPassData>* AddBenchmarkPass(FrameGraph& framegraph, const std::string_view name, SetupType&& setup)
+	{
+		return framegraph.AddRenderPass<BenchmarkPassData>(name, std::forward<SetupType>(setup), [](const BenchmarkPassData&, CommandContext&) {});
+	}
+
+	// The post-processing chain of BufferManager.cpp at the given resolution: motion blur, depth of field, exposure,
+	// bloom, tone mapping, FXAA and a generated mip chain. Reads and writes color, reads velocity and returns the final
+	// image.
+	inline BenchmarkResource* DeclareBenchmarkPostProcessing(FrameGraph& framegraph, BenchmarkResource* color, BenchmarkResource* velocity, const std::uint32_t width, const std::uint32_t height)
+	{
+		struct Resources
+		{
+			std::uint32_t       width[7];
+			std::uint32_t       height[7];
+			std::uint32_t       bloomWidth;
+			std::uint32_t       bloomHeight;
+			BenchmarkResource*  color;
+			BenchmarkResource*  velocity;
+			BenchmarkResource*  motionPrep;
+			BenchmarkResource*  doFTiles;
+			BenchmarkResource*  doFPresort;
+			BenchmarkResource*  doFBlur;
+			BenchmarkResource*  doFQueues[3];
+			BenchmarkResource*  luma;
+			BenchmarkResource*  histogram;
+			BenchmarkResource*  bloom[5];
+			BenchmarkResource*  postEffects;
+			BenchmarkResource*  fXAAQueues[2];
+			BenchmarkResource*  mips;
+		};
+		Resources resources;
+		auto r = &resources;
+		for (std::uint32_t level = 0; level < 7; ++level)
+		{
+			r->width[level] = (width + (1u << level) - 1) >> level;
+			r->height[level] = (height + (1u << level) - 1) >> level;
+		}
+		r->bloomWidth = width > 2560 ? 1280 : 640;
+		r->bloomHeight = height > 1440 ? 768 : 384;
+		r->color = color;
+		r->velocity = velocity;
+
+		AddBenchmarkPass(framegraph, "Motion Blur", [r](BenchmarkPassData&, FrameGraphBuilder& builder)
+		{
+			builder.Read(r->velocity, ResourceAccess::ShaderResource);
+			builder.Read(r->color, ResourceAccess::ShaderResource);
+			r->motionPrep = builder.Create<BenchmarkResource>("Motion Blur Prep", BenchmarkTexture(r->width[1], r->height[1], 8), ResourceAccess::UnorderedAccess);
+		});
+		AddBenchmarkPass(framegraph, "Motion Blur Final", [r](BenchmarkPassData&, FrameGraphBuilder& builder)
+		{
+			builder.Read(r->motionPrep, ResourceAccess::ShaderResource);
+			r->color = builder.Write(r->color, ResourceAccess::UnorderedAccess);
+		});
+
+		AddBenchmarkPass(framegraph, "DoF Tiles", [r](BenchmarkPassData&, FrameGraphBuilder& builder)
+		{
+			builder.SetQueue(QueueType::Compute);
+			builder.Read(r->velocity, ResourceAccess::ShaderResource);
+			r->doFTiles = builder.Create<BenchmarkResource>("DoF Tile Classification", BenchmarkTexture(r->width[4], r->height[4], 4, 1, 2), ResourceAccess::UnorderedAccess);
+			const auto queueSize = r->width[4] * r->height[4];
+			r->doFQueues[0] = builder.Create<BenchmarkResource>("DoF Work Queue", BenchmarkBuffer(queueSize, 4), ResourceAccess::UnorderedAccess);
+			r->doFQueues[1] = builder.Create<BenchmarkResource>("DoF Fast Queue", BenchmarkBuffer(queueSize, 4), ResourceAccess::UnorderedAccess);
+			r->doFQueues[2] = builder.Create<BenchmarkResource>("DoF Fixup Queue", BenchmarkBuffer(queueSize, 4), ResourceAccess::UnorderedAccess);
+		});
+		AddBenchmarkPass(framegraph, "DoF Presort", [r](BenchmarkPassData&, FrameGraphBuilder& builder)
+		{
+			builder.Read(r->color, ResourceAccess::ShaderResource);
+			builder.Read(r->doFTiles, ResourceAccess::ShaderResource);
+			builder.Read(r->doFQueues[0], ResourceAccess::ShaderResource);
+			r->doFPresort = builder.Create<BenchmarkResource>("DoF Presort Buffer", BenchmarkTexture(r->width[1], r->height[1], 4, 1, 2), ResourceAccess::UnorderedAccess);
+		});
+		AddBenchmarkPass(framegraph, "DoF Prefilter", [r](BenchmarkPassData&, FrameGraphBuilder& builder)
+		{
+			builder.Read(r->doFPresort, ResourceAccess::ShaderResource);
+			r->doFBlur = builder.Create<BenchmarkResource>("DoF Blur", BenchmarkTexture(r->width[1], r->height[1], 4, 1, 2), ResourceAccess::UnorderedAccess);
+		});
+		AddBenchmarkPass(framegraph, "DoF Blur", [r](BenchmarkPassData&, FrameGraphBuilder& builder)
+		{
+			r->doFBlur = builder.Write(r->doFBlur, ResourceAccess::UnorderedAccess, SubresourceRange::Slices(1));
+			builder.Read(r->doFBlur, ResourceAccess::ShaderResource, SubresourceRange::Slices(0));
+			builder.Read(r->doFQueues[1], ResourceAccess::ShaderResource);
+			builder.Read(r->doFQueues[2], ResourceAccess::ShaderResource);
+			builder.Create<BenchmarkResource>("DoF FG Alpha", BenchmarkTexture(r->width[1], r->height[1], 1, 1, 2), ResourceAccess::UnorderedAccess);
+		});
+		AddBenchmarkPass(framegraph, "DoF Composite", [r](BenchmarkPassData&, FrameGraphBuilder& builder)
+		{
+			builder.Read(r->doFBlur, ResourceAccess::ShaderResource);
+			r->color = builder.Write(r->color, ResourceAccess::UnorderedAccess);
+		});
+
+		AddBenchmarkPass(framegraph, "Exposure", [r](BenchmarkPassData&, FrameGraphBuilder& builder)
+		{
+			builder.Read(r->color, ResourceAccess::ShaderResource);
+			r->luma = builder.Create<BenchmarkResource>("Luminance", BenchmarkTexture(r->width[0], r->height[0], 1), ResourceAccess::UnorderedAccess);
+			r->histogram = builder.Create<BenchmarkResource>("Histogram", BenchmarkBuffer(256, 4), ResourceAccess::UnorderedAccess);
+		});
+
+		AddBenchmarkPass(framegraph, "Bloom Extract", [r](BenchmarkPassData&, FrameGraphBuilder& builder)
+		{
+			builder.Read(r->color, ResourceAccess::ShaderResource);
+			builder.Read(r->histogram, ResourceAccess::ShaderResource);
+			builder.Create<BenchmarkResource>("Luma Buffer", BenchmarkTexture(r->bloomWidth, r->bloomHeight, 1), ResourceAccess::UnorderedAccess);
+			r->bloom[0] = builder.Create<BenchmarkResource>("Bloom Buffer 1", BenchmarkTexture(r->bloomWidth, r->bloomHeight, 4, 1, 2), ResourceAccess::UnorderedAccess);
+		});
+		for (std::uint32_t level = 1; level < 5; ++level)
+		{
+			AddBenchmarkPass(framegraph, "Bloom Downsample", [r, level](BenchmarkPassData&, FrameGraphBuilder& builder)
+			{
+				builder.Read(r->bloom[level - 1], ResourceAccess::ShaderResource, SubresourceRange::Slices(0));
+				r->bloom[level] = builder.Create<BenchmarkResource>("Bloom Buffer", BenchmarkTexture(r->bloomWidth >> level, r->bloomHeight >> level, 4, 1, 2), ResourceAccess::UnorderedAccess);
+			});
+		}
+		for (std::uint32_t level = 4; level > 0; --level)
+		{
+			AddBenchmarkPass(framegraph, "Bloom Upsample", [r, level](BenchmarkPassData&, FrameGraphBuilder& builder)
+			{
+				builder.Read(r->bloom[level], ResourceAccess::ShaderResource, SubresourceRange::Slices(level == 4 ? 0 : 1));
+				r->bloom[level - 1] = builder.Write(r->bloom[level - 1], ResourceAccess::UnorderedAccess, SubresourceRange::Slices(1));
+			});
+		}
+
+		AddBenchmarkPass(framegraph, "Tone Map", [r](BenchmarkPassData&, FrameGraphBuilder& builder)
+		{
+			builder.Read(r->color, ResourceAccess::ShaderResource);
+			builder.Read(r->bloom[0], ResourceAccess::ShaderResource, SubresourceRange::Slices(1));
+			builder.Read(r->histogram, ResourceAccess::ShaderResource);
+			r->postEffects = builder.Create<BenchmarkResource>("Post Effects Buffer", BenchmarkTexture(r->width[0], r->height[0], 4), ResourceAccess::UnorderedAccess);
+			r->luma = builder.Write(r->luma, ResourceAccess::UnorderedAccess);
+		});
+
+		AddBenchmarkPass(framegraph, "FXAA Pass 1", [r](BenchmarkPassData&, FrameGraphBuilder& builder)
+		{
+			builder.SetQueue(QueueType::Compute);
+			builder.Read(r->luma, ResourceAccess::ShaderResource);
+			builder.Read(r->postEffects, ResourceAccess::ShaderResource);
+			const auto workSize = r->width[0] * r->height[0] / 4 + 128;
+			r->fXAAQueues[0] = builder.Create<BenchmarkResource>("FXAA Work Queue", BenchmarkBuffer(workSize, 4), ResourceAccess::UnorderedAccess);
+			r->fXAAQueues[1] = builder.Create<BenchmarkResource>("FXAA Color Queue", BenchmarkBuffer(workSize, 4), ResourceAccess::UnorderedAccess);
+		});
+		AddBenchmarkPass(framegraph, "FXAA Pass 2", [r](BenchmarkPassData&, FrameGraphBuilder& builder)
+		{
+			builder.SetQueue(QueueType::Compute);
+			builder.Read(r->fXAAQueues[0], ResourceAccess::ShaderResource);
+			builder.Read(r->fXAAQueues[1], ResourceAccess::ShaderResource);
+			r->postEffects = builder.Write(r->postEffects, ResourceAccess::UnorderedAccess);
+		});
+
+		AddBenchmarkPass(framegraph, "Generate Mips", [r](BenchmarkPassData&, FrameGraphBuilder& builder)
+		{
+			builder.Read(r->postEffects, ResourceAccess::ShaderResource);
+			r->mips = builder.Create<BenchmarkResource>("GenMips", BenchmarkTexture(r->width[0], r->height[0], 4, 6), ResourceAccess::UnorderedAccess);
+		});
+		for (std::uint32_t mip = 1; mip < 6; ++mip)
+		{
+			AddBenchmarkPass(framegraph, "Downsample Mip", [r, mip](BenchmarkPassData&, FrameGraphBuilder& builder)
+			{
+				builder.Read(r->mips, ResourceAccess::ShaderResource, SubresourceRange::Mips(mip - 1));
+				r->mips = builder.Write(r->mips, ResourceAccess::UnorderedAccess, SubresourceRange::Mips(mip));
+			});
+		}
+		AddBenchmarkPass(framegraph, "Composite Mips", [r](BenchmarkPassData&, FrameGraphBuilder& builder)
+		{
+			builder.Read(r->mips, ResourceAccess::ShaderResource);
+			r->postEffects = builder.Write(r->postEffects, ResourceAccess::UnorderedAccess);
+		});
+
+		return resources.postEffects;
+	}
+
+	// A deferred frame at the given resolution: depth prepass, shadows, G-buffer, screen-space AO on the compute queue,
+	// lighting, transparents and TAA against a history resource, followed by the post-processing chain and a present
+	// into an imported back buffer.
+	inline void DeclareBenchmarkDeferredFrame(FrameGraph& framegraph, const std::uint32_t width, const std::uint32_t height)
+	{
+		struct Resources
+		{
+			std::uint32_t                          width[7];
+			std::uint32_t                          height[7];
+			BenchmarkResource*                     depth;
+			BenchmarkResource*                     linearDepth;
+			BenchmarkResource*                     shadow;
+			BenchmarkResource*                     gBuffer[3];
+			BenchmarkResource*                     velocity;
+			BenchmarkResource*                     depthDownsize[4];
+			BenchmarkResource*                     depthTiled;
+			BenchmarkResource*                     ao;
+			BenchmarkResource*                     color;
+			HistoryResource<BenchmarkResource>     temporal;
+			BenchmarkResource*                     backBuffer;
+		};
+		Resources resources;
+		auto r = &resources;
+		for (std::uint32_t level = 0; level < 7; ++level)
+		{
+			r->width[level] = (width + (1u << level) - 1) >> level;
+			r->height[level] = (height + (1u << level) - 1) >> level;
+		}
+		r->temporal = framegraph.AddHistoryResource<BenchmarkDescription, BenchmarkActual>("Temporal Color", BenchmarkTexture(width, height, 8));
+		r->backBuffer = framegraph.AddRetainedResource<BenchmarkDescription, BenchmarkActual>("Back Buffer", BenchmarkTexture(width, height, 4));
+
+		AddBenchmarkPass(framegraph, "Depth Prepass", [r](BenchmarkPassData&, FrameGraphBuilder& builder)
+		{
+			r->depth = builder.Create<BenchmarkResource>("Scene Depth Buffer", BenchmarkTexture(r->width[0], r->height[0], 4), ResourceAccess::DepthWrite);
+		});
+		AddBenchmarkPass(framegraph, "Shadow Map", [r](BenchmarkPassData&, FrameGraphBuilder& builder)
+		{
+			r->shadow = builder.Create<BenchmarkResource>("Shadow Map", BenchmarkTexture(2048, 2048, 2), ResourceAccess::DepthWrite);
+		});
+		AddBenchmarkPass(framegraph, "G-Buffer", [r](BenchmarkPassData&, FrameGraphBuilder& builder)
+		{
+			builder.Read(r->depth, ResourceAccess::DepthRead);
+			r->gBuffer[0] = builder.Create<BenchmarkResource>("Albedo", BenchmarkTexture(r->width[0], r->height[0], 4), ResourceAccess::RenderTarget);
+			r->gBuffer[1] = builder.Create<BenchmarkResource>("Normals Buffer", BenchmarkTexture(r->width[0], r->height[0], 8), ResourceAccess::RenderTarget);
+			r->gBuffer[2] = builder.Create<BenchmarkResource>("Material", BenchmarkTexture(r->width[0], r->height[0], 4), ResourceAccess::RenderTarget);
+			r->velocity = builder.Create<BenchmarkResource>("Motion Vectors", BenchmarkTexture(r->width[0], r->height[0], 4), ResourceAccess::RenderTarget);
+		});
+
+		AddBenchmarkPass(framegraph, "Linear Depth", [r](BenchmarkPassData&, FrameGraphBuilder& builder)
+		{
+			builder.SetQueue(QueueType::Compute);
+			builder.Read(r->depth, ResourceAccess::ShaderResource);
+			r->linearDepth = builder.Create<BenchmarkResource>("Linear Depth", BenchmarkTexture(r->width[0], r->height[0], 2), ResourceAccess::UnorderedAccess);
+		});
+		AddBenchmarkPass(framegraph, "AO Prepare Depth", [r](BenchmarkPassData&, FrameGraphBuilder& builder)
+		{
+			builder.SetQueue(QueueType::Compute);
+			builder.Read(r->linearDepth, ResourceAccess::ShaderResource);
+			for (std::uint32_t level = 0; level < 4; ++level)
+				r->depthDownsize[level] = builder.Create<BenchmarkResource>("Depth Down-Sized", BenchmarkTexture(r->width[level + 1], r->height[level + 1], 4), ResourceAccess::UnorderedAccess);
+		});
+		for (std::uint32_t level = 4; level > 0; --level)
+		{
+			AddBenchmarkPass(framegraph, "AO Render", [r, level](BenchmarkPassData&, FrameGraphBuilder& builder)
+			{
+				builder.SetQueue(QueueType::Compute);
+				builder.Read(r->depthDownsize[level - 1], ResourceAccess::ShaderResource);
+				r->depthTiled = builder.Create<BenchmarkResource>("Depth De-Interleaved", BenchmarkTexture(r->width[level + 2], r->height[level + 2], 2, 1, 16), ResourceAccess::UnorderedAccess);
+			});
+			AddBenchmarkPass(framegraph, "AO Merge", [r, level](BenchmarkPassData&, FrameGraphBuilder& builder)
+			{
+				builder.SetQueue(QueueType::Compute);
+				builder.Read(r->depthTiled, ResourceAccess::ShaderResource);
+				auto merged = builder.Create<BenchmarkResource>("AO Re-Interleaved", BenchmarkTexture(r->width[level], r->height[level], 1), ResourceAccess::UnorderedAccess);
+				if (level < 4)
+					builder.Read(r->ao, ResourceAccess::ShaderResource);
+				r->ao = merged;
+			});
+			AddBenchmarkPass(framegraph, "AO Blur And Upsample", [r, level](BenchmarkPassData&, FrameGraphBuilder& builder)
+			{
+				builder.SetQueue(QueueType::Compute);
+				builder.Read(r->ao, ResourceAccess::ShaderResource);
+				r->ao = builder.Create<BenchmarkResource>(level > 1 ? "AO Smoothed" : "SSAO Full Res", BenchmarkTexture(r->width[level - 1], r->height[level - 1], 1), ResourceAccess::UnorderedAccess);
+			});
+		}
+
+		AddBenchmarkPass(framegraph, "Lighting", [r](BenchmarkPassData&, FrameGraphBuilder& builder)
+		{
+			for (auto gBuffer : r->gBuffer)
+				builder.Read(gBuffer, ResourceAccess::ShaderResource);
+			builder.Read(r->depth, ResourceAccess::DepthRead);
+			builder.Read(r->shadow, ResourceAccess::ShaderResource);
+			builder.Read(r->ao, ResourceAccess::ShaderResource);
+			r->color = builder.Create<BenchmarkResource>("Main Color Buffer", BenchmarkTexture(r->width[0], r->height[0], 4), ResourceAccess::RenderTarget);
+		});
+		AddBenchmarkPass(framegraph, "Transparents", [r](BenchmarkPassData&, FrameGraphBuilder& builder)
+		{
+			builder.Read(r->depth, ResourceAccess::DepthRead);
+			builder.Read(r->shadow, ResourceAccess::ShaderResource);
+			r->color = builder.Write(r->color, ResourceAccess::RenderTarget);
+		});
+		AddBenchmarkPass(framegraph, "Temporal Resolve", [r](BenchmarkPassData&, FrameGraphBuilder& builder)
+		{
+			builder.Read(r->velocity, ResourceAccess::ShaderResource);
+			builder.Read(r->temporal.previous, ResourceAccess::ShaderResource);
+			builder.Read(r->color, ResourceAccess::ShaderResource);
+			r->temporal.current = builder.Write(r->temporal.current, ResourceAccess::UnorderedAccess);
+			builder.Create<BenchmarkResource>("Temporal Min Max Color", BenchmarkTexture(r->width[0], r->height[0], 4, 1, 2), ResourceAccess::UnorderedAccess);
+		});
+		AddBenchmarkPass(framegraph, "Temporal Sharpen", [r](BenchmarkPassData&, FrameGraphBuilder& builder)
+		{
+			builder.Read(r->temporal.current, ResourceAccess::ShaderResource);
+			r->color = builder.Write(r->color, ResourceAccess::UnorderedAccess);
+		});
+
+		auto postEffects = DeclareBenchmarkPostProcessing(framegraph, r->color, r->velocity, width, height);
+
+		AddBenchmarkPass(framegraph, "Present", [r, postEffects](BenchmarkPassData&, FrameGraphBuilder& builder)
+		{
+			builder.Read(postEffects, ResourceAccess::ShaderResource);
+			builder.Create<BenchmarkResource>("UI Overlay", BenchmarkTexture(r->width[0], r->height[0], 4), ResourceAccess::RenderTarget);
+			builder.Write(r->backBuffer, ResourceAccess::RenderTarget);
+		})->SetCullImmune(true);
+	}
+
+	// Just the post-processing chain, on a color and a velocity buffer imported from elsewhere.
+	inline void DeclareBenchmarkPostProcessingFrame(FrameGraph& framegraph, const std::uint32_t width, const std::uint32_t height)
+	{
+		auto color = framegraph.AddRetainedResource<BenchmarkDescription, BenchmarkActual>("Main Color Buffer", BenchmarkTexture(width, height, 4));
+		auto velocity = framegraph.AddRetainedResource<BenchmarkDescription, BenchmarkActual>("Motion Vectors", BenchmarkTexture(width, height, 4));
+		auto postEffects = DeclareBenchmarkPostProcessing(framegraph, color, velocity, width, height);
+		AddBenchmarkPass(framegraph, "Present", [postEffects](BenchmarkPassData&, FrameGraphBuilder& builder)
+		{
+			builder.Read(postEffects, ResourceAccess::ShaderResource);
+		})->SetCullImmune(true);
+	}
+
+	// A random DAG of passCount passes, the same for the same seed. Every pass creates one or two transients of random
+	// size and reads up to three earlier ones; some write over an earlier one, some go to the compute or the copy
+	// queue, and some are culled because nothing reads what they produce.
+	inline void DeclareBenchmarkRandomFrame(FrameGraph& framegraph, const std::size_t passCount, const std::uint32_t seed)
+	{
+		struct Resources
+		{
+			std::uint32_t                     state;
+			std::vector<BenchmarkResource*>&  produced;
+
+			std::uint32_t Next(const std::uint32_t bound) // xorshift32, so that graphs match across standard libraries.
+			{
+				state ^= state << 13;
+				state ^= state >> 17;
+				state ^= state << 5;
+				return state % bound;
+			}
+		};
+		// Kept across calls, so that only the framegraph counts towards the allocations per frame.
+		static thread_local std::vector<BenchmarkResource*> produced;
+		produced.clear();
+		produced.reserve(passCount * 2);
+		Resources resources{ seed != 0 ? seed : 1, produced };
+		auto r = &resources;
+
+		for (std::size_t pass = 0; pass < passCount; ++pass)
+		{
+			const auto last = pass + 1 == passCount;
+			auto renderPass = AddBenchmarkPass(framegraph, "Random Pass", [r, last](BenchmarkPassData&, FrameGraphBuilder& builder)
+			{
+				constexpr std::uint32_t kSizes[] = { 64, 256, 480, 960, 1920 };
+				const auto kind = r->Next(20);
+				const auto queue = kind == 0 ? QueueType::Copy : kind < 5 ? QueueType::Compute : QueueType::Graphics;
+				const auto read = queue == QueueType::Copy ? ResourceAccess::CopySource : ResourceAccess::ShaderResource;
+				const auto write = queue == QueueType::Copy ? ResourceAccess::CopyDest : queue == QueueType::Compute ? ResourceAccess::UnorderedAccess : ResourceAccess::RenderTarget;
+				builder.SetQueue(queue);
+
+				const auto readCount = last ? std::min<std::size_t>(r->produced.size(), 8) : r->Next(4);
+				for (std::size_t i = 0; i < readCount && !r->produced.empty(); ++i)
+					builder.Read(last ? r->produced[r->produced.size() - 1 - i] : r->produced[r->Next(std::uint32_t(r->produced.size()))], read);
+				if (!r->produced.empty() && r->Next(4) == 0)
+				{
+					auto& resource = r->produced[r->Next(std::uint32_t(r->produced.size()))];
+					resource = builder.Write(resource, write);
+				}
+				const auto createCount = last ? 0 : 1 + r->Next(2);
+				for (std::uint32_t i = 0; i < createCount; ++i)
+				{
+					const auto size = kSizes[r->Next(5)];
+					r->produced.push_back(builder.Create<BenchmarkResource>("Random Resource", BenchmarkTexture(size, size * 9 / 16, 4 << r->Next(2)), write));
+				}
+			});
+			renderPass->SetCullImmune(last);
+		}
+	}
+
+	// A chain of passCount passes, each reading what the one before created, so that none is culled.
+	inline void DeclareBenchmarkChainFrame(FrameGraph& framegraph, const std::size_t passCount)
+	{
+		struct Resources
+		{
+			BenchmarkResource* last;
+		};
+		Resources resources{ nullptr };
+		auto r = &resources;
+
+		for (std::size_t pass = 0; pass < passCount; ++pass)
+		{
+			AddBenchmarkPass(framegraph, "Chain Pass", [r](BenchmarkPassData&, FrameGraphBuilder& builder)
+			{
+				if (r->last)
+					builder.Read(r->last, ResourceAccess::ShaderResource);
+				r->last = builder.Create<BenchmarkResource>("Chain Resource", BenchmarkTexture(256, 256, 4), ResourceAccess::RenderTarget);
+			})->SetCullImmune(pass + 1 == passCount);
+		}
+	}
+
+	struct BenchmarkWorkload
+	{
+		std::string                        name;
+		std::function<void(FrameGraph&)>   declare; // Adds the passes of one frame, the same every frame.
+	};
+
+	struct BenchmarkOptions
+	{
+		std::size_t                    warmupFrames = 8;
+		std::size_t                    frames       = 100;
+		std::size_t                    workers      = 1; // More than one executes through a WorkerPool.
+		bool                           reorderPasses = false;
+		std::function<std::size_t()>   allocationCount; // Heap allocations so far, if the program counts them.
+	};
+
+	struct BenchmarkResult
+	{
+		std::string   workload;
+		std::size_t   passes               = 0;
+		std::size_t   resources            = 0; // First versions, imported ones included.
+		double        setupMs              = 0.0; // Declaring the passes and clearing them afterwards, per frame.
+		double        compileMs            = 0.0; // Per frame, hitting the compilation cache.
+		double        uncachedCompileMs    = 0.0; // Per frame, with the cache invalidated.
+		double        executeMs            = 0.0; // Per frame, recording into the null recorder.
+		double        allocationsPerFrame  = -1.0; // Negative when not counted.
+		std::size_t   transientBytes       = 0; // The aliased transient heaps.
+		std::size_t   unaliasedBytes       = 0;
+		std::size_t   peakLiveBytes        = 0;
+		std::size_t   barriers             = 0;
+		std::size_t   submissions          = 0;
+	};
+
+	// Runs a workload for the warm-up frames, then times the phases of the frames after them. Compilation is timed
+	// twice, with and without the cache, as the cached path is what runs every frame and the uncached one is what
+	// changes when the compiler does.
+	inline BenchmarkResult RunBenchmark(const BenchmarkWorkload& workload, const BenchmarkOptions& options = BenchmarkOptions())
+	{
+		using Clock = std::chrono::steady_clock;
+		const auto milliseconds = [](const Clock::duration duration) { return std::chrono::duration<double, std::milli>(duration).count(); };
+
+		FrameGraph framegraph;
+		framegraph.SetReorderPasses(options.reorderPasses);
+		NullCommandRecorder recorder;
+		std::unique_ptr<WorkerPool> workers = options.workers > 1 ? std::make_unique<WorkerPool>(options.workers) : nullptr;
+		const auto executeFrame = [&]()
+		{
+			if (workers)
+				framegraph.Execute(recorder, *workers);
+			else
+				framegraph.Execute(recorder);
+		};
+
+		BenchmarkResult result;
+		result.workload = workload.name;
+
+		for (std::size_t frame = 0; frame < options.warmupFrames; ++frame)
+		{
+			workload.declare(framegraph);
+			framegraph.Compile();
+			executeFrame();
+			framegraph.Clear();
+		}
+
+		Clock::duration setupTime{}, compileTime{}, executeTime{}, uncachedCompileTime{};
+		const auto allocationsBefore = options.allocationCount ? options.allocationCount() : 0;
+		for (std::size_t frame = 0; frame < options.frames; ++frame)
+		{
+			auto time = Clock::now();
+			workload.declare(framegraph);
+			auto next = Clock::now();
+			setupTime += next - time;
+
+			time = next;
+			framegraph.Compile();
+			next = Clock::now();
+			compileTime += next - time;
+
+			time = next;
+			executeFrame();
+			next = Clock::now();
+			executeTime += next - time;
+
+			if (frame + 1 == options.frames)
+			{
+				result.passes = framegraph.PassCount();
+				result.resources = framegraph.ResourceCount();
+				result.transientBytes = framegraph.TransientMemory().aliasedBytes;
+				result.unaliasedBytes = framegraph.TransientMemory().unaliasedBytes;
+				result.peakLiveBytes = framegraph.TransientMemory().peakLiveBytes;
+				result.barriers = framegraph.BarrierCounts().emitted;
+				result.submissions = framegraph.SubmissionsPerFrame();
+			}
+
+			time = Clock::now();
+			framegraph.Clear();
+			setupTime += Clock::now() - time;
+		}
+		if (options.allocationCount)
+			result.allocationsPerFrame = double(options.allocationCount() - allocationsBefore) / double(std::max<std::size_t>(options.frames, 1));
+
+		for (std::size_t frame = 0; frame < options.frames; ++frame)
+		{
+			workload.declare(framegraph);
+			framegraph.InvalidateCompilationCache();
+			const auto time = Clock::now();
+			framegraph.Compile();
+			uncachedCompileTime += Clock::now() - time;
+			executeFrame();
+			framegraph.Clear();
+		}
+
+		const auto frames = double(std::max<std::size_t>(options.frames, 1));
+		result.setupMs = milliseconds(setupTime) / frames;
+		result.compileMs = milliseconds(compileTime) / frames;
+		result.uncachedCompileMs = milliseconds(uncachedCompileTime) / frames;
+		result.executeMs = milliseconds(executeTime) / frames;
+		return result;
+	}
+
+	inline std::vector<BenchmarkWorkload> DefaultBenchmarkWorkloads()
+	{
+		return std::vector<BenchmarkWorkload>
+		{
+			{ "Deferred 1080p", [](FrameGraph& framegraph) { DeclareBenchmarkDeferredFrame(framegraph, 1920, 1080); } },
+			{ "Deferred 4K", [](FrameGraph& framegraph) { DeclareBenchmarkDeferredFrame(framegraph, 3840, 2160); } },
+			{ "Post chain 1440p", [](FrameGraph& framegraph) { DeclareBenchmarkPostProcessingFrame(framegraph, 2560, 1440); } },
+			{ "Random 64", [](FrameGraph& framegraph) { DeclareBenchmarkRandomFrame(framegraph, 64, 1); } },
+			{ "Random 256", [](FrameGraph& framegraph) { DeclareBenchmarkRandomFrame(framegraph, 256, 2); } },
+			{ "Random 1024", [](FrameGraph& framegraph) { DeclareBenchmarkRandomFrame(framegraph, 1024, 3); } },
+		};
+	}
+
+	// One line per result, as comma-separated values with a header, so that CI can keep and compare them.
+	inline void WriteBenchmarkResults(std::ostream& stream, const std::vector<BenchmarkResult>& results)
+	{
+		stream << "workload,passes,resources,setup_ms,compile_ms,uncached_compile_ms,execute_ms,allocations_per_frame,transient_bytes,unaliased_bytes,peak_live_bytes,barriers,submissions\n";
+		for (auto& result : results)
+		{
+			stream << result.workload << ',' << result.passes << ',' << result.resources << ','
+				<< std::fixed << std::setprecision(4) << result.setupMs << ',' << result.compileMs << ',' << result.uncachedCompileMs << ',' << result.executeMs << ','
+				<< std::setprecision(1) << result.allocationsPerFrame << ',' << std::defaultfloat
+				<< result.transientBytes << ',' << result.unaliasedBytes << ',' << result.peakLiveBytes << ',' << result.barriers << ',' << result.submissions << '\n';
+		}
+	}
+
+	inline std::vector<BenchmarkResult> RunFrameGraphBenchmarks(std::ostream& stream, const BenchmarkOptions& options = BenchmarkOptions())
+	{
+		std::vector<BenchmarkResult> results;
+		for (auto& workload : DefaultBenchmarkWorkloads())
+			results.push_back(RunBenchmark(workload, options));
+		WriteBenchmarkResults(stream, results);
+		return results;
+	}
+
+	// How the compiler scales with the graph: the uncached compile time of chains and random graphs of 10 to 10,000
+	// passes, as comma-separated values with a header. Most passes of a random graph are culled, none of a chain.
+	// Setup and execution are left out; see RunFrameGraphBenchmarks() for those.
+	inline void RunCompileSweep(std::ostream& stream, const std::size_t frames = 10)
+	{
+		using Clock = std::chrono::steady_clock;
+
+		stream << "graph,passes,live_passes,resources,uncached_compile_ms\n";
+		for (const auto chain : { true, false })
+		for (const std::size_t passCount : { 10, 30, 100, 300, 1000, 3000, 10000 })
+		{
+			FrameGraph framegraph;
+			NullCommandRecorder recorder;
+			Clock::duration compileTime{};
+			std::size_t livePasses = 0;
+			std::size_t resources = 0;
+			for (std::size_t frame = 0; frame < std::max<std::size_t>(frames, 1); ++frame)
+			{
+				if (chain)
+					DeclareBenchmarkChainFrame(framegraph, passCount);
+				else
+					DeclareBenchmarkRandomFrame(framegraph, passCount, std::uint32_t(passCount));
+				framegraph.InvalidateCompilationCache();
+				const auto time = Clock::now();
+				framegraph.Compile();
+				compileTime += Clock::now() - time;
+				framegraph.Execute(recorder);
+				livePasses = framegraph.StepTimings().size();
+				resources = framegraph.ResourceCount();
+				framegraph.Clear();
+			}
+
+			stream << (chain ? "chain," : "random,") << passCount << ',' << livePasses << ',' << resources << ',' << std::fixed << std::setprecision(4)
+				<< std::chrono::duration<double, std::milli>(compileTime).count() / double(std::max<std::size_t>(frames, 1)) << std::defaultfloat << '\n';
+		}
+	}
+}
+
+#endif
@@ -2,7 +2,9 @@
 #ifndef FG_RENDER_GRAPH_PASS_BUILDER_HPP_
 #define FG_RENDER_GRAPH_PASS_BUILDER_HPP_
 
-#include <string>
+#include <string_view>
+
+#include "ResourceAccess.hpp"
 
 namespace FG
 {
@@ -24,12 +26,22 @@ namespace FG
 		FrameGraphBuilder& operator=(const FrameGraphBuilder& that) = default;
 		FrameGraphBuilder& operator=(FrameGraphBuilder&& temp) = default;
 
+		// The access tells the framegraph which state the pass needs the resource in. With ResourceAccess::None the
+		// pass transitions the resource itself, which it should then do for the whole resource. Reads and writes may be
+		// limited to a range of mips and array slices; passes touching disjoint ranges of a resource do not depend on
+		// each other, and their barriers only cover their ranges.
 		template<typename ResourceType, typename DescriptionType> 
-		ResourceType* Create(const std::string& name, const DescriptionType& description);
+		ResourceType* Create(std::string_view name, const DescriptionType& description, ResourceAccess access = ResourceAccess::None);
 		template<typename ResourceType>
-		ResourceType* Read(ResourceType* resource);
+		ResourceType* Read(ResourceType* resource, ResourceAccess access = ResourceAccess::None, const SubresourceRange& range = SubresourceRange());
+		// Writing makes a new version of the resource and returns it; reads of the versions before are ordered ahead of
+		// the write where their ranges overlap. A write always goes over the latest version. A pass must therefore not
+		// read an old version that a pass it depends on has written over, as the two can then not be ordered; see
+		// FrameGraph::CyclicPasses().
 		template<typename ResourceType>
-		ResourceType* Write(ResourceType* resource);
+		ResourceType* Write(ResourceType* resource, ResourceAccess access = ResourceAccess::None, const SubresourceRange& range = SubresourceRange());
+		// Asks for the pass to be submitted to another queue than the graphics queue.
+		void SetQueue(QueueType queue);
 
 	protected:
 		FrameGraph*          _framegraph;
@@ -0,0 +1,138 @@
+#pragma once
+#ifndef FG_FRAME_GRAPH_HISTORY_HPP_
+#define FG_FRAME_GRAPH_HISTORY_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Realize.hpp"
+
+namespace FG
+{
+	class FrameGraph;
+
+	// The backing of a history resource: a ring of actuals the framegraph keeps across frames. Every frame one of them
+	// is written and the one written the frame before is read; Clear() moves the ring on.
+	class FrameGraphHistoryBase
+	{
+	public:
+		explicit FrameGraphHistoryBase(const std::string_view name, const std::size_t count)
+			: _name(name), _previousName(std::string(name) + " (previous)"), _count(count), _current(0), _frames(0), _fence(0), _used(false)
+		{
+
+		}
+		FrameGraphHistoryBase(const FrameGraphHistoryBase& that) = delete;
+		FrameGraphHistoryBase(FrameGraphHistoryBase&& temp) = default;
+		virtual ~FrameGraphHistoryBase() = default;
+		FrameGraphHistoryBase& operator=(const FrameGraphHistoryBase& that) = delete;
+		FrameGraphHistoryBase& operator=(FrameGraphHistoryBase&& temp) = default;
+
+		const std::string& Name() const
+		{
+			return _name;
+		}
+		std::size_t Count() const
+		{
+			return _count;
+		}
+		// False until a frame has written the backing, e.g. on the first frame or after the description changed.
+		bool PreviousValid() const
+		{
+			return _frames > 0;
+		}
+
+	protected:
+		friend FrameGraph;
+
+		// Hands the actuals back through DeRealize(), tagged with the fence of the last submission using them.
+		virtual void Release() = 0;
+
+		void Advance()
+		{
+			_current = (_current + 1) % _count;
+			_frames++;
+			_used = false;
+		}
+		std::size_t Previous() const
+		{
+			return (_current + _count - 1) % _count;
+		}
+
+		std::string    _name;
+		std::string    _previousName;
+		std::size_t    _count;
+		std::size_t    _current; // The actual written this frame.
+		std::size_t    _frames; // Frames written since the actuals were realized.
+		std::uint64_t  _fence; // Of the last submission that used the history.
+		bool           _used; // Added to the current frame.
+	};
+
+	template<typename _DescriptionType, typename _ActualType>
+	class FrameGraphHistory : public FrameGraphHistoryBase
+	{
+	public:
+		using DescriptionType = _DescriptionType;
+		using ActualType = _ActualType;
+
+		explicit FrameGraphHistory(const std::string_view name, const DescriptionType& description, const std::size_t count)
+			: FrameGraphHistoryBase(name, count), _description(description)
+		{
+			Realize();
+		}
+		FrameGraphHistory(const FrameGraphHistory& that) = delete;
+		FrameGraphHistory(FrameGraphHistory&& temp) = default;
+		~FrameGraphHistory()
+		{
+			Release();
+		}
+		FrameGraphHistory& operator=(const FrameGraphHistory& that) = delete;
+		FrameGraphHistory& operator=(FrameGraphHistory&& temp) = default;
+
+		const DescriptionType& Description() const
+		{
+			return _description;
+		}
+
+	protected:
+		friend FrameGraph;
+
+		void Realize()
+		{
+			for (std::size_t i = 0; i < _count; ++i)
+				_actuals.push_back(FG::Realize<DescriptionType, ActualType>(_description));
+			_current = 0;
+			_frames = 0;
+		}
+		void Release() override
+		{
+			for (auto& actual : _actuals)
+				FG::DeRealize<DescriptionType, ActualType>(_description, actual, _fence);
+			_actuals.clear();
+		}
+		// Starts over with new actuals when the description changes, e.g. on a resize.
+		void Reset(const DescriptionType& description, const std::size_t count)
+		{
+			Release();
+			_description = description;
+			_count = count;
+			Realize();
+		}
+
+		DescriptionType                           _description;
+		std::vector<std::unique_ptr<ActualType>>  _actuals;
+	};
+
+	template<typename ResourceType>
+	struct HistoryResource
+	{
+		ResourceType*  current;       // Written this frame, read as previous next frame.
+		ResourceType*  previous;      // Written last frame; its content is only defined if previousValid.
+		bool           previousValid;
+	};
+}
+
+#endif
@@ -2,10 +2,12 @@
 #ifndef FG_FRAME_GRAPH_PASS_HPP_
 #define FG_FRAME_GRAPH_PASS_HPP_
 
-#include <functional>
-#include <string>
+#include <memory_resource>
+#include <string_view>
+#include <utility>
 
 #include "FrameGraphPassBase.hpp"
+#include "InplaceFunction.hpp"
 
 namespace FG
 {
@@ -17,10 +19,13 @@ namespace FG
 	public:
 		using DataType = _DataType;
 
+		template<typename SetupType, typename ExecuteType>
 		explicit FrameGraphPass(
-			const std::string& name,
-			const std::function<void(DataType&, FrameGraphBuilder&)>& setup,
-			const std::function<int(const DataType&)>& execute) : FrameGraphPassBase(name), _setup(setup), _execute(execute)
+			const std::string_view name,
+			SetupType&& setup,
+			ExecuteType&& execute,
+			std::pmr::memory_resource* memory = std::pmr::get_default_resource()) :
+			FrameGraphPassBase(name, memory), _setup(std::forward<SetupType>(setup)), _execute(std::forward<ExecuteType>(execute))
 		{
 
 		}
@@ -40,14 +45,14 @@ namespace FG
 		{
 			_setup(_data, builder);
 		}
-		int Execute() const override
+		void Execute(CommandContext& context) const override
 		{
-			return _execute(_data);
+			_execute(_data, context);
 		}
 
-		DataType                                                     _data;
-		const std::function<void(DataType&, FrameGraphBuilder&)>     _setup;
-		const std::function<int(const DataType&)>                    _execute;
+		DataType                                                       _data;
+		const InplaceFunction<void(DataType&, FrameGraphBuilder&)>     _setup;
+		const InplaceFunction<void(const DataType&, CommandContext&)>  _execute;
 	};
 }
 
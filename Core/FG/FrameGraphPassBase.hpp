@@ -3,20 +3,25 @@
 #define FG_FRAME_GRAPH_PASS_BASE_HPP_
 
 #include <cstddef>
+#include <memory_resource>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "ResourceAccess.hpp"
+
 namespace FG
 {
 	class FrameGraph;
 	class FrameGraphResourceBase;
-	//class FrameGraphBuilder;
+	class FrameGraphBuilder;
 
 	class FrameGraphPassBase
 	{
 	public:
-		explicit FrameGraphPassBase(const std::string& name) :
-			_name(name), _cullImmune(false), _refCount(0)
+		// The name and the edge lists are allocated from memory, the arena of the owning framegraph.
+		explicit FrameGraphPassBase(const std::string_view name, std::pmr::memory_resource* memory = std::pmr::get_default_resource()) :
+			_name(name, memory), _cullImmune(false), _queue(QueueType::Graphics), _index(0), _creates(memory), _reads(memory), _writes(memory), _accesses(memory), _refCount(0)
 		{
 
 		}
@@ -26,11 +31,11 @@ namespace FG
 		FrameGraphPassBase& operator=(const FrameGraphPassBase& that) = delete;
 		FrameGraphPassBase& operator=(FrameGraphPassBase&& temp) = default;
 
-		const std::string& Name() const
+		std::string_view Name() const
 		{
 			return _name;
 		}
-		void SetName(const std::string& name)
+		void SetName(const std::string_view name)
 		{
 			_name = name;
 		}
@@ -44,19 +49,39 @@ namespace FG
 			_cullImmune = cullImmune;
 		}
 
+		// The queue the pass is submitted to. Takes effect on the next Compile().
+		QueueType Queue() const
+		{
+			return _queue;
+		}
+		void SetQueue(const QueueType queue)
+		{
+			_queue = queue;
+		}
+
 	protected:
 		friend class FrameGraph;
 		friend class FrameGraphBuilder;
 
+		struct Access
+		{
+			const FrameGraphResourceBase*  resource;
+			ResourceAccess                 access;
+			SubresourceRange               range;
+		};
+
 		virtual void Setup(FrameGraphBuilder& builder) = 0;
-		virtual int Execute() const = 0;
-
-		std::string                                 _name;
-		bool                                        _cullImmune;
-		std::vector<const FrameGraphResourceBase*>  _creates;
-		std::vector<const FrameGraphResourceBase*>  _reads;
-		std::vector<const FrameGraphResourceBase*>  _writes;
-		std::size_t                                 _refCount; // Computed through framegraph compilation.
+		virtual void Execute(CommandContext& context) const = 0;
+
+		std::pmr::string                                 _name;
+		bool                                             _cullImmune;
+		QueueType                                        _queue;
+		std::size_t                                      _index; // Position in the owning framegraph.
+		std::pmr::vector<FrameGraphResourceBase*>        _creates;
+		std::pmr::vector<FrameGraphResourceBase*>        _reads; // Versions read, including the ones written over.
+		std::pmr::vector<FrameGraphResourceBase*>        _writes; // Versions written.
+		std::pmr::vector<Access>                         _accesses; // Creates, reads and writes in declaration order.
+		std::size_t                                      _refCount; // Computed through framegraph compilation.
 	};
 }
 
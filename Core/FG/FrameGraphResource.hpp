@@ -2,11 +2,17 @@
 #ifndef FG_RESOURCE_HPP_
 #define FG_RESOURCE_HPP_
 
+#include <cstdint>
 #include <memory>
-#include <string>
+#include <memory_resource>
+#include <string_view>
+#include <typeinfo>
 #include <variant>
 
+#include "DescriptionHash.hpp"
 #include "Realize.hpp"
+#include "ResourceAccess.hpp"
+#include "TransientAliasing.hpp"
 #include "FrameGraphResourceBase.hpp"
 
 namespace FG
@@ -20,17 +26,22 @@ namespace FG
 		using DescriptionType = _DescriptionType;
 		using ActualType = _ActualType;
 
-		explicit FrameGraphResource(const std::string& name, const FrameGraphPassBase* creator, const DescriptionType& description)
-			: FrameGraphResourceBase(name, creator), _description(description), _actual(std::unique_ptr<ActualType>())
+		explicit FrameGraphResource(const std::string_view name, const FrameGraphPassBase* creator, const DescriptionType& description, std::pmr::memory_resource* memory = std::pmr::get_default_resource())
+			: FrameGraphResourceBase(name, creator, memory), _description(description), _actual(std::unique_ptr<ActualType>())
 		{
 			// Transient (normal) constructor.
 		}
-		explicit FrameGraphResource(const std::string& name, const DescriptionType& description, ActualType* actual = nullptr)
-			: FrameGraphResourceBase(name, nullptr), _description(description), _actual(actual)
+		explicit FrameGraphResource(const std::string_view name, const DescriptionType& description, ActualType* actual = nullptr, std::pmr::memory_resource* memory = std::pmr::get_default_resource())
+			: FrameGraphResourceBase(name, nullptr, memory), _description(description), _actual(actual)
 		{
 			// Retained (import) constructor.
 			if (!actual) _actual = FG::Realize<DescriptionType, ActualType>(_description);
 		}
+		explicit FrameGraphResource(FrameGraphResource& previous, const FrameGraphPassBase* producer, const SubresourceRange& range, std::pmr::memory_resource* memory = std::pmr::get_default_resource())
+			: FrameGraphResourceBase(previous, producer, range, memory), _description(previous._description), _actual(static_cast<ActualType*>(nullptr))
+		{
+			// Version constructor. The actual resource stays with the first version.
+		}
 		FrameGraphResource(const FrameGraphResource& that) = delete;
 		FrameGraphResource(FrameGraphResource&& temp) = default;
 		~FrameGraphResource() = default;
@@ -43,18 +54,51 @@ namespace FG
 		}
 		ActualType* Actual() const // If transient, only valid through the realized interval of the resource.
 		{
+			if (_origin != this)
+				return static_cast<const FrameGraphResource*>(_origin)->Actual();
 			return std::holds_alternative<std::unique_ptr<ActualType>>(_actual) ? std::get<std::unique_ptr<ActualType>>(_actual).get() : std::get<ActualType*>(_actual);
 		}
 
 	protected:
 		void Realize() override
 		{
-			if (Transient()) std::get<std::unique_ptr<ActualType>>(_actual) = FG::Realize<DescriptionType, ActualType>(_description);
+			if (!Transient())
+				return;
+			auto& actual = std::get<std::unique_ptr<ActualType>>(_actual);
+			if (_placement.heap != kUnplacedHeap)
+				actual = FG::RealizePlaced<DescriptionType, ActualType>(_description, _placement);
+			else
+				actual = FG::Realize<DescriptionType, ActualType>(_description);
+		}
+		void DeRealize(std::uint64_t fence) override
+		{
+			if (!Transient())
+				return;
+			auto& actual = std::get<std::unique_ptr<ActualType>>(_actual);
+			if (_placement.heap != kUnplacedHeap)
+				FG::DeRealizePlaced<DescriptionType, ActualType>(_description, _placement, actual, fence);
+			else
+				FG::DeRealize<DescriptionType, ActualType>(_description, actual, fence);
+		}
+		void Activate(CommandContext& context) override
+		{
+			if (auto actual = Actual()) FG::Activate<DescriptionType, ActualType>(context, *actual);
+		}
+		void Transition(CommandContext& context, ResourceAccess before, ResourceAccess after, const SubresourceRange& range, BarrierPhase phase) override
+		{
+			if (auto actual = Actual()) FG::Transition<DescriptionType, ActualType>(context, *actual, before, after, range, phase);
+		}
+		TransientMemoryRequirements MemoryRequirements() const override
+		{
+			return FG::MemoryRequirements<DescriptionType, ActualType>(_description);
+		}
+		std::size_t DescriptionHash() const override
+		{
+			return FG::HashCombine(typeid(DescriptionType).hash_code(), FG::HashDescription(_description));
 		}
-		void DeRealize(int fence) override
+		SubresourceLayout Subresources() const override
 		{
-			//if (Transient()) std::get<std::unique_ptr<ActualType>>(_actual).reset();
-			if (Transient()) FG::DeRealize(std::get<std::unique_ptr<ActualType>(_actual), fence));
+			return FG::Subresources<DescriptionType, ActualType>(_description);
 		}
 
 		DescriptionType                                         _description;
@@ -3,23 +3,38 @@
 #define FG_RESOURCE_BASE_HPP_
 
 #include <cstddef>
+#include <cstdint>
+#include <memory_resource>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "ResourceAccess.hpp"
+#include "TransientAliasing.hpp"
+
 namespace FG
 {
 	class FrameGraph;
+	class FrameGraphHistoryBase;
 	class FrameGraphPassBase;
 	
 	class FrameGraphResourceBase
 	{
 	public:
-		explicit FrameGraphResourceBase(const std::string& name, const FrameGraphPassBase* creator)
-			: _name(name), _creator(creator), _refCount(0)
+		// The name and the edge lists are allocated from memory, the arena of the owning framegraph.
+		explicit FrameGraphResourceBase(const std::string_view name, const FrameGraphPassBase* creator, std::pmr::memory_resource* memory = std::pmr::get_default_resource())
+			: _name(name, memory), _creator(creator), _producer(creator), _origin(this), _previous(nullptr), _next(nullptr), _version(0), _index(0), _history(nullptr), _readers(memory), _refCount(0)
 		{
 			static std::size_t id = 0;
 			_id = id++;
 		}
+		// A new version of the resource, written over the range of subresources of previous by producer. It shares the
+		// actual resource of the first version.
+		explicit FrameGraphResourceBase(FrameGraphResourceBase& previous, const FrameGraphPassBase* producer, const SubresourceRange& range, std::pmr::memory_resource* memory = std::pmr::get_default_resource())
+			: _id(previous._id), _name(previous._name, memory), _creator(previous._creator), _producer(producer), _origin(previous._origin), _previous(&previous), _next(nullptr), _version(previous._version + 1), _range(range), _index(previous._index), _history(previous._history), _readers(memory), _refCount(0)
+		{
+			previous._next = this;
+		}
 		FrameGraphResourceBase(const FrameGraphResourceBase& that) = delete;
 		FrameGraphResourceBase(FrameGraphResourceBase&& temp) = default;
 		virtual ~FrameGraphResourceBase() = default;
@@ -31,11 +46,11 @@ namespace FG
 			return _id;
 		}
 
-		const std::string& Name() const
+		std::string_view Name() const
 		{
 			return _name;
 		}
-		void SetName(const std::string& name)
+		void SetName(const std::string_view name)
 		{
 			_name = name;
 		}
@@ -45,19 +60,74 @@ namespace FG
 			return _creator != nullptr;
 		}
 
+		// Every write makes a new version; the first version is the one created or retained.
+		std::size_t Version() const
+		{
+			return _version;
+		}
+		const FrameGraphResourceBase* PreviousVersion() const
+		{
+			return _previous;
+		}
+		const FrameGraphResourceBase* NextVersion() const
+		{
+			return _next;
+		}
+		// The subresources the producer of this version wrote; the others keep the content of the previous version.
+		const SubresourceRange& WrittenRange() const
+		{
+			return _range;
+		}
+
+		// Where compilation placed the transient in the aliased heaps, or kUnplacedHeap when it was not aliased.
+		const TransientPlacement& Placement() const
+		{
+			return _placement;
+		}
+
 	protected:
 		friend FrameGraph;
 		friend FrameGraphBuilder;
 
 		virtual void Realize() = 0;
-		virtual void DeRealize(int fence) = 0;
-
-		std::size_t                             _id;
-		std::string                             _name;
-		const FrameGraphPassBase*               _creator;
-		std::vector<const FrameGraphPassBase*>  _readers;
-		std::vector<const FrameGraphPassBase*>  _writers;
-		std::size_t                             _refCount; // Computed through framegraph compilation.
+		virtual void DeRealize(std::uint64_t fence) = 0;
+		virtual void Activate(CommandContext& context) = 0; // Only called for placed transients.
+		virtual void Transition(CommandContext& context, ResourceAccess before, ResourceAccess after, const SubresourceRange& range, BarrierPhase phase) = 0;
+		virtual TransientMemoryRequirements MemoryRequirements() const = 0;
+		virtual std::size_t DescriptionHash() const = 0;
+		virtual SubresourceLayout Subresources() const = 0;
+
+		// A pass reading a range of this version, or a writer reading the range it goes over.
+		struct Reader
+		{
+			const FrameGraphPassBase*  pass;
+			SubresourceRange           range;
+			std::size_t                version; // The version the pass read, this one or a later one that left the range alone.
+			bool                       write;
+		};
+
+		FrameGraphResourceBase* LatestVersion()
+		{
+			auto version = this;
+			while (version->_next)
+				version = version->_next;
+			return version;
+		}
+
+		std::size_t                                  _id; // Shared by all versions.
+		std::pmr::string                             _name;
+		const FrameGraphPassBase*                    _creator;
+		const FrameGraphPassBase*                    _producer; // The creator or the writer of this version, none for a retained first version.
+		FrameGraphResourceBase*                      _origin; // The first version, which owns the actual resource.
+		FrameGraphResourceBase*                      _previous;
+		FrameGraphResourceBase*                      _next;
+		std::size_t                                  _version;
+		SubresourceRange                             _range; // Written by the producer; all of them for a first version.
+		std::size_t                                  _index; // Position of the first version in the owning framegraph, shared by all versions.
+		FrameGraphHistoryBase*                       _history; // The backing the resource was imported from, if it is a history resource.
+		std::pmr::vector<Reader>                     _readers; // Including the writers of later versions that go over this one.
+		std::size_t                                  _refCount; // Computed through framegraph compilation.
+		TransientPlacement                           _placement; // Computed through framegraph compilation.
 	};
 
 
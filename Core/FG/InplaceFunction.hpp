@@ -0,0 +1,59 @@
+#pragma once
+#ifndef FG_INPLACE_FUNCTION_HPP_
+#define FG_INPLACE_FUNCTION_HPP_
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace FG
+{
+	template<typename SignatureType, std::size_t Capacity = 64>
+	class InplaceFunction;
+
+	// A callable wrapper like std::function that keeps the callable in a fixed buffer instead of on the heap. Callables
+	// larger than Capacity do not compile; capture by reference or through a pointer instead.
+	template<typename ResultType, typename... ArgumentTypes, std::size_t Capacity>
+	class InplaceFunction<ResultType(ArgumentTypes...), Capacity>
+	{
+	public:
+		template<typename CallableType, typename = std::enable_if_t<!std::is_same<std::decay_t<CallableType>, InplaceFunction>::value>>
+		InplaceFunction(CallableType&& callable)
+		{
+			using StoredType = std::decay_t<CallableType>;
+			static_assert(sizeof(StoredType) <= Capacity, "The callable does not fit into the InplaceFunction.");
+			static_assert(alignof(StoredType) <= alignof(std::max_align_t), "The callable is overaligned for the InplaceFunction.");
+
+			new (&_storage) StoredType(std::forward<CallableType>(callable));
+			_invoke = [](void* storage, ArgumentTypes... arguments) -> ResultType
+			{
+				return (*static_cast<StoredType*>(storage))(std::forward<ArgumentTypes>(arguments)...);
+			};
+			_destroy = [](void* storage)
+			{
+				static_cast<StoredType*>(storage)->~StoredType();
+			};
+		}
+		InplaceFunction(const InplaceFunction& that) = delete;
+		InplaceFunction(InplaceFunction&& temp) = delete;
+		~InplaceFunction()
+		{
+			_destroy(&_storage);
+		}
+		InplaceFunction& operator=(const InplaceFunction& that) = delete;
+		InplaceFunction& operator=(InplaceFunction&& temp) = delete;
+
+		ResultType operator()(ArgumentTypes... arguments) const
+		{
+			return _invoke(&_storage, std::forward<ArgumentTypes>(arguments)...);
+		}
+
+	protected:
+		mutable std::aligned_storage_t<Capacity, alignof(std::max_align_t)>  _storage;
+		ResultType                                                           (*_invoke)(void*, ArgumentTypes...);
+		void                                                                 (*_destroy)(void*);
+	};
+}
+
+#endif
@@ -0,0 +1,140 @@
+#pragma once
+#ifndef FG_QUEUE_SCHEDULER_HPP_
+#define FG_QUEUE_SCHEDULER_HPP_
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+#include "BarrierPlanner.hpp"
+
+namespace FG
+{
+	struct QueueWait
+	{
+		QueueType    queue; // The queue the awaited step is submitted to.
+		std::size_t  step;
+	};
+
+	struct QueueSchedule
+	{
+		std::array<std::vector<std::size_t>, kQueueTypeCount>  timelines; // Per queue: its steps in submission order.
+		std::vector<std::vector<QueueWait>>                    waits;     // Per step: the steps its queue waits for first.
+		std::size_t                                            waitCount = 0;
+	};
+
+	// Splits the steps into one timeline per queue and places the cross-queue waits. A step depends on the earlier
+	// steps it conflicts with on some resource, under the same rule as the recording levels. Dependencies on the same
+	// queue are kept by submission order; for the others the step's queue waits on the latest producer per queue,
+	// unless an earlier wait already covers it, since waiting on a fence also covers everything that submission waited
+	// for in turn. A step with handoff barriers (handoffSteps, empty for none) already waits for its handoff, which is
+	// submitted to the graphics queue after everything before it there.
+	inline QueueSchedule ScheduleQueues(const std::size_t resourceCount, const std::vector<std::vector<ResourceUse>>& steps, const std::vector<QueueType>& stepQueues, const std::vector<bool>& handoffSteps = {})
+	{
+		// Per resource: the run of steps sharing an identical read (or the last writer alone), and the run before it.
+		std::vector<std::vector<std::size_t>> users(resourceCount);
+		std::vector<std::vector<std::size_t>> predecessors(resourceCount);
+		std::vector<ResourceAccess> readAccesses(resourceCount, ResourceAccess::None);
+
+		// Per queue and per step: one past the latest step of each queue known to be complete, or ordered before it on
+		// the same queue, once the queue gets there.
+		using Progress = std::array<std::size_t, kQueueTypeCount>;
+		std::array<Progress, kQueueTypeCount> queueProgress{};
+		std::vector<Progress> stepProgress(steps.size());
+
+		QueueSchedule schedule;
+		schedule.waits.resize(steps.size());
+		std::vector<ResourceUse> uses;
+		std::vector<std::size_t> dependencies;
+		for (std::size_t step = 0; step < steps.size(); ++step)
+		{
+			const auto queue = stepQueues[step];
+			const auto queueIndex = std::size_t(queue);
+
+			MergeResourceUses(steps[step], uses);
+			dependencies.clear();
+			for (auto& use : uses)
+			{
+				const auto resource = use.resource;
+				if (use.access != ResourceAccess::None && readAccesses[resource] == use.access)
+				{
+					dependencies.insert(dependencies.end(), predecessors[resource].begin(), predecessors[resource].end());
+					users[resource].push_back(step);
+					continue;
+				}
+
+				dependencies.insert(dependencies.end(), users[resource].begin(), users[resource].end());
+				predecessors[resource] = std::move(users[resource]);
+				users[resource].assign(1, step);
+				readAccesses[resource] = IsWriteAccess(use.access) ? ResourceAccess::None : use.access;
+			}
+
+			auto& progress = queueProgress[queueIndex];
+			if (step < handoffSteps.size() && handoffSteps[step])
+				for (std::size_t i = 0; i < kQueueTypeCount; ++i)
+					progress[i] = std::max(progress[i], queueProgress[std::size_t(QueueType::Graphics)][i]);
+
+			// Latest first, so a wait on a late producer can cover the earlier ones.
+			std::sort(dependencies.begin(), dependencies.end(), std::greater<std::size_t>());
+			for (auto dependency : dependencies)
+			{
+				const auto producerQueue = std::size_t(stepQueues[dependency]);
+				if (progress[producerQueue] > dependency)
+					continue;
+
+				schedule.waits[step].push_back(QueueWait{ stepQueues[dependency], dependency });
+				schedule.waitCount++;
+				for (std::size_t i = 0; i < kQueueTypeCount; ++i)
+					progress[i] = std::max(progress[i], stepProgress[dependency][i]);
+			}
+
+			progress[queueIndex] = step + 1;
+			stepProgress[step] = progress;
+			schedule.timelines[queueIndex].push_back(step);
+		}
+		return schedule;
+	}
+
+	// Groups consecutive steps into batches, each recorded into one context and submitted at once. Returns the batch of
+	// every step. A batch ends at a queue switch and after maxBatchSize steps (0 for no limit). Work that crosses queues
+	// also ends batches: a step that waits or has handoff barriers starts one, since those are submitted ahead of it,
+	// and a step that another queue waits for ends one, so the other queue does not wait for the rest of the batch.
+	inline std::vector<std::size_t> PlanSubmissionBatches(const BarrierPlan& barriers, const QueueSchedule& schedule, const std::vector<QueueType>& stepQueues, const std::size_t maxBatchSize)
+	{
+		const auto stepCount = stepQueues.size();
+		std::vector<bool> awaited(stepCount);
+		for (std::size_t step = 0; step < stepCount; ++step)
+		{
+			for (auto& wait : schedule.waits[step])
+				awaited[wait.step] = true;
+			for (auto& barrier : barriers.steps[step].handoff)
+				if (barrier.previousStep != kNoStep && stepQueues[barrier.previousStep] != QueueType::Graphics)
+					awaited[barrier.previousStep] = true;
+		}
+
+		std::vector<std::size_t> stepBatches(stepCount);
+		std::size_t batch = 0;
+		std::size_t batchSize = 0;
+		for (std::size_t step = 0; step < stepCount; ++step)
+		{
+			const bool split = step > 0 && (
+				stepQueues[step] != stepQueues[step - 1] ||
+				(maxBatchSize > 0 && batchSize == maxBatchSize) ||
+				!schedule.waits[step].empty() ||
+				!barriers.steps[step].handoff.empty() ||
+				awaited[step - 1]);
+			if (split)
+			{
+				batch++;
+				batchSize = 0;
+			}
+			stepBatches[step] = batch;
+			batchSize++;
+		}
+		return stepBatches;
+	}
+}
+
+#endif
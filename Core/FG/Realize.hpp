@@ -2,26 +2,52 @@
 #ifndef FG_REALIZE_HPP_
 #define FG_REALIZE_HPP_
 
+#include <cstdint>
 #include <memory>
 #include <type_traits>
 
+#include "ResourceAccess.hpp"
+#include "TransientAliasing.hpp"
+
 namespace FG
 {
 	template<typename _DescriptionType, typename _ActualType> 
 	struct MissingRealizeImplementation : std::false_type {};
 
 	template<typename _DescriptionType, typename _ActualType>
-	std::unique_ptr<_ActualType> Realize(const _DescriptionType& description)
+	std::unique_ptr<_ActualType> Realize(const _DescriptionType&)
 	{
 		static_assert(MissingRealizeImplementation<_DescriptionType, _ActualType>::value, "Missing realize implementation for description - type pair.");
 		return nullptr;
 	}
 
 	// Ϊd3d12ԴͷһҪgpu첽ִн֮ҪֶԴͷ
-	template<typename _ActualType>
-	void DeRealize(std::unique_ptr<_ActualType>& actual_ptr, int fence)
+	// The description is passed along so that implementations can recycle the actual for a later matching realization.
+	template<typename _DescriptionType, typename _ActualType>
+	void DeRealize(const _DescriptionType&, std::unique_ptr<_ActualType>&, std::uint64_t)
 	{
-		static_assert(actual_ptr == nullptr, "actulal_ptr is nullptr, you should control the lifetime of the object by your own.");
+		static_assert(MissingRealizeImplementation<_DescriptionType, _ActualType>::value, "Missing derealize implementation for description - type pair.");
+	}
+
+	// Optional customization points for transients that compilation placed in the transient heaps, see
+	// FrameGraph::TransientHeapSizes(). RealizePlaced creates the actual at its placement and DeRealizePlaced takes it
+	// back; without them a placed transient is realized like any other and its placement goes unused.
+	template<typename _DescriptionType, typename _ActualType>
+	std::unique_ptr<_ActualType> RealizePlaced(const _DescriptionType& description, const TransientPlacement&)
+	{
+		return Realize<_DescriptionType, _ActualType>(description);
+	}
+	template<typename _DescriptionType, typename _ActualType>
+	void DeRealizePlaced(const _DescriptionType& description, const TransientPlacement&, std::unique_ptr<_ActualType>& actual_ptr, std::uint64_t fence)
+	{
+		DeRealize<_DescriptionType, _ActualType>(description, actual_ptr, fence);
+	}
+	// Recorded before the first use of a placed transient, ahead of its barriers. The memory still holds whatever the
+	// transients placed there before left behind, so this is where the renderer puts its aliasing barrier.
+	template<typename _DescriptionType, typename _ActualType>
+	void Activate(CommandContext&, _ActualType&)
+	{
+
 	}
 
 }
@@ -0,0 +1,114 @@
+#pragma once
+#ifndef FG_RECORDING_SCHEDULER_HPP_
+#define FG_RECORDING_SCHEDULER_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "BarrierPlanner.hpp"
+
+namespace FG
+{
+	// Groups steps into dependency levels: a step lands one level after the deepest earlier step it conflicts with.
+	// Two steps conflict when they share a resource unless both only read it with the same tracked access, so the
+	// steps of a level can be recorded in any order without disagreeing on resource state.
+	inline std::vector<std::vector<std::size_t>> ComputeDependencyLevels(const std::size_t resourceCount, const std::vector<std::vector<ResourceUse>>& steps)
+	{
+		// Per resource: one past the deepest level using it, and the bound of the run of identical reads it is in.
+		std::vector<std::size_t> userEnds(resourceCount, 0);
+		std::vector<std::size_t> readBounds(resourceCount, 0);
+		std::vector<ResourceAccess> readAccesses(resourceCount, ResourceAccess::None);
+
+		std::vector<std::vector<std::size_t>> levels;
+		std::vector<ResourceUse> uses;
+		for (std::size_t step = 0; step < steps.size(); ++step)
+		{
+			MergeResourceUses(steps[step], uses);
+
+			std::size_t level = 0;
+			for (auto& use : uses)
+			{
+				const bool sharedRead = use.access != ResourceAccess::None && readAccesses[use.resource] == use.access;
+				level = std::max(level, sharedRead ? readBounds[use.resource] : userEnds[use.resource]);
+			}
+
+			for (auto& use : uses)
+			{
+				const auto resource = use.resource;
+				const bool sharedRead = use.access != ResourceAccess::None && readAccesses[resource] == use.access;
+				if (!sharedRead)
+				{
+					readBounds[resource] = userEnds[resource];
+					readAccesses[resource] = IsWriteAccess(use.access) ? ResourceAccess::None : use.access;
+				}
+				userEnds[resource] = std::max(userEnds[resource], level + 1);
+			}
+
+			if (level == levels.size())
+				levels.emplace_back();
+			levels[level].push_back(step);
+		}
+		return levels;
+	}
+
+	struct RecordingSchedule
+	{
+		std::vector<std::vector<std::size_t>>  levels;      // Steps recorded together, each level after the previous one.
+		std::vector<std::size_t>               stepWorkers; // Per step: the worker that records it.
+		std::size_t                            workerCount = 0; // Workers needed by the widest level.
+	};
+
+	// Deals the steps of every level out to the workers round-robin, in timeline order. Steps recorded into the same
+	// context (stepBatches, empty for one context per step) go to the same worker as a unit, so it records them in order.
+	inline RecordingSchedule ScheduleRecording(const std::vector<std::vector<std::size_t>>& levels, const std::size_t stepCount, const std::size_t workerCount, const std::vector<std::size_t>& stepBatches = {})
+	{
+		RecordingSchedule schedule;
+		schedule.levels = levels;
+		schedule.stepWorkers.resize(stepCount);
+		for (auto& level : levels)
+		{
+			std::size_t units = 0;
+			for (std::size_t i = 0; i < level.size(); ++i)
+			{
+				if (i == 0 || stepBatches.empty() || stepBatches[level[i]] != stepBatches[level[i - 1]])
+					units++;
+				schedule.stepWorkers[level[i]] = workerCount > 0 ? (units - 1) % workerCount : 0;
+			}
+			schedule.workerCount = std::max(schedule.workerCount, std::min(units, std::max<std::size_t>(workerCount, 1)));
+		}
+		return schedule;
+	}
+
+	// Releases recorded steps for submission strictly in timeline order, whatever order they were recorded in.
+	class OrderedSubmission
+	{
+	public:
+		explicit OrderedSubmission(const std::size_t stepCount) : _recorded(stepCount), _next(0)
+		{
+
+		}
+
+		void Recorded(const std::size_t step)
+		{
+			_recorded[step] = true;
+		}
+		// Calls submit(step) for every step that is recorded and has all earlier steps submitted.
+		template<typename SubmitType>
+		void SubmitReady(SubmitType&& submit)
+		{
+			while (_next < _recorded.size() && _recorded[_next])
+				submit(_next++);
+		}
+		bool Done() const
+		{
+			return _next == _recorded.size();
+		}
+
+	protected:
+		std::vector<bool>  _recorded;
+		std::size_t        _next;
+	};
+}
+
+#endif
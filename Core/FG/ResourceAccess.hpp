@@ -0,0 +1,145 @@
+#pragma once
+#ifndef FG_RESOURCE_ACCESS_HPP_
+#define FG_RESOURCE_ACCESS_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+class CommandContext; // Supplied by the renderer; the framegraph only passes it through.
+
+namespace FG
+{
+	// How a pass touches a resource. Read accesses may be combined; a write access is exclusive.
+	enum class ResourceAccess : std::uint32_t
+	{
+		None             = 0,      // Untracked: the pass transitions the resource itself.
+		ShaderResource   = 1 << 0,
+		UnorderedAccess  = 1 << 1,
+		RenderTarget     = 1 << 2,
+		DepthWrite       = 1 << 3,
+		DepthRead        = 1 << 4,
+		CopySource       = 1 << 5,
+		CopyDest         = 1 << 6,
+		IndirectArgument = 1 << 7,
+	};
+
+	constexpr ResourceAccess operator|(const ResourceAccess lhs, const ResourceAccess rhs)
+	{
+		return ResourceAccess(std::uint32_t(lhs) | std::uint32_t(rhs));
+	}
+	constexpr ResourceAccess operator&(const ResourceAccess lhs, const ResourceAccess rhs)
+	{
+		return ResourceAccess(std::uint32_t(lhs) & std::uint32_t(rhs));
+	}
+
+	constexpr ResourceAccess kWriteAccess = ResourceAccess::UnorderedAccess | ResourceAccess::RenderTarget | ResourceAccess::DepthWrite | ResourceAccess::CopyDest;
+
+	constexpr bool IsWriteAccess(const ResourceAccess access)
+	{
+		return (access & kWriteAccess) != ResourceAccess::None;
+	}
+
+	enum class QueueType : std::uint8_t
+	{
+		Graphics,
+		Compute,
+		Copy,
+	};
+
+	constexpr std::size_t kQueueTypeCount = 3;
+
+	// Accesses whose resource state a queue can transition to and from. Anything else is transitioned on the graphics
+	// queue on the queue's behalf. Shader resources are left out for compute because the state used for them includes
+	// pixel shader reads.
+	constexpr bool QueueSupportsAccess(const QueueType queue, const ResourceAccess access)
+	{
+		return queue == QueueType::Graphics ||
+			(access != ResourceAccess::None && (access & (queue == QueueType::Compute ?
+				ResourceAccess::UnorderedAccess | ResourceAccess::CopySource | ResourceAccess::CopyDest :
+				ResourceAccess::CopySource | ResourceAccess::CopyDest)) == access);
+	}
+
+	constexpr std::uint32_t kAllSubresources = ~std::uint32_t(0);
+
+	// A box of mips and array slices of a resource. The default covers all of them, whatever their number.
+	struct SubresourceRange
+	{
+		std::uint32_t firstMip   = 0;
+		std::uint32_t mipCount   = kAllSubresources;
+		std::uint32_t firstSlice = 0;
+		std::uint32_t sliceCount = kAllSubresources;
+
+		static constexpr SubresourceRange Mips(const std::uint32_t firstMip, const std::uint32_t mipCount = 1)
+		{
+			return SubresourceRange{ firstMip, mipCount, 0, kAllSubresources };
+		}
+		static constexpr SubresourceRange Slices(const std::uint32_t firstSlice, const std::uint32_t sliceCount = 1)
+		{
+			return SubresourceRange{ 0, kAllSubresources, firstSlice, sliceCount };
+		}
+
+		constexpr bool All() const
+		{
+			return firstMip == 0 && mipCount == kAllSubresources && firstSlice == 0 && sliceCount == kAllSubresources;
+		}
+		constexpr std::uint32_t MipEnd() const
+		{
+			return mipCount >= kAllSubresources - firstMip ? kAllSubresources : firstMip + mipCount;
+		}
+		constexpr std::uint32_t SliceEnd() const
+		{
+			return sliceCount >= kAllSubresources - firstSlice ? kAllSubresources : firstSlice + sliceCount;
+		}
+	};
+
+	constexpr bool operator==(const SubresourceRange& lhs, const SubresourceRange& rhs)
+	{
+		return lhs.firstMip == rhs.firstMip && lhs.MipEnd() == rhs.MipEnd() && lhs.firstSlice == rhs.firstSlice && lhs.SliceEnd() == rhs.SliceEnd();
+	}
+	constexpr bool operator!=(const SubresourceRange& lhs, const SubresourceRange& rhs)
+	{
+		return !(lhs == rhs);
+	}
+
+	constexpr bool Overlaps(const SubresourceRange& lhs, const SubresourceRange& rhs)
+	{
+		return lhs.firstMip < rhs.MipEnd() && rhs.firstMip < lhs.MipEnd() && lhs.firstSlice < rhs.SliceEnd() && rhs.firstSlice < lhs.SliceEnd();
+	}
+	constexpr bool Contains(const SubresourceRange& outer, const SubresourceRange& inner)
+	{
+		return outer.firstMip <= inner.firstMip && inner.MipEnd() <= outer.MipEnd() && outer.firstSlice <= inner.firstSlice && inner.SliceEnd() <= outer.SliceEnd();
+	}
+
+	// How many mips and array slices a resource has, which bounds how finely its state is tracked.
+	struct SubresourceLayout
+	{
+		std::uint32_t mipCount   = 1;
+		std::uint32_t sliceCount = 1;
+	};
+
+	template<typename _DescriptionType, typename _ActualType>
+	SubresourceLayout Subresources(const _DescriptionType&)
+	{
+		// Optional customization point. Without it the resource is tracked as a whole and ranges only order passes.
+		return SubresourceLayout();
+	}
+
+	enum class BarrierPhase : std::uint8_t
+	{
+		Full,    // Transition right before the use.
+		Begin,   // First half of a split barrier, recorded right after the previous use.
+		End,     // Second half of a split barrier, recorded right before the use.
+		Settled, // No barrier: transitions of ranges just left every subresource in the state after.
+	};
+
+	// Before is the state the planner tracked for the range, None when it is unknown, e.g. on first use. A range that
+	// is not All() only ever comes from resources whose Subresources() are customized, and so does a Settled phase,
+	// which covers the whole resource and lets an implementation that tracks one state per resource catch up.
+	template<typename _DescriptionType, typename _ActualType>
+	void Transition(CommandContext&, _ActualType&, const ResourceAccess, const ResourceAccess, const SubresourceRange&, const BarrierPhase)
+	{
+		// Optional customization point. Without it barriers are planned and counted, but left to the passes.
+	}
+}
+
+#endif
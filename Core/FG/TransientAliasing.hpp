@@ -0,0 +1,150 @@
+#pragma once
+#ifndef FG_TRANSIENT_ALIASING_HPP_
+#define FG_TRANSIENT_ALIASING_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace FG
+{
+	constexpr std::size_t kUnplacedHeap = static_cast<std::size_t>(-1);
+
+	struct TransientMemoryRequirements
+	{
+		std::size_t size      = 0; // Zero means unknown; such transients keep their own allocation.
+		std::size_t alignment = 1;
+	};
+
+	// Lifetime of a transient in timeline steps, both ends inclusive.
+	struct TransientAllocation
+	{
+		std::size_t size;
+		std::size_t alignment;
+		std::size_t firstStep;
+		std::size_t lastStep;
+	};
+
+	struct TransientPlacement
+	{
+		std::size_t heap   = kUnplacedHeap;
+		std::size_t offset = 0;
+	};
+
+	struct TransientMemoryStats
+	{
+		std::size_t unaliasedBytes = 0; // Every placed transient in its own allocation.
+		std::size_t aliasedBytes   = 0; // Sum of the heap sizes after packing.
+		std::size_t peakLiveBytes  = 0; // Lower bound: the most bytes alive during a single step.
+		std::size_t heapCount      = 0;
+	};
+
+	struct TransientAliasingPlan
+	{
+		std::vector<TransientPlacement>  placements; // Parallel to the allocations passed in.
+		std::vector<std::size_t>         heapSizes;
+		TransientMemoryStats             stats;
+	};
+
+	template<typename _DescriptionType, typename _ActualType>
+	TransientMemoryRequirements MemoryRequirements(const _DescriptionType&)
+	{
+		// Optional customization point. Without it the transient is simply left out of aliasing.
+		return TransientMemoryRequirements();
+	}
+
+	inline std::size_t AlignTransientOffset(const std::size_t offset, const std::size_t alignment)
+	{
+		return alignment > 1 ? (offset + alignment - 1) / alignment * alignment : offset;
+	}
+
+	// Packs transients with disjoint lifetimes into the same memory. Allocations are placed largest first, each at the
+	// lowest aligned offset of the first heap where it does not collide with a placed allocation whose lifetime
+	// overlaps its own. A heap never grows beyond maxHeapSize (0 for unbounded) unless a single allocation is larger.
+	// Ties are broken on the input order, so the plan is deterministic.
+	inline TransientAliasingPlan PlanTransientAliasing(const std::vector<TransientAllocation>& allocations, const std::size_t maxHeapSize = 0)
+	{
+		TransientAliasingPlan plan;
+		plan.placements.resize(allocations.size());
+
+		std::vector<std::size_t> order;
+		for (std::size_t i = 0; i < allocations.size(); ++i)
+			if (allocations[i].size > 0)
+				order.push_back(i);
+		std::stable_sort(order.begin(), order.end(), [&allocations](const std::size_t lhs, const std::size_t rhs)
+		{
+			if (allocations[lhs].size != allocations[rhs].size)
+				return allocations[lhs].size > allocations[rhs].size;
+			return allocations[lhs].firstStep < allocations[rhs].firstStep;
+		});
+
+		std::vector<std::vector<std::size_t>> heaps; // Allocation indices placed in each heap.
+		std::vector<std::pair<std::size_t, std::size_t>> occupied; // [begin, end) ranges of overlapping lifetimes.
+		for (auto index : order)
+		{
+			const auto& allocation = allocations[index];
+
+			std::size_t heap = 0, offset = 0;
+			for (; heap < heaps.size(); ++heap)
+			{
+				occupied.clear();
+				for (auto placed : heaps[heap])
+				{
+					const auto& other = allocations[placed];
+					if (other.firstStep <= allocation.lastStep && allocation.firstStep <= other.lastStep)
+						occupied.emplace_back(plan.placements[placed].offset, plan.placements[placed].offset + other.size);
+				}
+				std::sort(occupied.begin(), occupied.end());
+
+				offset = AlignTransientOffset(0, allocation.alignment);
+				for (auto& range : occupied)
+				{
+					if (offset + allocation.size <= range.first)
+						break;
+					offset = std::max(offset, AlignTransientOffset(range.second, allocation.alignment));
+				}
+
+				if (maxHeapSize == 0 || offset + allocation.size <= maxHeapSize)
+					break;
+			}
+
+			if (heap == heaps.size())
+			{
+				heaps.emplace_back();
+				plan.heapSizes.push_back(0);
+				offset = 0;
+			}
+
+			heaps[heap].push_back(index);
+			plan.placements[index] = TransientPlacement{ heap, offset };
+			plan.heapSizes[heap] = std::max(plan.heapSizes[heap], offset + allocation.size);
+		}
+
+		// Live bytes per step, swept over lifetime begin/end events.
+		std::vector<std::pair<std::size_t, std::ptrdiff_t>> events;
+		for (auto index : order)
+		{
+			const auto& allocation = allocations[index];
+			plan.stats.unaliasedBytes += allocation.size;
+			events.emplace_back(allocation.firstStep, std::ptrdiff_t(allocation.size));
+			events.emplace_back(allocation.lastStep + 1, -std::ptrdiff_t(allocation.size));
+		}
+		std::sort(events.begin(), events.end());
+
+		std::size_t live = 0;
+		for (auto& event : events)
+		{
+			live += event.second;
+			plan.stats.peakLiveBytes = std::max(plan.stats.peakLiveBytes, live);
+		}
+
+		for (auto heapSize : plan.heapSizes)
+			plan.stats.aliasedBytes += heapSize;
+		plan.stats.heapCount = plan.heapSizes.size();
+
+		return plan;
+	}
+}
+
+#endif
@@ -0,0 +1,153 @@
+#pragma once
+#ifndef FG_TRANSIENT_RESOURCE_POOL_HPP_
+#define FG_TRANSIENT_RESOURCE_POOL_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace FG
+{
+	struct TransientPoolStats
+	{
+		std::size_t hits      = 0; // Realizations served from a retired actual.
+		std::size_t misses    = 0; // Realizations that had to create a new actual.
+		std::size_t evictions = 0; // Retired actuals destroyed after sitting unused for too long.
+		std::size_t pooled    = 0; // Retired actuals currently held by the pool.
+
+		TransientPoolStats& operator+=(const TransientPoolStats& that)
+		{
+			hits      += that.hits;
+			misses    += that.misses;
+			evictions += that.evictions;
+			pooled    += that.pooled;
+			return *this;
+		}
+	};
+
+	// Keeps derealized transients alive until both the GPU is done with them and a later realization with an
+	// identical description picks them up. Actuals that stay unused for more than maxUnusedFrames are destroyed.
+	// The pool only talks to the GPU through the fence query, so it can be driven by a fake fence counter.
+	template<typename _DescriptionType, typename _ActualType>
+	class TransientResourcePool
+	{
+	public:
+		using DescriptionType = _DescriptionType;
+		using ActualType = _ActualType;
+		using FenceQuery = std::function<bool(std::uint64_t)>;
+
+		explicit TransientResourcePool(const FenceQuery& isFenceComplete, std::size_t maxUnusedFrames = 3)
+			: _isFenceComplete(isFenceComplete), _maxUnusedFrames(maxUnusedFrames), _frame(0)
+		{
+
+		}
+		TransientResourcePool(const TransientResourcePool& that) = delete;
+		TransientResourcePool(TransientResourcePool&& temp) = default;
+		~TransientResourcePool() = default;
+		TransientResourcePool& operator=(const TransientResourcePool& that) = delete;
+		TransientResourcePool& operator=(TransientResourcePool&& temp) = default;
+
+		// Returns a retired actual matching the description whose fence has completed, or nullptr on a miss.
+		std::unique_ptr<ActualType> Acquire(const DescriptionType& description)
+		{
+			for (std::size_t i = 0; i < _entries.size(); ++i)
+			{
+				auto& entry = _entries[i];
+				if (!(entry.description == description) || !_isFenceComplete(entry.fence))
+					continue;
+
+				auto actual = std::move(entry.actual);
+				RemoveEntry(i);
+				_totals.hits++;
+				_frameStats.hits++;
+				return actual;
+			}
+
+			_totals.misses++;
+			_frameStats.misses++;
+			return nullptr;
+		}
+		void Release(const DescriptionType& description, std::unique_ptr<ActualType>&& actual, std::uint64_t fence)
+		{
+			if (!actual)
+				return;
+
+			_entries.push_back(Entry{ description, std::move(actual), fence, _frame });
+		}
+		// Advances the frame counter and evicts retired actuals that were not reused for maxUnusedFrames frames.
+		void NextFrame()
+		{
+			_frame++;
+			_frameStats = TransientPoolStats();
+
+			for (std::size_t i = 0; i < _entries.size();)
+			{
+				auto& entry = _entries[i];
+				if (_frame - entry.lastUsedFrame > _maxUnusedFrames && _isFenceComplete(entry.fence))
+				{
+					RemoveEntry(i);
+					_totals.evictions++;
+					_frameStats.evictions++;
+				}
+				else
+					++i;
+			}
+		}
+		// Destroys every retired actual. The caller must make sure the GPU is idle.
+		void Clear()
+		{
+			_totals.evictions += _entries.size();
+			_entries.clear();
+		}
+
+		TransientPoolStats Totals() const
+		{
+			auto stats = _totals;
+			stats.pooled = _entries.size();
+			return stats;
+		}
+		TransientPoolStats FrameStats() const // Since the last NextFrame().
+		{
+			auto stats = _frameStats;
+			stats.pooled = _entries.size();
+			return stats;
+		}
+
+		std::size_t MaxUnusedFrames() const
+		{
+			return _maxUnusedFrames;
+		}
+		void SetMaxUnusedFrames(const std::size_t maxUnusedFrames)
+		{
+			_maxUnusedFrames = maxUnusedFrames;
+		}
+
+	protected:
+		struct Entry
+		{
+			DescriptionType              description;
+			std::unique_ptr<ActualType>  actual;
+			std::uint64_t                fence;
+			std::size_t                  lastUsedFrame;
+		};
+
+		void RemoveEntry(const std::size_t index)
+		{
+			if (index + 1 != _entries.size())
+				_entries[index] = std::move(_entries.back());
+			_entries.pop_back();
+		}
+
+		FenceQuery          _isFenceComplete;
+		std::size_t         _maxUnusedFrames;
+		std::size_t         _frame;
+		std::vector<Entry>  _entries;
+		TransientPoolStats  _totals;
+		TransientPoolStats  _frameStats;
+	};
+}
+
+#endif
@@ -0,0 +1,110 @@
+#pragma once
+#ifndef FG_WORKER_POOL_HPP_
+#define FG_WORKER_POOL_HPP_
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace FG
+{
+	// A fixed set of threads for fork/join work. The thread calling Run() takes part as worker 0, so a pool of one
+	// worker runs everything inline.
+	class WorkerPool
+	{
+	public:
+		using Task = std::function<void(std::size_t)>;
+
+		explicit WorkerPool(const std::size_t workerCount = std::max<std::size_t>(std::thread::hardware_concurrency(), 1))
+			: _task(nullptr), _activeWorkers(0), _pendingWorkers(0), _generation(0), _stop(false)
+		{
+			for (std::size_t worker = 1; worker < workerCount; ++worker)
+				_threads.emplace_back([this, worker]() { WorkerLoop(worker); });
+		}
+		WorkerPool(const WorkerPool& that) = delete;
+		WorkerPool(WorkerPool&& temp) = delete;
+		~WorkerPool()
+		{
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				_stop = true;
+			}
+			_wake.notify_all();
+			for (auto& thread : _threads)
+				thread.join();
+		}
+		WorkerPool& operator=(const WorkerPool& that) = delete;
+		WorkerPool& operator=(WorkerPool&& temp) = delete;
+
+		std::size_t WorkerCount() const
+		{
+			return _threads.size() + 1;
+		}
+
+		// Calls task(worker) once for each worker in [0, workerCount) and returns once every call has returned.
+		void Run(std::size_t workerCount, const Task& task)
+		{
+			workerCount = std::min(workerCount, WorkerCount());
+			if (workerCount == 0)
+				return;
+
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				_task = &task;
+				_activeWorkers = workerCount;
+				_pendingWorkers = workerCount - 1;
+				_generation++;
+			}
+			if (workerCount > 1)
+				_wake.notify_all();
+
+			task(0);
+
+			std::unique_lock<std::mutex> lock(_mutex);
+			_done.wait(lock, [this]() { return _pendingWorkers == 0; });
+			_task = nullptr;
+		}
+
+	protected:
+		void WorkerLoop(const std::size_t worker)
+		{
+			std::size_t generation = 0;
+			for (;;)
+			{
+				const Task* task = nullptr;
+				{
+					std::unique_lock<std::mutex> lock(_mutex);
+					_wake.wait(lock, [this, generation]() { return _stop || _generation != generation; });
+					if (_stop)
+						return;
+					generation = _generation;
+					if (worker >= _activeWorkers)
+						continue;
+					task = _task;
+				}
+
+				(*task)(worker);
+
+				std::lock_guard<std::mutex> lock(_mutex);
+				if (--_pendingWorkers == 0)
+					_done.notify_one();
+			}
+		}
+
+		std::vector<std::thread>  _threads;
+		std::mutex                _mutex;
+		std::condition_variable   _wake;
+		std::condition_variable   _done;
+		const Task*               _task;
+		std::size_t               _activeWorkers;
+		std::size_t               _pendingWorkers;
+		std::size_t               _generation;
+		bool                      _stop;
+	};
+}
+
+#endif
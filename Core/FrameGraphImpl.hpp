@@ -1,6 +1,12 @@
 #pragma once
 
 #include "FG/FrameGraph.hpp"
+#include "FG/TransientResourcePool.hpp"
+#include "FG/TransientAliasing.hpp"
+#include "FG/CommandRecorder.hpp"
+#include "FG/ResourceAccess.hpp"
+
+#include <tuple>
 
 #include "d3dx12.h"
 #include "Color.h"
@@ -9,6 +15,11 @@
 #include "DepthBuffer.h"
 #include "ShadowBuffer.h"
 #include "GpuBuffer.h"
+#include "GraphicsCore.h"
+#include "CommandListManager.h"
+#include "CommandContext.h"
+#include "EngineProfiling.h"
+#include "Utility.h"
 
 namespace FG
 {
@@ -69,16 +80,284 @@ namespace FG
 	using StructuredBufferResource = FG::FrameGraphResource<StructuredBufferDescription, StructuredBuffer>;
 	using TypedBufferResource = FG::FrameGraphResource<TypedBufferDescription, TypedBuffer>;
 
-	std::list<std::pair<int, std::unique_ptr<ColorBuffer>>> g_ColorBufferCache;
-	std::list<std::pair<int, std::unique_ptr<DepthBuffer>>> g_DepthBufferCache;
-	std::list<std::pair<int, std::unique_ptr<ShadowBuffer>>> g_ShadowBufferCache;
-	std::list<std::pair<int, std::unique_ptr<ByteAddressBuffer>>> g_ByteAddressBufferCache;
-	std::list<std::pair<int, std::unique_ptr<IndirectArgsBuffer>>> g_IndirectArgsBufferCache;
-	std::list<std::pair<int, std::unique_ptr<StructuredBuffer>>> g_StructuredBufferCache;
-	std::list<std::pair<int, std::unique_ptr<TypedBuffer>>> g_TypedBufferCache;
+	inline bool operator==(const ColorBufferDescription& lhs, const ColorBufferDescription& rhs)
+	{
+		return lhs.Width == rhs.Width && lhs.Height == rhs.Height && lhs.NumMips == rhs.NumMips && lhs.ArrayCount == rhs.ArrayCount &&
+			lhs.Format == rhs.Format && lhs.NumColorSamples == rhs.NumColorSamples && lhs.NumCoverageSamples == rhs.NumCoverageSamples;
+	}
+
+	inline bool operator==(const DepthBufferDescription& lhs, const DepthBufferDescription& rhs)
+	{
+		return lhs.ClearDepth == rhs.ClearDepth && lhs.ClearStencil == rhs.ClearStencil && lhs.Width == rhs.Width &&
+			lhs.Height == rhs.Height && lhs.NumSamples == rhs.NumSamples && lhs.Format == rhs.Format;
+	}
 
+	// The depth description has padding after ClearStencil, so it cannot be hashed bytewise.
 	template<>
-	std::unique_ptr<ColorBuffer> Realize(const ColorBufferDescription& description)
+	inline std::size_t HashDescription(const DepthBufferDescription& description)
+	{
+		std::size_t hash = HashBytes(&description.ClearDepth, sizeof(description.ClearDepth));
+		hash = HashCombine(hash, description.ClearStencil);
+		hash = HashCombine(hash, description.Width);
+		hash = HashCombine(hash, description.Height);
+		hash = HashCombine(hash, description.NumSamples);
+		return HashCombine(hash, description.Format);
+	}
+
+	inline bool operator==(const ShadowBufferDescription& lhs, const ShadowBufferDescription& rhs)
+	{
+		return lhs.Width == rhs.Width && lhs.Height == rhs.Height;
+	}
+
+	inline bool operator==(const ByteAddressBufferDescription& lhs, const ByteAddressBufferDescription& rhs)
+	{
+		return lhs.NumElements == rhs.NumElements && lhs.ElementSize == rhs.ElementSize;
+	}
+
+	inline bool operator==(const IndirectArgsBufferDescription& lhs, const IndirectArgsBufferDescription& rhs)
+	{
+		return lhs.NumElements == rhs.NumElements && lhs.ElementSize == rhs.ElementSize;
+	}
+
+	inline bool operator==(const StructuredBufferDescription& lhs, const StructuredBufferDescription& rhs)
+	{
+		return lhs.NumElements == rhs.NumElements && lhs.ElementSize == rhs.ElementSize;
+	}
+
+	inline bool operator==(const TypedBufferDescription& lhs, const TypedBufferDescription& rhs)
+	{
+		return lhs.NumElements == rhs.NumElements && lhs.ElementSize == rhs.ElementSize && lhs.Format == rhs.Format;
+	}
+
+	// Derealized transients are kept until their fence completes and a later frame asks for the same description.
+	// Anything left unused for kTransientPoolMaxUnusedFrames frames is destroyed by UpdateTransientPools().
+	constexpr std::size_t kTransientPoolMaxUnusedFrames = 3;
+
+	inline bool IsTransientFenceComplete(std::uint64_t fence)
+	{
+		return Graphics::g_CommandManager.IsFenceComplete(fence);
+	}
+
+	inline TransientResourcePool<ColorBufferDescription, ColorBuffer> g_ColorBufferPool(IsTransientFenceComplete, kTransientPoolMaxUnusedFrames);
+	inline TransientResourcePool<DepthBufferDescription, DepthBuffer> g_DepthBufferPool(IsTransientFenceComplete, kTransientPoolMaxUnusedFrames);
+	inline TransientResourcePool<ShadowBufferDescription, ShadowBuffer> g_ShadowBufferPool(IsTransientFenceComplete, kTransientPoolMaxUnusedFrames);
+	inline TransientResourcePool<ByteAddressBufferDescription, ByteAddressBuffer> g_ByteAddressBufferPool(IsTransientFenceComplete, kTransientPoolMaxUnusedFrames);
+	inline TransientResourcePool<IndirectArgsBufferDescription, IndirectArgsBuffer> g_IndirectArgsBufferPool(IsTransientFenceComplete, kTransientPoolMaxUnusedFrames);
+	inline TransientResourcePool<StructuredBufferDescription, StructuredBuffer> g_StructuredBufferPool(IsTransientFenceComplete, kTransientPoolMaxUnusedFrames);
+	inline TransientResourcePool<TypedBufferDescription, TypedBuffer> g_TypedBufferPool(IsTransientFenceComplete, kTransientPoolMaxUnusedFrames);
+
+	// Actuals created at a placement in a set of transient heaps, kept with the set for the next frame that places the
+	// same description at the same spot.
+	template<typename DescriptionType, typename ActualType>
+	class PlacedTransients
+	{
+	public:
+		std::unique_ptr<ActualType> Acquire(const DescriptionType& description, const TransientPlacement& placement)
+		{
+			for (auto& entry : m_Entries)
+				if (entry.Actual && Matches(entry, description, placement))
+					return std::move(entry.Actual);
+			return nullptr;
+		}
+		void Release(const DescriptionType& description, const TransientPlacement& placement, std::unique_ptr<ActualType>&& actual)
+		{
+			for (auto& entry : m_Entries)
+			{
+				if (!entry.Actual && Matches(entry, description, placement))
+				{
+					entry.Actual = std::move(actual);
+					return;
+				}
+			}
+			m_Entries.push_back(Entry{ description, placement, std::move(actual) });
+		}
+
+	private:
+		struct Entry
+		{
+			DescriptionType Description;
+			TransientPlacement Placement;
+			std::unique_ptr<ActualType> Actual; // Null while realized.
+		};
+
+		static bool Matches(const Entry& entry, const DescriptionType& description, const TransientPlacement& placement)
+		{
+			return entry.Placement.heap == placement.heap && entry.Placement.offset == placement.offset && entry.Description == description;
+		}
+
+		std::vector<Entry> m_Entries;
+	};
+
+	// The heaps one frame places its transients in, see FrameGraph::TransientHeapSizes(). Placed transients are only
+	// ever used on the graphics queue, so the set is free again once that queue passed Fence.
+	struct TransientHeapSet
+	{
+		std::vector<Microsoft::WRL::ComPtr<ID3D12Heap>> Heaps;
+		std::vector<std::size_t> HeapSizes;
+		std::uint64_t Fence = 0;
+		std::size_t LastUsedFrame = 0;
+		std::tuple<
+			PlacedTransients<ColorBufferDescription, ColorBuffer>,
+			PlacedTransients<DepthBufferDescription, DepthBuffer>,
+			PlacedTransients<ShadowBufferDescription, ShadowBuffer>,
+			PlacedTransients<ByteAddressBufferDescription, ByteAddressBuffer>,
+			PlacedTransients<IndirectArgsBufferDescription, IndirectArgsBuffer>,
+			PlacedTransients<StructuredBufferDescription, StructuredBuffer>,
+			PlacedTransients<TypedBufferDescription, TypedBuffer>> Actuals;
+
+		bool Fits(const std::vector<std::size_t>& heapSizes) const
+		{
+			if (heapSizes.size() > HeapSizes.size())
+				return false;
+			for (std::size_t i = 0; i < heapSizes.size(); ++i)
+				if (heapSizes[i] > HeapSizes[i])
+					return false;
+			return true;
+		}
+	};
+
+	inline std::vector<std::unique_ptr<TransientHeapSet>> g_TransientHeapSets;
+	inline TransientHeapSet* g_CurrentTransientHeaps = nullptr; // Between PrepareTransientHeaps() and UpdateTransientPools().
+	inline std::size_t g_TransientHeapFrame = 0;
+
+	// Tier 1 hardware keeps buffers, render target and depth textures and other textures in separate heaps. All the
+	// textures the framegraph creates are render targets or depth buffers, so there only those are placed.
+	inline bool TransientHeapsHoldBuffers()
+	{
+		static const bool holdBuffers = []
+		{
+			D3D12_FEATURE_DATA_D3D12_OPTIONS Options = {};
+			return SUCCEEDED(Graphics::g_Device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS, &Options, sizeof(Options))) &&
+				Options.ResourceHeapTier >= D3D12_RESOURCE_HEAP_TIER_2;
+		}();
+		return holdBuffers;
+	}
+
+	// Call once per frame between compiling and executing the framegraph. Picks a set of heaps the GPU is done with
+	// that is large enough for the planned ones, or creates one. Without a call placed transients fall back to the
+	// pools above.
+	inline void PrepareTransientHeaps(const std::vector<std::size_t>& HeapSizes)
+	{
+		g_CurrentTransientHeaps = nullptr;
+		if (HeapSizes.empty())
+			return;
+
+		for (auto& set : g_TransientHeapSets)
+		{
+			if (set->Fits(HeapSizes) && Graphics::g_CommandManager.IsFenceComplete(set->Fence))
+			{
+				g_CurrentTransientHeaps = set.get();
+				break;
+			}
+		}
+
+		if (g_CurrentTransientHeaps == nullptr)
+		{
+			auto set = std::make_unique<TransientHeapSet>();
+			for (auto size : HeapSizes)
+			{
+				D3D12_HEAP_DESC Desc = {};
+				Desc.SizeInBytes = AlignTransientOffset(size, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
+				Desc.Properties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
+				Desc.Alignment = D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT;
+				Desc.Flags = TransientHeapsHoldBuffers() ? D3D12_HEAP_FLAG_ALLOW_ALL_BUFFERS_AND_TEXTURES : D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES;
+
+				Microsoft::WRL::ComPtr<ID3D12Heap> Heap;
+				ASSERT_SUCCEEDED(Graphics::g_Device->CreateHeap(&Desc, MY_IID_PPV_ARGS(&Heap)));
+				set->Heaps.push_back(Heap);
+				set->HeapSizes.push_back(size_t(Desc.SizeInBytes));
+			}
+			g_CurrentTransientHeaps = set.get();
+			g_TransientHeapSets.push_back(std::move(set));
+		}
+		g_CurrentTransientHeaps->LastUsedFrame = g_TransientHeapFrame;
+	}
+
+	// Hands the set of this frame back with the last fence of the graphics queue, and destroys sets that sat unused for
+	// kTransientPoolMaxUnusedFrames frames, e.g. those too small for the graph since it grew.
+	inline void RetireTransientHeaps()
+	{
+		if (g_CurrentTransientHeaps != nullptr)
+			g_CurrentTransientHeaps->Fence = Graphics::g_CommandManager.GetGraphicsQueue().GetNextFenceValue() - 1;
+		g_CurrentTransientHeaps = nullptr;
+		g_TransientHeapFrame++;
+
+		for (std::size_t i = 0; i < g_TransientHeapSets.size();)
+		{
+			auto& set = g_TransientHeapSets[i];
+			if (g_TransientHeapFrame - set->LastUsedFrame > kTransientPoolMaxUnusedFrames && Graphics::g_CommandManager.IsFenceComplete(set->Fence))
+			{
+				if (i + 1 != g_TransientHeapSets.size())
+					set = std::move(g_TransientHeapSets.back());
+				g_TransientHeapSets.pop_back();
+			}
+			else
+				++i;
+		}
+	}
+
+	// Call once per frame after the framegraph has executed.
+	inline void UpdateTransientPools()
+	{
+		RetireTransientHeaps();
+		g_ColorBufferPool.NextFrame();
+		g_DepthBufferPool.NextFrame();
+		g_ShadowBufferPool.NextFrame();
+		g_ByteAddressBufferPool.NextFrame();
+		g_IndirectArgsBufferPool.NextFrame();
+		g_StructuredBufferPool.NextFrame();
+		g_TypedBufferPool.NextFrame();
+	}
+
+	// Destroys every pooled transient and the transient heaps. Call with the GPU idle, e.g. on shutdown.
+	inline void DestroyTransientPools()
+	{
+		g_CurrentTransientHeaps = nullptr;
+		g_TransientHeapSets.clear();
+		g_ColorBufferPool.Clear();
+		g_DepthBufferPool.Clear();
+		g_ShadowBufferPool.Clear();
+		g_ByteAddressBufferPool.Clear();
+		g_IndirectArgsBufferPool.Clear();
+		g_StructuredBufferPool.Clear();
+		g_TypedBufferPool.Clear();
+	}
+
+	inline TransientPoolStats GetTransientPoolTotals()
+	{
+		TransientPoolStats stats;
+		stats += g_ColorBufferPool.Totals();
+		stats += g_DepthBufferPool.Totals();
+		stats += g_ShadowBufferPool.Totals();
+		stats += g_ByteAddressBufferPool.Totals();
+		stats += g_IndirectArgsBufferPool.Totals();
+		stats += g_StructuredBufferPool.Totals();
+		stats += g_TypedBufferPool.Totals();
+		return stats;
+	}
+
+	// Counters since the last UpdateTransientPools(). Misses are GPU resource creations, so this is zero in steady state.
+	inline TransientPoolStats GetTransientPoolFrameStats()
+	{
+		TransientPoolStats stats;
+		stats += g_ColorBufferPool.FrameStats();
+		stats += g_DepthBufferPool.FrameStats();
+		stats += g_ShadowBufferPool.FrameStats();
+		stats += g_ByteAddressBufferPool.FrameStats();
+		stats += g_IndirectArgsBufferPool.FrameStats();
+		stats += g_StructuredBufferPool.FrameStats();
+		stats += g_TypedBufferPool.FrameStats();
+		return stats;
+	}
+
+	// The samples per pixel of the texture CreateTransientActual() creates.
+	inline uint32_t ColorSampleCount(const ColorBufferDescription& description)
+	{
+		return description.NumColorSamples >= description.NumCoverageSamples && description.NumColorSamples > 1 ? description.NumColorSamples : 1;
+	}
+
+	// Creates the actual of a transient in memory of its own, or at HeapOffset in Heap when one is given.
+	inline std::unique_ptr<ColorBuffer> CreateTransientActual(const ColorBufferDescription& description, ID3D12Heap* Heap, uint64_t HeapOffset)
 	{
 		std::unique_ptr<ColorBuffer> _ColorBuffer = std::make_unique<ColorBuffer>();
 		if (description.NumColorSamples >= description.NumCoverageSamples) {
@@ -86,9 +365,10 @@ namespace FG
 				_ColorBuffer->SetMsaaMode(description.NumColorSamples, description.NumCoverageSamples);
 			}
 		}
+		_ColorBuffer->SetPlacement(Heap, HeapOffset);
 		ASSERT(!(description.NumMips > 0 && description.ArrayCount > 0));
 		if (description.ArrayCount > 0) {
-			_ColorBuffer->Create(L"TmpColorArray", description.Width, description.Height, 
+			_ColorBuffer->CreateArray(L"TmpColorArray", description.Width, description.Height, 
 				description.ArrayCount, description.Format);
 		} else {
 			_ColorBuffer->Create(L"TmpColorBuffer", description.Width, description.Height,
@@ -97,109 +377,578 @@ namespace FG
 		return _ColorBuffer;
 	}
 
-	template<>
-	std::unique_ptr<DepthBuffer> Realize(const DepthBufferDescription& description)
+	inline std::unique_ptr<DepthBuffer> CreateTransientActual(const DepthBufferDescription& description, ID3D12Heap* Heap, uint64_t HeapOffset)
 	{
 		std::unique_ptr<DepthBuffer> _DepthBuffer = 
 			std::make_unique<DepthBuffer>(description.ClearDepth, description.ClearStencil);
+		_DepthBuffer->SetPlacement(Heap, HeapOffset);
 		if (description.NumSamples > 1) {
-			_DepthBuffer->Create(L"TmpDepthBuffer", description.Width, description.Height, description.Format, description.NumSamples);
+			_DepthBuffer->Create(L"TmpDepthBuffer", description.Width, description.Height, description.NumSamples, description.Format);
 		} else {
 			_DepthBuffer->Create(L"TmpDepthBuffer", description.Width, description.Height, description.Format);
 		}
 		return _DepthBuffer;
 	}
 
-	template<>
-	std::unique_ptr<ShadowBuffer> Realize(const ShadowBufferDescription& description)
+	inline std::unique_ptr<ShadowBuffer> CreateTransientActual(const ShadowBufferDescription& description, ID3D12Heap* Heap, uint64_t HeapOffset)
 	{
 		std::unique_ptr<ShadowBuffer> _ShadowBuffer = std::make_unique<ShadowBuffer>();
+		_ShadowBuffer->SetPlacement(Heap, HeapOffset);
 		_ShadowBuffer->Create(L"TmpShadowBuffer", description.Width, description.Height);
 		return _ShadowBuffer;
 	}
 
-	template<>
-	std::unique_ptr<ByteAddressBuffer> Realize(const ByteAddressBufferDescription& description)
+	template<typename BufferType>
+	inline void CreateTransientBuffer(BufferType& Buffer, const std::wstring& Name, uint32_t NumElements, uint32_t ElementSize, ID3D12Heap* Heap, uint64_t HeapOffset)
+	{
+		if (Heap == nullptr) {
+			Buffer.Create(Name, NumElements, ElementSize);
+		} else {
+			ASSERT(HeapOffset <= UINT32_MAX, "GpuBuffer::CreatePlaced() takes 32-bit heap offsets");
+			Buffer.CreatePlaced(Name, Heap, uint32_t(HeapOffset), NumElements, ElementSize);
+		}
+	}
+
+	inline std::unique_ptr<ByteAddressBuffer> CreateTransientActual(const ByteAddressBufferDescription& description, ID3D12Heap* Heap, uint64_t HeapOffset)
 	{
 		std::unique_ptr<ByteAddressBuffer> _ByteAddressBuffer = std::make_unique<ByteAddressBuffer>();
-		_ByteAddressBuffer->Create(L"TmpByteAddressBuffer", description.NumElements, description.ElementSize);
+		CreateTransientBuffer(*_ByteAddressBuffer, L"TmpByteAddressBuffer", description.NumElements, description.ElementSize, Heap, HeapOffset);
 		return _ByteAddressBuffer;
 	}
 
-	template<>
-	std::unique_ptr<IndirectArgsBuffer> Realize(const IndirectArgsBufferDescription& description)
+	inline std::unique_ptr<IndirectArgsBuffer> CreateTransientActual(const IndirectArgsBufferDescription& description, ID3D12Heap* Heap, uint64_t HeapOffset)
 	{
 		std::unique_ptr<IndirectArgsBuffer> _IndirectArgsBuffer = std::make_unique<IndirectArgsBuffer>();
-		_IndirectArgsBuffer->Create(L"TmpIndirectArgsBuffer", description.NumElements, description.ElementSize);
+		CreateTransientBuffer(*_IndirectArgsBuffer, L"TmpIndirectArgsBuffer", description.NumElements, description.ElementSize, Heap, HeapOffset);
 		return _IndirectArgsBuffer;
 	}
 
-	template<>
-	std::unique_ptr<StructuredBuffer> Realize(const StructuredBufferDescription& description)
+	inline std::unique_ptr<StructuredBuffer> CreateTransientActual(const StructuredBufferDescription& description, ID3D12Heap* Heap, uint64_t HeapOffset)
 	{
 		std::unique_ptr<StructuredBuffer> _StructuredBuffer = std::make_unique<StructuredBuffer>();
-		_StructuredBuffer->Create(L"TmpStructuredBuffer", description.NumElements, description.ElementSize);
+		CreateTransientBuffer(*_StructuredBuffer, L"TmpStructuredBuffer", description.NumElements, description.ElementSize, Heap, HeapOffset);
 		return _StructuredBuffer;
 	}
 
-	template<>
-	std::unique_ptr<TypedBuffer> Realize(const TypedBufferDescription& description)
+	inline std::unique_ptr<TypedBuffer> CreateTransientActual(const TypedBufferDescription& description, ID3D12Heap* Heap, uint64_t HeapOffset)
 	{
 		std::unique_ptr<TypedBuffer> _TypedBuffer = std::make_unique<TypedBuffer>(description.Format);
-		_TypedBuffer->Create(L"TmpTypedBuffer", description.NumElements, description.ElementSize);
+		CreateTransientBuffer(*_TypedBuffer, L"TmpTypedBuffer", description.NumElements, description.ElementSize, Heap, HeapOffset);
 		return _TypedBuffer;
 	}
 
+	template<>
+	std::unique_ptr<ColorBuffer> Realize(const ColorBufferDescription& description)
+	{
+		if (auto pooled = g_ColorBufferPool.Acquire(description))
+			return pooled;
+
+		return CreateTransientActual(description, nullptr, 0);
+	}
+
+	template<>
+	std::unique_ptr<DepthBuffer> Realize(const DepthBufferDescription& description)
+	{
+		if (auto pooled = g_DepthBufferPool.Acquire(description))
+			return pooled;
+
+		return CreateTransientActual(description, nullptr, 0);
+	}
+
+	template<>
+	std::unique_ptr<ShadowBuffer> Realize(const ShadowBufferDescription& description)
+	{
+		if (auto pooled = g_ShadowBufferPool.Acquire(description))
+			return pooled;
+
+		return CreateTransientActual(description, nullptr, 0);
+	}
+
+	template<>
+	std::unique_ptr<ByteAddressBuffer> Realize(const ByteAddressBufferDescription& description)
+	{
+		if (auto pooled = g_ByteAddressBufferPool.Acquire(description))
+			return pooled;
+
+		return CreateTransientActual(description, nullptr, 0);
+	}
+
+	template<>
+	std::unique_ptr<IndirectArgsBuffer> Realize(const IndirectArgsBufferDescription& description)
+	{
+		if (auto pooled = g_IndirectArgsBufferPool.Acquire(description))
+			return pooled;
+
+		return CreateTransientActual(description, nullptr, 0);
+	}
+
+	template<>
+	std::unique_ptr<StructuredBuffer> Realize(const StructuredBufferDescription& description)
+	{
+		if (auto pooled = g_StructuredBufferPool.Acquire(description))
+			return pooled;
+
+		return CreateTransientActual(description, nullptr, 0);
+	}
+
+	template<>
+	std::unique_ptr<TypedBuffer> Realize(const TypedBufferDescription& description)
+	{
+		if (auto pooled = g_TypedBufferPool.Acquire(description))
+			return pooled;
+
+		return CreateTransientActual(description, nullptr, 0);
+	}
+
+
+
+	template<>
+	void DeRealize(const ColorBufferDescription& description, std::unique_ptr<ColorBuffer>& actual_ptr, std::uint64_t fence)
+	{
+		g_ColorBufferPool.Release(description, std::move(actual_ptr), fence);
+	}
+
+	template<>
+	void DeRealize(const DepthBufferDescription& description, std::unique_ptr<DepthBuffer>& actual_ptr, std::uint64_t fence)
+	{
+		g_DepthBufferPool.Release(description, std::move(actual_ptr), fence);
+	}
+
+	template<>
+	void DeRealize(const ShadowBufferDescription& description, std::unique_ptr<ShadowBuffer>& actual_ptr, std::uint64_t fence)
+	{
+		g_ShadowBufferPool.Release(description, std::move(actual_ptr), fence);
+	}
+
+	template<>
+	void DeRealize(const ByteAddressBufferDescription& description, std::unique_ptr<ByteAddressBuffer>& actual_ptr, std::uint64_t fence)
+	{
+		g_ByteAddressBufferPool.Release(description, std::move(actual_ptr), fence);
+	}
+
+	template<>
+	void DeRealize(const IndirectArgsBufferDescription& description, std::unique_ptr<IndirectArgsBuffer>& actual_ptr, std::uint64_t fence)
+	{
+		g_IndirectArgsBufferPool.Release(description, std::move(actual_ptr), fence);
+	}
+
+	template<>
+	void DeRealize(const StructuredBufferDescription& description, std::unique_ptr<StructuredBuffer>& actual_ptr, std::uint64_t fence)
+	{
+		g_StructuredBufferPool.Release(description, std::move(actual_ptr), fence);
+	}
+
+	template<>
+	void DeRealize(const TypedBufferDescription& description, std::unique_ptr<TypedBuffer>& actual_ptr, std::uint64_t fence)
+	{
+		g_TypedBufferPool.Release(description, std::move(actual_ptr), fence);
+	}
+
+	// Placed transients come from and go back to the heap set of the frame, or to the pools when there is none.
+	template<typename DescriptionType, typename ActualType>
+	std::unique_ptr<ActualType> RealizeInTransientHeap(const DescriptionType& description, const TransientPlacement& placement)
+	{
+		if (g_CurrentTransientHeaps == nullptr)
+			return Realize<DescriptionType, ActualType>(description);
+
+		auto& placed = std::get<PlacedTransients<DescriptionType, ActualType>>(g_CurrentTransientHeaps->Actuals);
+		if (auto actual = placed.Acquire(description, placement))
+			return actual;
+		return CreateTransientActual(description, g_CurrentTransientHeaps->Heaps[placement.heap].Get(), placement.offset);
+	}
+
+	template<typename DescriptionType, typename ActualType>
+	void DeRealizeInTransientHeap(const DescriptionType& description, const TransientPlacement& placement, std::unique_ptr<ActualType>& actual_ptr, std::uint64_t fence)
+	{
+		if (!actual_ptr)
+			return;
+		if (g_CurrentTransientHeaps == nullptr)
+		{
+			DeRealize<DescriptionType, ActualType>(description, actual_ptr, fence);
+			return;
+		}
+
+		auto& placed = std::get<PlacedTransients<DescriptionType, ActualType>>(g_CurrentTransientHeaps->Actuals);
+		placed.Release(description, placement, std::move(actual_ptr));
+	}
+
+	// An aliasing barrier, and for render targets and depth buffers a discard in their writable state.
+	inline void ActivateInTransientHeap(CommandContext& context, GpuResource& actual, D3D12_RESOURCE_STATES DiscardState)
+	{
+		if (g_CurrentTransientHeaps != nullptr)
+			context.ActivatePlacedResource(actual, DiscardState);
+	}
+
+	template<>
+	inline std::unique_ptr<ColorBuffer> RealizePlaced(const ColorBufferDescription& description, const TransientPlacement& placement)
+	{
+		return RealizeInTransientHeap<ColorBufferDescription, ColorBuffer>(description, placement);
+	}
+
+	template<>
+	inline void DeRealizePlaced(const ColorBufferDescription& description, const TransientPlacement& placement, std::unique_ptr<ColorBuffer>& actual_ptr, std::uint64_t fence)
+	{
+		DeRealizeInTransientHeap(description, placement, actual_ptr, fence);
+	}
+
+	template<>
+	inline void Activate<ColorBufferDescription, ColorBuffer>(CommandContext& context, ColorBuffer& actual)
+	{
+		ActivateInTransientHeap(context, actual, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	}
+
+	template<>
+	inline std::unique_ptr<DepthBuffer> RealizePlaced(const DepthBufferDescription& description, const TransientPlacement& placement)
+	{
+		return RealizeInTransientHeap<DepthBufferDescription, DepthBuffer>(description, placement);
+	}
+
+	template<>
+	inline void DeRealizePlaced(const DepthBufferDescription& description, const TransientPlacement& placement, std::unique_ptr<DepthBuffer>& actual_ptr, std::uint64_t fence)
+	{
+		DeRealizeInTransientHeap(description, placement, actual_ptr, fence);
+	}
+
+	template<>
+	inline void Activate<DepthBufferDescription, DepthBuffer>(CommandContext& context, DepthBuffer& actual)
+	{
+		ActivateInTransientHeap(context, actual, D3D12_RESOURCE_STATE_DEPTH_WRITE);
+	}
+
+	template<>
+	inline std::unique_ptr<ShadowBuffer> RealizePlaced(const ShadowBufferDescription& description, const TransientPlacement& placement)
+	{
+		return RealizeInTransientHeap<ShadowBufferDescription, ShadowBuffer>(description, placement);
+	}
+
+	template<>
+	inline void DeRealizePlaced(const ShadowBufferDescription& description, const TransientPlacement& placement, std::unique_ptr<ShadowBuffer>& actual_ptr, std::uint64_t fence)
+	{
+		DeRealizeInTransientHeap(description, placement, actual_ptr, fence);
+	}
+
+	template<>
+	inline void Activate<ShadowBufferDescription, ShadowBuffer>(CommandContext& context, ShadowBuffer& actual)
+	{
+		ActivateInTransientHeap(context, actual, D3D12_RESOURCE_STATE_DEPTH_WRITE);
+	}
+
+	template<>
+	inline std::unique_ptr<ByteAddressBuffer> RealizePlaced(const ByteAddressBufferDescription& description, const TransientPlacement& placement)
+	{
+		return RealizeInTransientHeap<ByteAddressBufferDescription, ByteAddressBuffer>(description, placement);
+	}
+
+	template<>
+	inline void DeRealizePlaced(const ByteAddressBufferDescription& description, const TransientPlacement& placement, std::unique_ptr<ByteAddressBuffer>& actual_ptr, std::uint64_t fence)
+	{
+		DeRealizeInTransientHeap(description, placement, actual_ptr, fence);
+	}
+
+	template<>
+	inline void Activate<ByteAddressBufferDescription, ByteAddressBuffer>(CommandContext& context, ByteAddressBuffer& actual)
+	{
+		ActivateInTransientHeap(context, actual, D3D12_RESOURCE_STATE_COMMON);
+	}
+
+	template<>
+	inline std::unique_ptr<IndirectArgsBuffer> RealizePlaced(const IndirectArgsBufferDescription& description, const TransientPlacement& placement)
+	{
+		return RealizeInTransientHeap<IndirectArgsBufferDescription, IndirectArgsBuffer>(description, placement);
+	}
 
+	template<>
+	inline void DeRealizePlaced(const IndirectArgsBufferDescription& description, const TransientPlacement& placement, std::unique_ptr<IndirectArgsBuffer>& actual_ptr, std::uint64_t fence)
+	{
+		DeRealizeInTransientHeap(description, placement, actual_ptr, fence);
+	}
 
 	template<>
-	void DeRealize(std::unique_ptr<ColorBuffer>& actual_ptr, int fence)
+	inline void Activate<IndirectArgsBufferDescription, IndirectArgsBuffer>(CommandContext& context, IndirectArgsBuffer& actual)
 	{
-		std::pair<int, std::unique_ptr<ColorBuffer>> cache_pair(fence, std::move(actual_ptr));
-		g_ColorBufferCache.push_back(cache_pair);
+		ActivateInTransientHeap(context, actual, D3D12_RESOURCE_STATE_COMMON);
 	}
 
 	template<>
-	void DeRealize(std::unique_ptr<DepthBuffer>& actual_ptr, int fence)
+	inline std::unique_ptr<StructuredBuffer> RealizePlaced(const StructuredBufferDescription& description, const TransientPlacement& placement)
 	{
-		std::pair<int, std::unique_ptr<DepthBuffer>> cache_pair(fence, std::move(actual_ptr));
-		g_DepthBufferCache.push_back(cache_pair);
+		return RealizeInTransientHeap<StructuredBufferDescription, StructuredBuffer>(description, placement);
 	}
 
 	template<>
-	void DeRealize(std::unique_ptr<ShadowBuffer>& actual_ptr, int fence)
+	inline void DeRealizePlaced(const StructuredBufferDescription& description, const TransientPlacement& placement, std::unique_ptr<StructuredBuffer>& actual_ptr, std::uint64_t fence)
 	{
-		std::pair<int, std::unique_ptr<ShadowBuffer>> cache_pair(fence, std::move(actual_ptr));
-		g_ShadowBufferCache.push_back(cache_pair);
+		DeRealizeInTransientHeap(description, placement, actual_ptr, fence);
 	}
 
 	template<>
-	void DeRealize(std::unique_ptr<ByteAddressBuffer>& actual_ptr, int fence)
+	inline void Activate<StructuredBufferDescription, StructuredBuffer>(CommandContext& context, StructuredBuffer& actual)
 	{
-		std::pair<int, std::unique_ptr<ByteAddressBuffer>> cache_pair(fence, std::move(actual_ptr));
-		g_ByteAddressBufferCache.push_back(cache_pair);
+		ActivateInTransientHeap(context, actual, D3D12_RESOURCE_STATE_COMMON);
 	}
 
 	template<>
-	void DeRealize(std::unique_ptr<IndirectArgsBuffer>& actual_ptr, int fence)
+	inline std::unique_ptr<TypedBuffer> RealizePlaced(const TypedBufferDescription& description, const TransientPlacement& placement)
 	{
-		std::pair<int, std::unique_ptr<IndirectArgsBuffer>> cache_pair(fence, std::move(actual_ptr));
-		g_IndirectArgsBufferCache.push_back(cache_pair);
+		return RealizeInTransientHeap<TypedBufferDescription, TypedBuffer>(description, placement);
 	}
 
 	template<>
-	void DeRealize(std::unique_ptr<StructuredBuffer>& actual_ptr, int fence)
+	inline void DeRealizePlaced(const TypedBufferDescription& description, const TransientPlacement& placement, std::unique_ptr<TypedBuffer>& actual_ptr, std::uint64_t fence)
 	{
-		std::pair<int, std::unique_ptr<StructuredBuffer>> cache_pair(fence, std::move(actual_ptr));
-		g_StructuredBufferCache.push_back(cache_pair);
+		DeRealizeInTransientHeap(description, placement, actual_ptr, fence);
 	}
 
 	template<>
-	void DeRealize(std::unique_ptr<TypedBuffer>& actual_ptr, int fence)
+	inline void Activate<TypedBufferDescription, TypedBuffer>(CommandContext& context, TypedBuffer& actual)
+	{
+		ActivateInTransientHeap(context, actual, D3D12_RESOURCE_STATE_COMMON);
+	}
+
+
+	// Like ColorBuffer::Create(), which makes zero mips a full chain down to 1x1.
+	inline uint32_t TextureMipCount(uint32_t Width, uint32_t Height, uint32_t NumMips)
+	{
+		if (NumMips > 0 || (Width | Height) == 0)
+			return NumMips > 0 ? NumMips : 1;
+
+		uint32_t HighBit;
+		_BitScanReverse((unsigned long*)&HighBit, Width | Height);
+		return HighBit + 1;
+	}
+
+	// Size and alignment of a 2D texture as a placed resource, as the driver lays it out. The description matches the
+	// one the texture's Create() builds.
+	inline TransientMemoryRequirements TextureMemoryRequirements(uint32_t Width, uint32_t Height, uint32_t ArraySize,
+		uint32_t NumMips, DXGI_FORMAT Format, uint32_t NumSamples, D3D12_RESOURCE_FLAGS Flags)
+	{
+		TransientMemoryRequirements requirements;
+		if (Width == 0 || Height == 0)
+			return requirements;
+
+		const D3D12_RESOURCE_DESC Desc = CD3DX12_RESOURCE_DESC::Tex2D(Format, Width, Height, UINT16(ArraySize > 0 ? ArraySize : 1),
+			UINT16(TextureMipCount(Width, Height, NumMips)), NumSamples > 1 ? NumSamples : 1, 0, Flags);
+		const D3D12_RESOURCE_ALLOCATION_INFO Info = Graphics::g_Device->GetResourceAllocationInfo(0, 1, &Desc);
+		if (Info.SizeInBytes == UINT64_MAX)
+			return requirements; // Not a valid texture; it keeps its own allocation and fails there.
+
+		requirements.alignment = size_t(Info.Alignment);
+		requirements.size = size_t(Info.SizeInBytes);
+		return requirements;
+	}
+
+	inline TransientMemoryRequirements BufferMemoryRequirements(uint32_t NumElements, uint32_t ElementSize)
+	{
+		TransientMemoryRequirements requirements;
+		requirements.alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+		requirements.size = AlignTransientOffset(size_t(NumElements) * ElementSize, requirements.alignment);
+		return requirements;
+	}
+
+	// Buffers are only placed where the transient heaps may hold them, see TransientHeapsHoldBuffers().
+	inline TransientMemoryRequirements PlacedBufferRequirements(uint32_t NumElements, uint32_t ElementSize)
 	{
-		std::pair<int, std::unique_ptr<TypedBuffer>> cache_pair(fence, std::move(actual_ptr));
-		g_TypedBufferCache.push_back(cache_pair);
+		return TransientHeapsHoldBuffers() ? BufferMemoryRequirements(NumElements, ElementSize) : TransientMemoryRequirements();
 	}
 
+	template<>
+	inline TransientMemoryRequirements MemoryRequirements<ColorBufferDescription, ColorBuffer>(const ColorBufferDescription& description)
+	{
+		const uint32_t NumSamples = ColorSampleCount(description);
+		const D3D12_RESOURCE_FLAGS Flags = D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | (NumSamples == 1 ? D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS : D3D12_RESOURCE_FLAG_NONE);
+		return TextureMemoryRequirements(description.Width, description.Height, description.ArrayCount,
+			description.ArrayCount > 0 ? 1 : description.NumMips, description.Format, NumSamples, Flags);
+	}
+
+	template<>
+	inline TransientMemoryRequirements MemoryRequirements<DepthBufferDescription, DepthBuffer>(const DepthBufferDescription& description)
+	{
+		return TextureMemoryRequirements(description.Width, description.Height, 1, 1, description.Format, description.NumSamples, D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL);
+	}
+
+	template<>
+	inline TransientMemoryRequirements MemoryRequirements<ShadowBufferDescription, ShadowBuffer>(const ShadowBufferDescription& description)
+	{
+		return TextureMemoryRequirements(description.Width, description.Height, 1, 1, DXGI_FORMAT_D16_UNORM, 1, D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL);
+	}
+
+	template<>
+	inline TransientMemoryRequirements MemoryRequirements<ByteAddressBufferDescription, ByteAddressBuffer>(const ByteAddressBufferDescription& description)
+	{
+		return PlacedBufferRequirements(description.NumElements, description.ElementSize);
+	}
+
+	template<>
+	inline TransientMemoryRequirements MemoryRequirements<IndirectArgsBufferDescription, IndirectArgsBuffer>(const IndirectArgsBufferDescription& description)
+	{
+		return PlacedBufferRequirements(description.NumElements, description.ElementSize);
+	}
+
+	template<>
+	inline TransientMemoryRequirements MemoryRequirements<StructuredBufferDescription, StructuredBuffer>(const StructuredBufferDescription& description)
+	{
+		return PlacedBufferRequirements(description.NumElements, description.ElementSize);
+	}
+
+	template<>
+	inline TransientMemoryRequirements MemoryRequirements<TypedBufferDescription, TypedBuffer>(const TypedBufferDescription& description)
+	{
+		return PlacedBufferRequirements(description.NumElements, description.ElementSize);
+	}
+
+	// Color buffers are either mipmapped or arrays, see Realize(). The other resources are tracked as a whole.
+	template<>
+	inline SubresourceLayout Subresources<ColorBufferDescription, ColorBuffer>(const ColorBufferDescription& description)
+	{
+		if (description.ArrayCount > 0)
+			return SubresourceLayout{ 1, description.ArrayCount };
+		return SubresourceLayout{ TextureMipCount(description.Width, description.Height, description.NumMips), 1 };
+	}
+
+	inline D3D12_RESOURCE_STATES GetResourceStates(ResourceAccess access)
+	{
+		D3D12_RESOURCE_STATES states = D3D12_RESOURCE_STATE_COMMON;
+		if ((access & ResourceAccess::ShaderResource) != ResourceAccess::None)
+			states |= D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
+		if ((access & ResourceAccess::UnorderedAccess) != ResourceAccess::None)
+			states |= D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
+		if ((access & ResourceAccess::RenderTarget) != ResourceAccess::None)
+			states |= D3D12_RESOURCE_STATE_RENDER_TARGET;
+		if ((access & ResourceAccess::DepthWrite) != ResourceAccess::None)
+			states |= D3D12_RESOURCE_STATE_DEPTH_WRITE;
+		if ((access & ResourceAccess::DepthRead) != ResourceAccess::None)
+			states |= D3D12_RESOURCE_STATE_DEPTH_READ;
+		if ((access & ResourceAccess::CopySource) != ResourceAccess::None)
+			states |= D3D12_RESOURCE_STATE_COPY_SOURCE;
+		if ((access & ResourceAccess::CopyDest) != ResourceAccess::None)
+			states |= D3D12_RESOURCE_STATE_COPY_DEST;
+		if ((access & ResourceAccess::IndirectArgument) != ResourceAccess::None)
+			states |= D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT;
+		return states;
+	}
+
+	// The barriers are only buffered here. CommandContext flushes them as one batch ahead of the pass's first command.
+	// A whole resource is transitioned from the state CommandContext tracks for it, a range of subresources from the
+	// state the framegraph tracked for the range. Transitions of ranges leave the tracked state alone until they settle.
+	inline void TransitionGpuResource(CommandContext& context, GpuResource& actual, ResourceAccess before, ResourceAccess after, const SubresourceRange& range, BarrierPhase phase)
+	{
+		if (phase == BarrierPhase::Settled)
+		{
+			context.AssumeResourceState(actual, GetResourceStates(after));
+			return;
+		}
+		if (range.All())
+		{
+			if (phase == BarrierPhase::Begin)
+				context.BeginResourceTransition(actual, GetResourceStates(after));
+			else
+				context.TransitionResource(actual, GetResourceStates(after));
+			return;
+		}
+
+		const D3D12_RESOURCE_BARRIER_FLAGS flags = phase == BarrierPhase::Begin ? D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY :
+			phase == BarrierPhase::End ? D3D12_RESOURCE_BARRIER_FLAG_END_ONLY : D3D12_RESOURCE_BARRIER_FLAG_NONE;
+		context.TransitionSubresources(actual, range.firstMip, range.mipCount, range.firstSlice, range.sliceCount,
+			GetResourceStates(before), GetResourceStates(after), flags);
+	}
+
+	template<>
+	inline void Transition<ColorBufferDescription, ColorBuffer>(CommandContext& context, ColorBuffer& actual, const ResourceAccess before, const ResourceAccess after, const SubresourceRange& range, const BarrierPhase phase)
+	{
+		TransitionGpuResource(context, actual, before, after, range, phase);
+	}
+
+	template<>
+	inline void Transition<DepthBufferDescription, DepthBuffer>(CommandContext& context, DepthBuffer& actual, const ResourceAccess before, const ResourceAccess after, const SubresourceRange& range, const BarrierPhase phase)
+	{
+		TransitionGpuResource(context, actual, before, after, range, phase);
+	}
+
+	template<>
+	inline void Transition<ShadowBufferDescription, ShadowBuffer>(CommandContext& context, ShadowBuffer& actual, const ResourceAccess before, const ResourceAccess after, const SubresourceRange& range, const BarrierPhase phase)
+	{
+		TransitionGpuResource(context, actual, before, after, range, phase);
+	}
+
+	template<>
+	inline void Transition<ByteAddressBufferDescription, ByteAddressBuffer>(CommandContext& context, ByteAddressBuffer& actual, const ResourceAccess before, const ResourceAccess after, const SubresourceRange& range, const BarrierPhase phase)
+	{
+		TransitionGpuResource(context, actual, before, after, range, phase);
+	}
+
+	template<>
+	inline void Transition<IndirectArgsBufferDescription, IndirectArgsBuffer>(CommandContext& context, IndirectArgsBuffer& actual, const ResourceAccess before, const ResourceAccess after, const SubresourceRange& range, const BarrierPhase phase)
+	{
+		TransitionGpuResource(context, actual, before, after, range, phase);
+	}
+
+	template<>
+	inline void Transition<StructuredBufferDescription, StructuredBuffer>(CommandContext& context, StructuredBuffer& actual, const ResourceAccess before, const ResourceAccess after, const SubresourceRange& range, const BarrierPhase phase)
+	{
+		TransitionGpuResource(context, actual, before, after, range, phase);
+	}
+
+	template<>
+	inline void Transition<TypedBufferDescription, TypedBuffer>(CommandContext& context, TypedBuffer& actual, const ResourceAccess before, const ResourceAccess after, const SubresourceRange& range, const BarrierPhase phase)
+	{
+		TransitionGpuResource(context, actual, before, after, range, phase);
+	}
+
+	// Records each batch of passes into a fresh CommandContext of its queue's type and submits it to that queue.
+	class CommandContextRecorder : public CommandRecorder
+	{
+	public:
+		CommandContext& Begin(const std::string& name, const QueueType queue) override
+		{
+			switch (queue)
+			{
+			case QueueType::Compute:
+				return ComputeContext::Begin(Utility::UTF8ToWideString(name), true);
+			case QueueType::Copy:
+			{
+				// Copy contexts have no Begin() of their own, so they go without a profiling block.
+				auto context = Graphics::g_ContextManager.AllocateContext(D3D12_COMMAND_LIST_TYPE_COPY);
+				ASSERT(context != nullptr);
+				return *context;
+			}
+			default:
+				return CommandContext::Begin(Utility::UTF8ToWideString(name));
+			}
+		}
+		std::uint64_t Finish(CommandContext& context) override
+		{
+			return context.Finish();
+		}
+		void Wait(const QueueType queue, const std::uint64_t fence) override
+		{
+			Graphics::g_CommandManager.GetQueue(GetCommandListType(queue)).StallForFence(fence);
+		}
+		// An EngineProfiling block per pass, timed on the CPU and, through timestamp queries, on the GPU. Copy queues
+		// go without, like their contexts.
+		void BeginPass(CommandContext& context, const std::string_view name, const QueueType queue) override
+		{
+			if (queue != QueueType::Copy)
+				EngineProfiling::BeginBlock(Utility::UTF8ToWideString(std::string(name)), &context);
+		}
+		void EndPass(CommandContext& context, const QueueType queue) override
+		{
+			if (queue != QueueType::Copy)
+				EngineProfiling::EndBlock(&context);
+		}
+
+	protected:
+		static D3D12_COMMAND_LIST_TYPE GetCommandListType(const QueueType queue)
+		{
+			switch (queue)
+			{
+			case QueueType::Compute: return D3D12_COMMAND_LIST_TYPE_COMPUTE;
+			case QueueType::Copy: return D3D12_COMMAND_LIST_TYPE_COPY;
+			default: return D3D12_COMMAND_LIST_TYPE_DIRECT;
+			}
+		}
+	};
+
+	inline CommandContextRecorder g_CommandRecorder;
+
 
 }
\ No newline at end of file
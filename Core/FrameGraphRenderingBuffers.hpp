@@ -0,0 +1,441 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <iomanip>
+#include <ostream>
+
+#include "FrameGraphImpl.hpp"
+#include "BufferManager.h"
+
+namespace FG
+{
+	// Descriptions of the render targets of the individual effects, sized from the display like
+	// Graphics::InitializeRenderingBuffers() sized them when it created them all up front. Effect passes create the
+	// ones they need as transients, so disabled effects hold no memory and enabled ones alias each other. Buffers that
+	// live across frames (linear depth and temporal color) are history resources instead.
+	struct RenderingBufferDescriptions
+	{
+		// History: both are read the frame after they are written.
+		ColorBufferDescription LinearDepth;
+		ColorBufferDescription TemporalColor;
+
+		ColorBufferDescription MinMaxDepth8;
+		ColorBufferDescription MinMaxDepth16;
+		ColorBufferDescription MinMaxDepth32;
+
+		ColorBufferDescription SSAOFullScreen;
+		ColorBufferDescription DepthDownsize[4];
+		ColorBufferDescription DepthTiled[4];
+		ColorBufferDescription AOMerged[4];
+		ColorBufferDescription AOSmooth[3];
+		ColorBufferDescription AOHighQuality[4];
+
+		ColorBufferDescription DoFTileClass;
+		ColorBufferDescription DoFPresortBuffer;
+		ColorBufferDescription DoFPrefilter;
+		ColorBufferDescription DoFBlurColor;
+		ColorBufferDescription DoFBlurAlpha;
+		StructuredBufferDescription DoFWorkQueue;
+		StructuredBufferDescription DoFFastQueue;
+		StructuredBufferDescription DoFFixupQueue;
+
+		ColorBufferDescription MotionPrepBuffer;
+		ColorBufferDescription TemporalMinBound;
+		ColorBufferDescription TemporalMaxBound;
+
+		ColorBufferDescription LumaBuffer;
+		ByteAddressBufferDescription Histogram;
+		ColorBufferDescription LumaLR;
+		ColorBufferDescription BloomUAV[5]; // Each used twice, as a and b.
+		ByteAddressBufferDescription FXAAWorkQueue;
+		TypedBufferDescription FXAAColorQueue;
+
+		ColorBufferDescription GenMipsBuffer;
+	};
+
+	inline ColorBufferDescription DescribeColorBuffer(uint32_t Width, uint32_t Height, DXGI_FORMAT Format, uint32_t NumMips = 1, uint32_t ArrayCount = 0)
+	{
+		return ColorBufferDescription{ Width, Height, NumMips, ArrayCount, Format, 1, 1 };
+	}
+
+	inline RenderingBufferDescriptions DescribeRenderingBuffers(uint32_t bufferWidth, uint32_t bufferHeight)
+	{
+		uint32_t width[7];
+		uint32_t height[7];
+		for (uint32_t level = 0; level < 7; ++level)
+		{
+			width[level] = (bufferWidth + (1u << level) - 1) >> level;
+			height[level] = (bufferHeight + (1u << level) - 1) >> level;
+		}
+		const DXGI_FORMAT hdrFormat = Graphics::DefaultHdrColorFormat;
+
+		RenderingBufferDescriptions d;
+		d.LinearDepth = DescribeColorBuffer(width[0], height[0], DXGI_FORMAT_R16_UNORM);
+		d.TemporalColor = DescribeColorBuffer(width[0], height[0], DXGI_FORMAT_R16G16B16A16_FLOAT);
+
+		d.MinMaxDepth8 = DescribeColorBuffer(width[3], height[3], DXGI_FORMAT_R32_UINT);
+		d.MinMaxDepth16 = DescribeColorBuffer(width[4], height[4], DXGI_FORMAT_R32_UINT);
+		d.MinMaxDepth32 = DescribeColorBuffer(width[5], height[5], DXGI_FORMAT_R32_UINT);
+
+		d.SSAOFullScreen = DescribeColorBuffer(width[0], height[0], DXGI_FORMAT_R8_UNORM);
+		for (uint32_t i = 0; i < 4; ++i)
+		{
+			d.DepthDownsize[i] = DescribeColorBuffer(width[i + 1], height[i + 1], DXGI_FORMAT_R32_FLOAT);
+			d.DepthTiled[i] = DescribeColorBuffer(width[i + 3], height[i + 3], DXGI_FORMAT_R16_FLOAT, 0, 16);
+			d.AOMerged[i] = DescribeColorBuffer(width[i + 1], height[i + 1], DXGI_FORMAT_R8_UNORM);
+			d.AOHighQuality[i] = DescribeColorBuffer(width[i + 1], height[i + 1], DXGI_FORMAT_R8_UNORM);
+		}
+		for (uint32_t i = 0; i < 3; ++i)
+			d.AOSmooth[i] = DescribeColorBuffer(width[i + 1], height[i + 1], DXGI_FORMAT_R8_UNORM);
+
+		d.DoFTileClass = DescribeColorBuffer(width[4], height[4], DXGI_FORMAT_R11G11B10_FLOAT);
+		d.DoFPresortBuffer = DescribeColorBuffer(width[1], height[1], DXGI_FORMAT_R11G11B10_FLOAT);
+		d.DoFPrefilter = DescribeColorBuffer(width[1], height[1], DXGI_FORMAT_R11G11B10_FLOAT);
+		d.DoFBlurColor = DescribeColorBuffer(width[1], height[1], DXGI_FORMAT_R11G11B10_FLOAT);
+		d.DoFBlurAlpha = DescribeColorBuffer(width[1], height[1], DXGI_FORMAT_R8_UNORM);
+		d.DoFWorkQueue = StructuredBufferDescription{ width[4] * height[4], 4 };
+		d.DoFFastQueue = StructuredBufferDescription{ width[4] * height[4], 4 };
+		d.DoFFixupQueue = StructuredBufferDescription{ width[4] * height[4], 4 };
+
+		d.MotionPrepBuffer = DescribeColorBuffer(width[1], height[1], DXGI_FORMAT_R16G16B16A16_FLOAT);
+		d.TemporalMinBound = DescribeColorBuffer(width[0], height[0], DXGI_FORMAT_R11G11B10_FLOAT);
+		d.TemporalMaxBound = DescribeColorBuffer(width[0], height[0], DXGI_FORMAT_R11G11B10_FLOAT);
+
+		// Divisible by 128 so that after dividing by 16, we still have multiples of 8x8 tiles.
+		const uint32_t bloomWidth = bufferWidth > 2560 ? 1280 : 640;
+		const uint32_t bloomHeight = bufferHeight > 1440 ? 768 : 384;
+		d.LumaBuffer = DescribeColorBuffer(width[0], height[0], DXGI_FORMAT_R8_UNORM);
+		d.Histogram = ByteAddressBufferDescription{ 256, 4 };
+		d.LumaLR = DescribeColorBuffer(bloomWidth, bloomHeight, DXGI_FORMAT_R8_UINT);
+		for (uint32_t i = 0; i < 5; ++i)
+			d.BloomUAV[i] = DescribeColorBuffer(bloomWidth >> i, bloomHeight >> i, hdrFormat);
+		const uint32_t fxaaWorkSize = bufferWidth * bufferHeight / 4 + 128;
+		d.FXAAWorkQueue = ByteAddressBufferDescription{ fxaaWorkSize, sizeof(uint32_t) };
+		d.FXAAColorQueue = TypedBufferDescription{ fxaaWorkSize, sizeof(uint32_t), DXGI_FORMAT_R11G11B10_FLOAT };
+
+		d.GenMipsBuffer = DescribeColorBuffer(width[0], height[0], DXGI_FORMAT_R11G11B10_FLOAT, 0);
+		return d;
+	}
+
+	struct RenderingEffects
+	{
+		bool AmbientOcclusion = true;
+		bool ParticleTiling   = true;
+		bool DepthOfField     = true;
+		bool MotionBlur       = true;
+		bool TemporalAA       = true;
+		bool Bloom            = true;
+		bool FXAA             = true;
+		bool GenerateMips     = false; // Only a test of GenerateMipMaps().
+	};
+
+	inline size_t RenderingBufferBytes(const ColorBufferDescription& description)
+	{
+		return MemoryRequirements<ColorBufferDescription, ColorBuffer>(description).size;
+	}
+	inline size_t RenderingBufferBytes(const StructuredBufferDescription& description)
+	{
+		return BufferMemoryRequirements(description.NumElements, description.ElementSize).size;
+	}
+	inline size_t RenderingBufferBytes(const ByteAddressBufferDescription& description)
+	{
+		return BufferMemoryRequirements(description.NumElements, description.ElementSize).size;
+	}
+	inline size_t RenderingBufferBytes(const TypedBufferDescription& description)
+	{
+		return BufferMemoryRequirements(description.NumElements, description.ElementSize).size;
+	}
+
+	// What Graphics::InitializeRenderingBuffers() used to keep resident for the effects, whether they ran or not: every
+	// buffer once, the pairs and the history buffers twice.
+	inline size_t StaticRenderingBufferBytes(const RenderingBufferDescriptions& d)
+	{
+		size_t bytes = 2 * RenderingBufferBytes(d.LinearDepth) + 2 * RenderingBufferBytes(d.TemporalColor);
+		bytes += RenderingBufferBytes(d.MinMaxDepth8) + RenderingBufferBytes(d.MinMaxDepth16) + RenderingBufferBytes(d.MinMaxDepth32);
+
+		bytes += RenderingBufferBytes(d.SSAOFullScreen);
+		for (uint32_t i = 0; i < 4; ++i)
+			bytes += RenderingBufferBytes(d.DepthDownsize[i]) + RenderingBufferBytes(d.DepthTiled[i]) + RenderingBufferBytes(d.AOMerged[i]) + RenderingBufferBytes(d.AOHighQuality[i]);
+		for (uint32_t i = 0; i < 3; ++i)
+			bytes += RenderingBufferBytes(d.AOSmooth[i]);
+
+		bytes += 2 * RenderingBufferBytes(d.DoFTileClass) + RenderingBufferBytes(d.DoFPresortBuffer) + RenderingBufferBytes(d.DoFPrefilter);
+		bytes += 2 * RenderingBufferBytes(d.DoFBlurColor) + 2 * RenderingBufferBytes(d.DoFBlurAlpha);
+		bytes += RenderingBufferBytes(d.DoFWorkQueue) + RenderingBufferBytes(d.DoFFastQueue) + RenderingBufferBytes(d.DoFFixupQueue);
+
+		bytes += RenderingBufferBytes(d.MotionPrepBuffer) + RenderingBufferBytes(d.TemporalMinBound) + RenderingBufferBytes(d.TemporalMaxBound);
+
+		bytes += RenderingBufferBytes(d.LumaBuffer) + RenderingBufferBytes(d.Histogram) + RenderingBufferBytes(d.LumaLR);
+		for (uint32_t i = 0; i < 5; ++i)
+			bytes += 2 * RenderingBufferBytes(d.BloomUAV[i]);
+		bytes += RenderingBufferBytes(d.FXAAWorkQueue) + RenderingBufferBytes(d.FXAAColorQueue);
+
+		return bytes + RenderingBufferBytes(d.GenMipsBuffer);
+	}
+
+	// The history resources of the enabled effects, which the framegraph keeps across frames.
+	inline size_t HistoryRenderingBufferBytes(const RenderingBufferDescriptions& d, const RenderingEffects& effects)
+	{
+		size_t bytes = 0;
+		if (effects.AmbientOcclusion || effects.TemporalAA)
+			bytes += 2 * RenderingBufferBytes(d.LinearDepth);
+		if (effects.TemporalAA)
+			bytes += 2 * RenderingBufferBytes(d.TemporalColor);
+		return bytes;
+	}
+
+	// Declares the transients of the enabled effects in the order a MiniEngine frame uses them, for the lifetimes to
+	// alias on: each effect creates its buffers in the passes that write them and reads them in the passes after. The
+	// passes record nothing; this is what compilation needs to plan the transient heaps, not the effects themselves.
+	// Every effect ends in a pass writing color, which is imported.
+	inline void DeclareRenderingBufferLifetimes(FrameGraph& framegraph, const RenderingBufferDescriptions& descriptions, const RenderingEffects& effects, ColorBufferResource* color)
+	{
+		struct PassData
+		{
+		};
+		struct Resources
+		{
+			const RenderingBufferDescriptions*  d;
+			ColorBufferResource*                color;
+			ColorBufferResource*                created[24];
+			FrameGraphResourceBase*             buffers[3];
+		};
+		Resources resources{ &descriptions, color };
+		auto r = &resources;
+
+		const auto addPass = [&framegraph](const char* name, auto&& setup)
+		{
+			return framegraph.AddRenderPass<PassData>(name, setup, [](const PassData&, CommandContext&) {});
+		};
+		const auto composite = [&addPass, r](const char* name, const size_t count)
+		{
+			addPass(name, [r, count](PassData&, FrameGraphBuilder& builder)
+			{
+				for (size_t i = 0; i < count; ++i)
+					builder.Read(r->created[i], ResourceAccess::ShaderResource);
+				r->color = builder.Write(r->color, ResourceAccess::UnorderedAccess);
+			})->SetCullImmune(true);
+		};
+
+		if (effects.ParticleTiling)
+		{
+			addPass("Particle Depth Bounds", [r](PassData&, FrameGraphBuilder& builder)
+			{
+				r->created[0] = builder.Create<ColorBufferResource>("MinMaxDepth 8x8", r->d->MinMaxDepth8, ResourceAccess::UnorderedAccess);
+				r->created[1] = builder.Create<ColorBufferResource>("MinMaxDepth 16x16", r->d->MinMaxDepth16, ResourceAccess::UnorderedAccess);
+				r->created[2] = builder.Create<ColorBufferResource>("MinMaxDepth 32x32", r->d->MinMaxDepth32, ResourceAccess::UnorderedAccess);
+			});
+			composite("Particles", 3);
+		}
+
+		if (effects.AmbientOcclusion)
+		{
+			addPass("SSAO Prepare Depth", [r](PassData&, FrameGraphBuilder& builder)
+			{
+				for (uint32_t i = 0; i < 4; ++i)
+				{
+					r->created[i] = builder.Create<ColorBufferResource>("Depth Down-Sized", r->d->DepthDownsize[i], ResourceAccess::UnorderedAccess);
+					r->created[4 + i] = builder.Create<ColorBufferResource>("Depth De-Interleaved", r->d->DepthTiled[i], ResourceAccess::UnorderedAccess);
+				}
+			});
+			addPass("SSAO Render", [r](PassData&, FrameGraphBuilder& builder)
+			{
+				for (uint32_t i = 0; i < 4; ++i)
+				{
+					builder.Read(r->created[4 + i], ResourceAccess::ShaderResource);
+					r->created[8 + i] = builder.Create<ColorBufferResource>("AO Re-Interleaved", r->d->AOMerged[i], ResourceAccess::UnorderedAccess);
+					r->created[12 + i] = builder.Create<ColorBufferResource>("AO High Quality", r->d->AOHighQuality[i], ResourceAccess::UnorderedAccess);
+				}
+			});
+			addPass("SSAO Blur And Upsample", [r](PassData&, FrameGraphBuilder& builder)
+			{
+				for (uint32_t i = 0; i < 4; ++i)
+				{
+					builder.Read(r->created[i], ResourceAccess::ShaderResource);
+					builder.Read(r->created[8 + i], ResourceAccess::ShaderResource);
+					builder.Read(r->created[12 + i], ResourceAccess::ShaderResource);
+				}
+				for (uint32_t i = 0; i < 3; ++i)
+					r->created[16 + i] = builder.Create<ColorBufferResource>("AO Smoothed", r->d->AOSmooth[i], ResourceAccess::UnorderedAccess);
+				r->created[0] = builder.Create<ColorBufferResource>("SSAO Full Res", r->d->SSAOFullScreen, ResourceAccess::UnorderedAccess);
+			});
+			composite("Lighting", 1);
+		}
+
+		if (effects.TemporalAA)
+		{
+			addPass("Temporal Resolve", [r](PassData&, FrameGraphBuilder& builder)
+			{
+				builder.Read(r->color, ResourceAccess::ShaderResource);
+				r->created[0] = builder.Create<ColorBufferResource>("Temporal Min Color", r->d->TemporalMinBound, ResourceAccess::UnorderedAccess);
+				r->created[1] = builder.Create<ColorBufferResource>("Temporal Max Color", r->d->TemporalMaxBound, ResourceAccess::UnorderedAccess);
+			});
+			composite("Temporal Sharpen", 2);
+		}
+
+		if (effects.DepthOfField)
+		{
+			addPass("DoF Tile Classification", [r](PassData&, FrameGraphBuilder& builder)
+			{
+				r->created[0] = builder.Create<ColorBufferResource>("DoF Tile Classification Buffer 0", r->d->DoFTileClass, ResourceAccess::UnorderedAccess);
+				r->created[1] = builder.Create<ColorBufferResource>("DoF Tile Classification Buffer 1", r->d->DoFTileClass, ResourceAccess::UnorderedAccess);
+				r->buffers[0] = builder.Create<StructuredBufferResource>("DoF Work Queue", r->d->DoFWorkQueue, ResourceAccess::UnorderedAccess);
+				r->buffers[1] = builder.Create<StructuredBufferResource>("DoF Fast Queue", r->d->DoFFastQueue, ResourceAccess::UnorderedAccess);
+				r->buffers[2] = builder.Create<StructuredBufferResource>("DoF Fixup Queue", r->d->DoFFixupQueue, ResourceAccess::UnorderedAccess);
+			});
+			addPass("DoF Presort", [r](PassData&, FrameGraphBuilder& builder)
+			{
+				builder.Read(r->created[0], ResourceAccess::ShaderResource);
+				builder.Read(static_cast<StructuredBufferResource*>(r->buffers[0]), ResourceAccess::ShaderResource);
+				r->created[2] = builder.Create<ColorBufferResource>("DoF Presort Buffer", r->d->DoFPresortBuffer, ResourceAccess::UnorderedAccess);
+				r->created[3] = builder.Create<ColorBufferResource>("DoF PreFilter Buffer", r->d->DoFPrefilter, ResourceAccess::UnorderedAccess);
+			});
+			addPass("DoF Blur", [r](PassData&, FrameGraphBuilder& builder)
+			{
+				builder.Read(r->created[1], ResourceAccess::ShaderResource);
+				builder.Read(r->created[2], ResourceAccess::ShaderResource);
+				builder.Read(r->created[3], ResourceAccess::ShaderResource);
+				builder.Read(static_cast<StructuredBufferResource*>(r->buffers[1]), ResourceAccess::ShaderResource);
+				builder.Read(static_cast<StructuredBufferResource*>(r->buffers[2]), ResourceAccess::ShaderResource);
+				r->created[0] = builder.Create<ColorBufferResource>("DoF Blur Color 0", r->d->DoFBlurColor, ResourceAccess::UnorderedAccess);
+				r->created[1] = builder.Create<ColorBufferResource>("DoF Blur Color 1", r->d->DoFBlurColor, ResourceAccess::UnorderedAccess);
+				r->created[2] = builder.Create<ColorBufferResource>("DoF FG Alpha 0", r->d->DoFBlurAlpha, ResourceAccess::UnorderedAccess);
+				r->created[3] = builder.Create<ColorBufferResource>("DoF FG Alpha 1", r->d->DoFBlurAlpha, ResourceAccess::UnorderedAccess);
+			});
+			composite("DoF Composite", 4);
+		}
+
+		if (effects.MotionBlur)
+		{
+			addPass("Motion Blur Prep", [r](PassData&, FrameGraphBuilder& builder)
+			{
+				builder.Read(r->color, ResourceAccess::ShaderResource);
+				r->created[0] = builder.Create<ColorBufferResource>("Motion Blur Prep", r->d->MotionPrepBuffer, ResourceAccess::UnorderedAccess);
+			});
+			composite("Motion Blur", 1);
+		}
+
+		// Exposure and tone mapping always run; the luma buffer is only kept for FXAA.
+		addPass("Exposure", [r](PassData&, FrameGraphBuilder& builder)
+		{
+			builder.Read(r->color, ResourceAccess::ShaderResource);
+			r->buffers[0] = builder.Create<ByteAddressBufferResource>("Histogram", r->d->Histogram, ResourceAccess::UnorderedAccess);
+		});
+		if (effects.Bloom)
+		{
+			addPass("Bloom Extract", [r](PassData&, FrameGraphBuilder& builder)
+			{
+				builder.Read(r->color, ResourceAccess::ShaderResource);
+				r->created[10] = builder.Create<ColorBufferResource>("Luma Buffer", r->d->LumaLR, ResourceAccess::UnorderedAccess);
+				r->created[0] = builder.Create<ColorBufferResource>("Bloom Buffer 1a", r->d->BloomUAV[0], ResourceAccess::UnorderedAccess);
+			});
+			addPass("Bloom Downsample", [r](PassData&, FrameGraphBuilder& builder)
+			{
+				builder.Read(r->created[0], ResourceAccess::ShaderResource);
+				for (uint32_t i = 1; i < 5; ++i)
+					r->created[i] = builder.Create<ColorBufferResource>("Bloom Buffer a", r->d->BloomUAV[i], ResourceAccess::UnorderedAccess);
+			});
+			addPass("Bloom Upsample", [r](PassData&, FrameGraphBuilder& builder)
+			{
+				for (uint32_t i = 0; i < 5; ++i)
+				{
+					builder.Read(r->created[i], ResourceAccess::ShaderResource);
+					r->created[5 + i] = builder.Create<ColorBufferResource>("Bloom Buffer b", r->d->BloomUAV[i], ResourceAccess::UnorderedAccess);
+				}
+			});
+		}
+		addPass("Tone Map", [r, bloom = effects.Bloom, fxaa = effects.FXAA](PassData&, FrameGraphBuilder& builder)
+		{
+			builder.Read(static_cast<ByteAddressBufferResource*>(r->buffers[0]), ResourceAccess::ShaderResource);
+			if (bloom)
+				builder.Read(r->created[5], ResourceAccess::ShaderResource);
+			if (fxaa)
+				r->created[0] = builder.Create<ColorBufferResource>("Luminance", r->d->LumaBuffer, ResourceAccess::UnorderedAccess);
+			r->color = builder.Write(r->color, ResourceAccess::UnorderedAccess);
+		})->SetCullImmune(true);
+
+		if (effects.FXAA)
+		{
+			addPass("FXAA Pass 1", [r](PassData&, FrameGraphBuilder& builder)
+			{
+				builder.Read(r->created[0], ResourceAccess::ShaderResource);
+				builder.Read(r->color, ResourceAccess::ShaderResource);
+				r->buffers[1] = builder.Create<ByteAddressBufferResource>("FXAA Work Queue", r->d->FXAAWorkQueue, ResourceAccess::UnorderedAccess);
+				r->buffers[2] = builder.Create<TypedBufferResource>("FXAA Color Queue", r->d->FXAAColorQueue, ResourceAccess::UnorderedAccess);
+			});
+			addPass("FXAA Pass 2", [r](PassData&, FrameGraphBuilder& builder)
+			{
+				builder.Read(static_cast<ByteAddressBufferResource*>(r->buffers[1]), ResourceAccess::ShaderResource);
+				builder.Read(static_cast<TypedBufferResource*>(r->buffers[2]), ResourceAccess::ShaderResource);
+				r->color = builder.Write(r->color, ResourceAccess::UnorderedAccess);
+			})->SetCullImmune(true);
+		}
+
+		if (effects.GenerateMips)
+		{
+			addPass("Generate Mips", [r](PassData&, FrameGraphBuilder& builder)
+			{
+				builder.Read(r->color, ResourceAccess::ShaderResource);
+				r->created[0] = builder.Create<ColorBufferResource>("GenMips", r->d->GenMipsBuffer, ResourceAccess::UnorderedAccess);
+			});
+			composite("Present Mips", 1);
+		}
+	}
+
+	struct RenderingBufferMemoryReport
+	{
+		uint32_t Width = 0;
+		uint32_t Height = 0;
+		size_t StaticBytes = 0;             // Resident all the time when InitializeRenderingBuffers() created every buffer.
+		size_t HistoryBytes = 0;            // Kept across frames by the framegraph for the enabled effects.
+		size_t TransientBytes = 0;          // The aliased transient heaps of the enabled effects.
+		size_t UnaliasedTransientBytes = 0; // The same transients, each in its own allocation.
+
+		size_t GraphManagedBytes() const
+		{
+			return HistoryBytes + TransientBytes;
+		}
+	};
+
+	// Compiles the lifetimes of the enabled effects at the given buffer size; nothing is realized, so the report needs
+	// no GPU work. The buffers InitializeRenderingBuffers() still creates (scene color, depth, normals, velocity,
+	// shadows and the display-sized ones) are left out of both sides.
+	inline RenderingBufferMemoryReport ReportRenderingBufferMemory(uint32_t Width, uint32_t Height, const RenderingEffects& effects = RenderingEffects())
+	{
+		const auto descriptions = DescribeRenderingBuffers(Width, Height);
+
+		RenderingBufferMemoryReport report;
+		report.Width = Width;
+		report.Height = Height;
+		report.StaticBytes = StaticRenderingBufferBytes(descriptions);
+		report.HistoryBytes = HistoryRenderingBufferBytes(descriptions, effects);
+
+		FrameGraph framegraph;
+		auto color = framegraph.AddRetainedResource<ColorBufferDescription, ColorBuffer>("Main Color Buffer", DescribeColorBuffer(Width, Height, Graphics::DefaultHdrColorFormat));
+		DeclareRenderingBufferLifetimes(framegraph, descriptions, effects, color);
+		framegraph.Compile();
+		report.TransientBytes = framegraph.TransientMemory().aliasedBytes;
+		report.UnaliasedTransientBytes = framegraph.TransientMemory().unaliasedBytes;
+		return report;
+	}
+
+	// The static and the graph-managed footprint at 1080p, 1440p and 4K, in MB. The figures are planned, not measured:
+	// the sizes the device reports for the descriptions and the heaps compilation packs the transients into.
+	inline void WriteRenderingBufferMemoryReport(std::ostream& stream, const RenderingEffects& effects = RenderingEffects())
+	{
+		const uint32_t resolutions[][2] = { { 1920, 1080 }, { 2560, 1440 }, { 3840, 2160 } };
+		const auto megabytes = [](size_t bytes) { return double(bytes) / (1024.0 * 1024.0); };
+
+		stream << "Planned rendering buffer memory: allocation sizes from the device and the transient heaps as compiled, nothing allocated\n";
+		stream << "resolution  static MB  history MB  transient MB (unaliased)  graph MB  saved MB\n";
+		for (auto& resolution : resolutions)
+		{
+			const auto report = ReportRenderingBufferMemory(resolution[0], resolution[1], effects);
+			stream << std::setw(4) << report.Width << 'x' << std::left << std::setw(7) << report.Height << std::right << std::fixed << std::setprecision(1)
+				<< std::setw(9) << megabytes(report.StaticBytes) << std::setw(12) << megabytes(report.HistoryBytes)
+				<< std::setw(14) << megabytes(report.TransientBytes) << " (" << std::setw(8) << megabytes(report.UnaliasedTransientBytes) << ")"
+				<< std::setw(12) << megabytes(report.GraphManagedBytes()) << std::setw(10) << megabytes(report.StaticBytes - std::min(report.StaticBytes, report.GraphManagedBytes())) << '\n';
+		}
+	}
+}
@@ -56,6 +56,7 @@ namespace GameCore
     bool UpdateApplication( IGameApp& game )
     {
         EngineProfiling::Update();
+        LinearAllocator::ProcessRetiredPages();
 
         float DeltaTime = Graphics::GetFrameTime();
     
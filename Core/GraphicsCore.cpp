@@ -373,6 +373,14 @@ void Graphics::Initialize(void)
 	g_DescriptorAllocator[D3D12_DESCRIPTOR_HEAP_TYPE_RTV] = new LearnRenderer::CPUDescriptorHeap{ g_Device, 256, D3D12_DESCRIPTOR_HEAP_TYPE_RTV, D3D12_DESCRIPTOR_HEAP_FLAG_NONE };
 	g_DescriptorAllocator[D3D12_DESCRIPTOR_HEAP_TYPE_DSV] = new LearnRenderer::CPUDescriptorHeap{ g_Device, 256, D3D12_DESCRIPTOR_HEAP_TYPE_DSV, D3D12_DESCRIPTOR_HEAP_FLAG_NONE };
 
+	const wchar_t* DescriptorHeapNames[] = { L"CBV_SRV_UAV Descriptors", L"Sampler Descriptors", L"RTV Descriptors", L"DSV Descriptors" };
+	for (uint32_t Type = 0; Type < D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES; ++Type)
+	{
+		LearnRenderer::CPUDescriptorHeap* Heap = g_DescriptorAllocator[Type];
+		EngineProfiling::RegisterAllocator(Heap, DescriptorHeapNames[Type], [Heap]() { return Heap->GetStats(); });
+	}
+	LinearAllocator::RegisterStats();
+
 	// Common state was moved to GraphicsCommon.*
 	InitializeCommonState();
 
@@ -387,6 +395,10 @@ void Graphics::Shutdown(void)
 {
 	g_CommandManager.IdleGPU();
 
+	for (uint32_t Type = 0; Type < D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES; ++Type)
+		EngineProfiling::UnregisterAllocator(g_DescriptorAllocator[Type]);
+	LinearAllocator::UnregisterStats();
+
 	delete g_DescriptorAllocator[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV];
 	delete g_DescriptorAllocator[D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER];
 	delete g_DescriptorAllocator[D3D12_DESCRIPTOR_HEAP_TYPE_RTV];
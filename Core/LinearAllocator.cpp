@@ -17,12 +17,23 @@
 #include "GraphicsCore.h"
 #include "CommandListManager.h"
 #include <thread>
+#include <algorithm>
 
 using namespace Graphics;
 using namespace std;
 
 LinearAllocatorType LinearAllocatorPageManager::sm_AutoType = kGpuExclusive;
 
+namespace
+{
+    IntVar LargePagePoolSizeMB("Graphics/Memory/Large Page Pool (MB)", 64, 0, 1024, 16);
+
+    size_t GetPageSize( LinearAllocationPage* Page )
+    {
+        return (size_t)Page->GetResource()->GetDesc().Width;
+    }
+}
+
 LinearAllocatorPageManager::LinearAllocatorPageManager()
 {
     m_AllocationType = sm_AutoType;
@@ -31,55 +42,242 @@ LinearAllocatorPageManager::LinearAllocatorPageManager()
 }
 
 LinearAllocatorPageManager LinearAllocator::sm_PageManager[2];
+LinearAllocatorRingBuffer LinearAllocator::sm_RingBuffer;
+
+thread_local LinearAllocatorPageManager::PageMagazine LinearAllocatorPageManager::t_Magazines[kNumAllocatorTypes];
+
+LinearAllocatorPageManager::PageMagazine::~PageMagazine()
+{
+    // Hand the pages of an exiting thread back
+    if (Owner != nullptr && Generation == Owner->m_Generation)
+    {
+        while (Count > 0)
+            Owner->m_AvailablePages.Push(Pages[--Count]);
+    }
+}
 
 LinearAllocationPage* LinearAllocatorPageManager::RequestPage()
 {
+    PageMagazine& Magazine = t_Magazines[m_AllocationType];
+    if (Magazine.Owner != this || Magazine.Generation != m_Generation)
+    {
+        Magazine.Owner = this;
+        Magazine.Generation = m_Generation;
+        Magazine.Count = 0;
+    }
+
+    if (Magazine.Count == 0)
+    {
+        // Nothing available: process the retired pages now rather than wait for the next frame, unless
+        // another thread is at it
+        if (m_AvailablePages.IsEmpty() && m_Mutex.try_lock())
+        {
+            RecycleRetiredPages();
+            m_Mutex.unlock();
+        }
+
+        while (Magazine.Count < PageMagazine::kCapacity)
+        {
+            LinearAllocationPage* PagePtr = m_AvailablePages.Pop();
+            if (PagePtr == nullptr)
+                break;
+            Magazine.Pages[Magazine.Count++] = PagePtr;
+        }
+    }
+
+    if (Magazine.Count > 0)
+        return Magazine.Pages[--Magazine.Count];
+
     lock_guard<mutex> LockGuard(m_Mutex);
+    LinearAllocationPage* PagePtr = CreateNewPage();
+    m_PagePool.emplace_back(PagePtr);
+    return PagePtr;
+}
+
+void LinearAllocatorPageManager::DiscardPages( uint64_t FenceValue, const vector<LinearAllocationPage*>& UsedPages )
+{
+    if (UsedPages.empty())
+        return;
 
-    while (!m_RetiredPages.empty() && g_CommandManager.IsFenceComplete(m_RetiredPages.front().first))
+    for (size_t i = 0; i < UsedPages.size(); ++i)
     {
-        m_AvailablePages.push(m_RetiredPages.front().second);
-        m_RetiredPages.pop();
+        UsedPages[i]->m_RetireFence = FenceValue;
+        if (i + 1 < UsedPages.size())
+            UsedPages[i]->m_NextPage.store(UsedPages[i + 1], memory_order_relaxed);
     }
+    m_RetiredPages.PushList(UsedPages.front(), UsedPages.back());
+}
 
-    LinearAllocationPage* PagePtr = nullptr;
+void LinearAllocatorPageManager::ProcessRetiredPages( void )
+{
+    lock_guard<mutex> LockGuard(m_Mutex);
+    RecycleRetiredPages();
+}
 
-    if (!m_AvailablePages.empty())
+void LinearAllocatorPageManager::RecycleRetiredPages( void )
+{
+    // The stack holds the pages in reverse discard order; reverse it so they are mostly in fence order
+    LinearAllocationPage* List = nullptr;
+    for (LinearAllocationPage* PagePtr = m_RetiredPages.PopAll(); PagePtr != nullptr; )
     {
-        PagePtr = m_AvailablePages.front();
-        m_AvailablePages.pop();
+        LinearAllocationPage* NextPage = PagePtr->m_NextPage.load(memory_order_relaxed);
+        PagePtr->m_NextPage.store(List, memory_order_relaxed);
+        List = PagePtr;
+        PagePtr = NextPage;
+    }
+    for (LinearAllocationPage* PagePtr = List; PagePtr != nullptr; PagePtr = PagePtr->m_NextPage.load(memory_order_relaxed))
+    {
+        auto& Pending = m_PendingPages[PagePtr->m_RetireFence >> 56];
+        const PendingPage Page(PagePtr->m_RetireFence, PagePtr);
+        if (Pending.empty() || Pending.back().first <= Page.first)
+            Pending.push_back(Page);
+        else
+            Pending.insert(upper_bound(Pending.begin(), Pending.end(), Page), Page);
+    }
+    // Link the pages whose fence has passed and make them available in one go
+    LinearAllocationPage* First = nullptr;
+    LinearAllocationPage* Last = nullptr;
+    for (auto& Pending : m_PendingPages)
+    {
+        while (!Pending.empty() && g_CommandManager.IsFenceComplete(Pending.front().first))
+        {
+            LinearAllocationPage* PagePtr = Pending.front().second;
+            PagePtr->m_NextPage.store(First, memory_order_relaxed);
+            First = PagePtr;
+            if (Last == nullptr)
+                Last = PagePtr;
+            Pending.pop_front();
+        }
+    }
+    if (First != nullptr)
+        m_AvailablePages.PushList(First, Last);
+}
+
+LinearAllocationPage* LinearAllocatorPageManager::RequestLargePage( size_t PageSize )
+{
+    const uint32_t SizeClass = Math::Log2(PageSize);
+    ASSERT(SizeClass < kNumSizeClasses);
+
+    lock_guard<mutex> LockGuard(m_Mutex);
+
+    RecycleLargePages();
+
+    LinearAllocationPage* PagePtr = nullptr;
+    auto& Bucket = m_LargePagePool[SizeClass];
+    if (!Bucket.empty())
+    {
+        PagePtr = Bucket.back().Page;
+        Bucket.pop_back();
+        m_PooledLargePageBytes -= (size_t)1 << SizeClass;
+        --m_NumPooledLargePages;
     }
     else
     {
-        PagePtr = CreateNewPage();
-        m_PagePool.emplace_back(PagePtr);
+        PagePtr = CreateNewPage((size_t)1 << SizeClass);
+        m_LargePageBytes += (size_t)1 << SizeClass;
+        ++m_NumLargePagesCreated;
     }
 
+    m_PeakLargePageBytesInUse = max(m_PeakLargePageBytesInUse, m_LargePageBytes - m_PooledLargePageBytes);
     return PagePtr;
 }
 
-void LinearAllocatorPageManager::DiscardPages( uint64_t FenceValue, const vector<LinearAllocationPage*>& UsedPages )
+void LinearAllocatorPageManager::FreeLargePages( uint64_t FenceValue, const vector<LinearAllocationPage*>& LargePages )
 {
     lock_guard<mutex> LockGuard(m_Mutex);
-    for (auto iter = UsedPages.begin(); iter != UsedPages.end(); ++iter)
-        m_RetiredPages.push(make_pair(FenceValue, *iter));
+
+    RecycleLargePages();
+
+    for (auto iter = LargePages.begin(); iter != LargePages.end(); ++iter)
+    {
+        m_DeletionQueue.push(make_pair(FenceValue, *iter));
+        m_FreedLargePageBytes += GetPageSize(*iter);
+    }
 }
 
-void LinearAllocatorPageManager::FreeLargePages( uint64_t FenceValue, const vector<LinearAllocationPage*>& LargePages )
+void LinearAllocatorPageManager::RecycleLargePages( void )
+{
+    while (!m_DeletionQueue.empty() && g_CommandManager.IsFenceComplete(m_DeletionQueue.front().first))
+    {
+        LinearAllocationPage* PagePtr = m_DeletionQueue.front().second;
+        const size_t PageSize = GetPageSize(PagePtr);
+        m_DeletionQueue.pop();
+
+        m_FreedLargePageBytes -= PageSize;
+        m_LargePagePool[Math::Log2(PageSize)].push_back({ PagePtr, m_NextRetireIndex++ });
+        m_PooledLargePageBytes += PageSize;
+        ++m_NumPooledLargePages;
+    }
+
+    const size_t MaxPooledBytes = (size_t)(int32_t)LargePagePoolSizeMB << 20;
+    while (m_PooledLargePageBytes > MaxPooledBytes)
+    {
+        // The least recently retired page is at the front of one of the buckets
+        std::deque<PooledPage>* OldestBucket = nullptr;
+        for (auto& Bucket : m_LargePagePool)
+        {
+            if (!Bucket.empty() && (OldestBucket == nullptr || Bucket.front().RetireIndex < OldestBucket->front().RetireIndex))
+                OldestBucket = &Bucket;
+        }
+
+        const size_t PageSize = GetPageSize(OldestBucket->front().Page);
+        delete OldestBucket->front().Page;
+        OldestBucket->pop_front();
+        m_PooledLargePageBytes -= PageSize;
+        m_LargePageBytes -= PageSize;
+        --m_NumPooledLargePages;
+        ++m_NumLargePagesDestroyed;
+    }
+}
+
+AllocatorStats LinearAllocatorPageManager::GetLargePageStats( void )
 {
     lock_guard<mutex> LockGuard(m_Mutex);
 
-    while (!m_DeletionQueue.empty() && g_CommandManager.IsFenceComplete(m_DeletionQueue.front().first))
+    AllocatorStats Stats;
+    Stats.Capacity = m_LargePageBytes;
+    Stats.UsedSize = m_LargePageBytes - m_PooledLargePageBytes;
+    Stats.PeakUsedSize = m_PeakLargePageBytesInUse;
+    Stats.PendingFreeSize = m_FreedLargePageBytes;
+    Stats.FreeBlockCount = m_NumPooledLargePages;
+    for (uint32_t SizeClass = kNumSizeClasses; SizeClass-- > 0; )
+    {
+        if (!m_LargePagePool[SizeClass].empty())
+        {
+            Stats.LargestFreeBlock = (size_t)1 << SizeClass;
+            break;
+        }
+    }
+    Stats.AllocationCount = m_NumLargePagesCreated;
+    Stats.FreeCount = m_NumLargePagesDestroyed;
+    return Stats;
+}
+
+void LinearAllocatorPageManager::Destroy( void )
+{
+    // Magazines still holding pages drop them when they see the new generation
+    ++m_Generation;
+    m_RetiredPages.Clear();
+    m_AvailablePages.Clear();
+    for (auto& Pending : m_PendingPages)
+        Pending = PendingPageQueue();
+    m_PagePool.clear();
+
+    while (!m_DeletionQueue.empty())
     {
         delete m_DeletionQueue.front().second;
         m_DeletionQueue.pop();
     }
-
-    for (auto iter = LargePages.begin(); iter != LargePages.end(); ++iter)
+    for (auto& Bucket : m_LargePagePool)
     {
-        (*iter)->Unmap();
-        m_DeletionQueue.push(make_pair(FenceValue, *iter));
+        for (auto& Pooled : Bucket)
+            delete Pooled.Page;
+        Bucket.clear();
     }
+    m_LargePageBytes = 0;
+    m_PooledLargePageBytes = 0;
+    m_FreedLargePageBytes = 0;
+    m_NumPooledLargePages = 0;
 }
 
 LinearAllocationPage* LinearAllocatorPageManager::CreateNewPage( size_t PageSize  )
@@ -127,8 +325,92 @@ LinearAllocationPage* LinearAllocatorPageManager::CreateNewPage( size_t PageSize
     return new LinearAllocationPage(pBuffer, DefaultUsage);
 }
 
+void LinearAllocatorRingBuffer::ReleaseCompletedChunks( void )
+{
+    while (!m_Chunks.empty() && m_Chunks.front().FenceID != 0 && g_CommandManager.IsFenceComplete(m_Chunks.front().FenceID))
+    {
+        m_UsedSize -= m_Chunks.front().Size;
+        m_Chunks.pop_front();
+        ++m_FirstChunkID;
+    }
+}
+
+bool LinearAllocatorRingBuffer::ReserveChunk( size_t SizeInBytes, size_t& Offset, uint64_t& ChunkID )
+{
+    const size_t ChunkSize = Math::AlignUp(SizeInBytes, kChunkAlignment);
+    if (ChunkSize > kRingBufferSize)
+        return false;
+
+    lock_guard<mutex> LockGuard(m_Mutex);
+
+    if (m_Buffer == nullptr)
+    {
+        m_Buffer.reset(LinearAllocator::sm_PageManager[kCpuWritable].CreateNewPage(kRingBufferSize));
+        m_Buffer->GetResource()->SetName(L"LinearAllocator Ring Buffer");
+    }
+
+    ReleaseCompletedChunks();
+
+    for (;;)
+    {
+        // The free space runs from the head to the end of the ring, then from its start to the tail.  A chunk
+        // that does not fit before the end skips it.
+        const size_t SkippedSize = m_Head + ChunkSize > kRingBufferSize ? kRingBufferSize - m_Head : 0;
+        if (m_UsedSize + SkippedSize + ChunkSize <= kRingBufferSize)
+        {
+            Offset = SkippedSize > 0 ? 0 : m_Head;
+            m_Head = (Offset + ChunkSize) % kRingBufferSize;
+            m_UsedSize += SkippedSize + ChunkSize;
+            ChunkID = m_FirstChunkID + m_Chunks.size();
+            m_Chunks.push_back({ SkippedSize + ChunkSize, 0 });
+            return true;
+        }
+
+        // The GPU is behind: wait for the oldest chunk, unless a context is still recording into it
+        if (m_Chunks.empty() || m_Chunks.front().FenceID == 0)
+            return false;
+
+        g_CommandManager.WaitForFence(m_Chunks.front().FenceID);
+        ReleaseCompletedChunks();
+    }
+}
+
+void LinearAllocatorRingBuffer::RetireChunks( uint64_t FenceID, const vector<uint64_t>& ChunkIDs )
+{
+    lock_guard<mutex> LockGuard(m_Mutex);
+    for (auto ChunkID : ChunkIDs)
+    {
+        ASSERT(ChunkID >= m_FirstChunkID && ChunkID - m_FirstChunkID < m_Chunks.size());
+        m_Chunks[ChunkID - m_FirstChunkID].FenceID = FenceID;
+    }
+}
+
+void LinearAllocatorRingBuffer::Destroy( void )
+{
+    m_Chunks.clear();
+    m_FirstChunkID = 0;
+    m_Head = 0;
+    m_UsedSize = 0;
+    m_Buffer.reset();
+}
+
 void LinearAllocator::CleanupUsedPages( uint64_t FenceID )
 {
+    if (!m_RingChunks.empty())
+    {
+        sm_RingBuffer.RetireChunks(FenceID, m_RingChunks);
+        m_RingChunks.clear();
+        m_RingOffset = 0;
+        m_RingChunkEnd = 0;
+    }
+
+    // Large pages do not depend on the current page: in ring buffer mode there usually is none
+    if (!m_LargePageList.empty())
+    {
+        sm_PageManager[m_AllocationType].FreeLargePages(FenceID, m_LargePageList);
+        m_LargePageList.clear();
+    }
+
     if (m_CurPage == nullptr)
         return;
 
@@ -138,14 +420,25 @@ void LinearAllocator::CleanupUsedPages( uint64_t FenceID )
 
     sm_PageManager[m_AllocationType].DiscardPages(FenceID, m_RetiredPages);
     m_RetiredPages.clear();
+}
 
-    sm_PageManager[m_AllocationType].FreeLargePages(FenceID, m_LargePageList);
-    m_LargePageList.clear();
+void LinearAllocator::RegisterStats( void )
+{
+    EngineProfiling::RegisterAllocator(&sm_PageManager[kGpuExclusive], L"Large Pages (GPU)",
+        []() { return sm_PageManager[kGpuExclusive].GetLargePageStats(); });
+    EngineProfiling::RegisterAllocator(&sm_PageManager[kCpuWritable], L"Large Pages (Upload)",
+        []() { return sm_PageManager[kCpuWritable].GetLargePageStats(); });
+}
+
+void LinearAllocator::UnregisterStats( void )
+{
+    EngineProfiling::UnregisterAllocator(&sm_PageManager[kGpuExclusive]);
+    EngineProfiling::UnregisterAllocator(&sm_PageManager[kCpuWritable]);
 }
 
 DynAlloc LinearAllocator::AllocateLargePage(size_t SizeInBytes)
 {
-    LinearAllocationPage* OneOff = sm_PageManager[m_AllocationType].CreateNewPage(SizeInBytes);
+    LinearAllocationPage* OneOff = sm_PageManager[m_AllocationType].RequestLargePage(SizeInBytes);
     m_LargePageList.push_back(OneOff);
 
     DynAlloc ret(*OneOff, 0, SizeInBytes);
@@ -155,6 +448,38 @@ DynAlloc LinearAllocator::AllocateLargePage(size_t SizeInBytes)
     return ret;
 }
 
+bool LinearAllocator::AllocateFromRingBuffer(size_t SizeInBytes, size_t Alignment, size_t& Offset)
+{
+    ASSERT(Alignment <= LinearAllocatorRingBuffer::kChunkAlignment);
+
+    uint64_t ChunkID;
+
+    // Large allocations get a chunk of their own
+    if (SizeInBytes > m_PageSize)
+    {
+        if (!sm_RingBuffer.ReserveChunk(SizeInBytes, Offset, ChunkID))
+            return false;
+        m_RingChunks.push_back(ChunkID);
+        return true;
+    }
+
+    m_RingOffset = Math::AlignUp(m_RingOffset, Alignment);
+
+    if (m_RingOffset + SizeInBytes > m_RingChunkEnd)
+    {
+        size_t ChunkOffset;
+        if (!sm_RingBuffer.ReserveChunk(m_PageSize, ChunkOffset, ChunkID))
+            return false;
+        m_RingChunks.push_back(ChunkID);
+        m_RingOffset = ChunkOffset;
+        m_RingChunkEnd = ChunkOffset + m_PageSize;
+    }
+
+    Offset = m_RingOffset;
+    m_RingOffset += SizeInBytes;
+    return true;
+}
+
 DynAlloc LinearAllocator::Allocate(size_t SizeInBytes, size_t Alignment)
 {
     const size_t AlignmentMask = Alignment - 1;
@@ -165,6 +490,17 @@ DynAlloc LinearAllocator::Allocate(size_t SizeInBytes, size_t Alignment)
     // Align the allocation
     const size_t AlignedSize = Math::AlignUpWithMask(SizeInBytes, AlignmentMask);
 
+    // When the ring buffer is full of chunks still being recorded into, fall back to pages
+    size_t RingOffset;
+    if (m_UseRingBuffer && AllocateFromRingBuffer(AlignedSize, Alignment, RingOffset))
+    {
+        LinearAllocationPage& RingBuffer = sm_RingBuffer.GetBuffer();
+        DynAlloc ret(RingBuffer, RingOffset, AlignedSize);
+        ret.DataPtr = (uint8_t*)RingBuffer.m_CpuVirtualAddress + RingOffset;
+        ret.GpuAddress = RingBuffer.m_GpuVirtualAddress + RingOffset;
+        return ret;
+    }
+
     if (AlignedSize > m_PageSize)
         return AllocateLargePage(AlignedSize);
 
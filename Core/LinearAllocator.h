@@ -13,19 +13,26 @@
 // Description:  This is a dynamic graphics memory allocator for DX12.  It's designed to work in concert
 // with the CommandContext class and to do so in a thread-safe manner.  There may be many command contexts,
 // each with its own linear allocators.  They act as windows into a global memory pool by reserving a
-// context-local memory page.  Requesting a new page is done in a thread-safe manner by guarding accesses
-// with a mutex lock.
+// context-local memory page.  Requesting a new page is done in a thread-safe manner: each thread takes pages
+// from its own small cache, refilled from a lock-free stack shared by all threads.
 //
 // When a command context is finished, it will receive a fence ID that indicates when it's safe to reclaim
 // used resources.  The CleanupUsedPages() method must be invoked at this time so that the used pages can be
 // scheduled for reuse after the fence has cleared.
+//
+// CPU-writable allocators can instead carve their memory out of one persistently mapped upload ring buffer
+// shared by all of them.  That avoids creating and destroying a committed resource for every allocation larger
+// than a page.
 
 #pragma once
 
 #include "GpuResource.h"
+#include "AllocatorStats.h"
 #include <vector>
 #include <queue>
+#include <deque>
 #include <mutex>
+#include <atomic>
 
 // Constant blocks must be multiples of 16 constants @ 16 bytes each
 #define DEFAULT_ALIGN 256
@@ -78,6 +85,66 @@ public:
 
     void* m_CpuVirtualAddress;
     D3D12_GPU_VIRTUAL_ADDRESS m_GpuVirtualAddress;
+
+    // Links of the page stacks of LinearAllocatorPageManager
+    std::atomic<LinearAllocationPage*> m_NextPage{ nullptr };
+    uint64_t m_RetireFence = 0;
+};
+
+// A lock-free (Treiber) stack of pages linked through m_NextPage.  The top keeps a tag in the upper 16 bits
+// of the pointer, which user-mode addresses leave unused, so that a page popped and pushed back between the
+// read and the swap of another thread does not go unnoticed.  Pages must outlive the stack.
+class LinearAllocationPageStack
+{
+public:
+
+    void Push( LinearAllocationPage* Page ) { PushList(Page, Page); }
+
+    // Pushes the pages First to Last, already linked through m_NextPage
+    void PushList( LinearAllocationPage* First, LinearAllocationPage* Last )
+    {
+        ASSERT(((uint64_t)First >> kPointerBits) == 0);
+        uint64_t Top = m_Top.load(std::memory_order_relaxed);
+        do
+        {
+            Last->m_NextPage.store(GetPointer(Top), std::memory_order_relaxed);
+        } while (!m_Top.compare_exchange_weak(Top, Tag(First, Top), std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    LinearAllocationPage* Pop( void )
+    {
+        uint64_t Top = m_Top.load(std::memory_order_acquire);
+        while (GetPointer(Top) != nullptr)
+        {
+            if (m_Top.compare_exchange_weak(Top, Tag(GetPointer(Top)->m_NextPage.load(std::memory_order_relaxed), Top), std::memory_order_acquire))
+                return GetPointer(Top);
+        }
+        return nullptr;
+    }
+
+    // Takes the whole stack, returned as a list linked through m_NextPage
+    LinearAllocationPage* PopAll( void )
+    {
+        uint64_t Top = m_Top.load(std::memory_order_relaxed);
+        while (GetPointer(Top) != nullptr && !m_Top.compare_exchange_weak(Top, Tag(nullptr, Top), std::memory_order_acquire))
+        {
+        }
+        return GetPointer(Top);
+    }
+
+    bool IsEmpty( void ) const { return GetPointer(m_Top.load(std::memory_order_relaxed)) == nullptr; }
+
+    void Clear( void ) { m_Top.store(0); }
+
+private:
+
+    static const uint32_t kPointerBits = 48;
+    static const uint64_t kPointerMask = (1ull << kPointerBits) - 1;
+
+    static LinearAllocationPage* GetPointer( uint64_t Top ) { return (LinearAllocationPage*)(Top & kPointerMask); }
+    static uint64_t Tag( LinearAllocationPage* Page, uint64_t Top ) { return (uint64_t)Page | ((Top & ~kPointerMask) + (1ull << kPointerBits)); }
+
+    std::atomic<uint64_t> m_Top{ 0 };
 };
 
 enum LinearAllocatorType
@@ -101,37 +168,138 @@ class LinearAllocatorPageManager
 public:
 
     LinearAllocatorPageManager();
+
+    // Pages come from a magazine of the calling thread, refilled a few at a time from a lock-free stack of
+    // available pages.  Only creating a page takes the mutex.
     LinearAllocationPage* RequestPage( void );
     LinearAllocationPage* CreateNewPage( size_t PageSize = 0 );
 
-    // Discarded pages will get recycled.  This is for fixed size pages.
+    // Discarded pages will get recycled once ProcessRetiredPages() sees their fence has passed.  This is for
+    // fixed size pages.  Lock-free.
     void DiscardPages( uint64_t FenceID, const std::vector<LinearAllocationPage*>& Pages );
 
-    // Freed pages will be destroyed once their fence has passed.  This is for single-use,
-    // "large" pages.
+    // Makes the discarded pages whose fence has passed available again.  Called once per frame rather than on
+    // every request; a thread that finds no page available also calls it unless another thread already is.
+    void ProcessRetiredPages( void );
+
+    // Large pages come in power of two size classes.  Freed ones are pooled by size class once their fence
+    // has passed and handed out again to the next request of the same class.  The pool is capped at
+    // "Graphics/Memory/Large Page Pool (MB)"; beyond it the pages retired the longest ago are destroyed.
+    LinearAllocationPage* RequestLargePage( size_t PageSize );
     void FreeLargePages( uint64_t FenceID, const std::vector<LinearAllocationPage*>& Pages );
 
-    void Destroy( void ) { m_PagePool.clear(); }
+    // Large pages as an allocator: the pooled ones are the free blocks, creations and destructions the
+    // allocations and frees.
+    AllocatorStats GetLargePageStats( void );
+
+    void Destroy( void );
 
 private:
 
+    // Moves the freed large pages whose fence has passed to the pool and trims it.  m_Mutex must be held.
+    void RecycleLargePages( void );
+
+    // m_Mutex must be held
+    void RecycleRetiredPages( void );
+
+    struct PageMagazine
+    {
+        static const uint32_t kCapacity = 4;
+
+        ~PageMagazine();
+
+        LinearAllocatorPageManager* Owner = nullptr;
+        uint32_t Generation = 0;    // Of the owner; its pages are gone once it was destroyed
+        uint32_t Count = 0;
+        LinearAllocationPage* Pages[kCapacity];
+    };
+
+    // One per page manager, indexed by allocation type
+    static thread_local PageMagazine t_Magazines[kNumAllocatorTypes];
+
+    struct PooledPage
+    {
+        LinearAllocationPage* Page;
+        uint64_t RetireIndex;   // Order in which pages entered the pool, to trim the least recently used
+    };
+
     static LinearAllocatorType sm_AutoType;
 
     LinearAllocatorType m_AllocationType;
     std::vector<std::unique_ptr<LinearAllocationPage> > m_PagePool;
-    std::queue<std::pair<uint64_t, LinearAllocationPage*> > m_RetiredPages;
+    LinearAllocationPageStack m_RetiredPages;
+    LinearAllocationPageStack m_AvailablePages;
+    // Retired pages whose fence has not passed yet, sorted by fence per queue type; guarded by m_Mutex
+    typedef std::pair<uint64_t, LinearAllocationPage*> PendingPage;
+    typedef std::deque<PendingPage> PendingPageQueue;
+    PendingPageQueue m_PendingPages[4];
+    std::atomic<uint32_t> m_Generation{ 0 };
     std::queue<std::pair<uint64_t, LinearAllocationPage*> > m_DeletionQueue;
-    std::queue<LinearAllocationPage*> m_AvailablePages;
+    std::mutex m_Mutex;
+
+    static const uint32_t kNumSizeClasses = 64;
+    std::deque<PooledPage> m_LargePagePool[kNumSizeClasses];   // Most recently retired at the back
+    uint64_t m_NextRetireIndex = 0;
+    size_t m_LargePageBytes = 0;        // All large pages alive
+    size_t m_PooledLargePageBytes = 0;
+    size_t m_FreedLargePageBytes = 0;   // Waiting on their fence
+    size_t m_PeakLargePageBytesInUse = 0;
+    size_t m_NumPooledLargePages = 0;
+    uint64_t m_NumLargePagesCreated = 0;
+    uint64_t m_NumLargePagesDestroyed = 0;
+};
+
+// The allocators reserve chunks at the head of the ring: a page worth at a time, or exactly what an allocation
+// larger than a page needs.  A chunk is retired with the fence of the command list that used it, and the tail
+// follows the retired chunks in the order they were reserved once their fences have completed.  When the ring is
+// full, ReserveChunk() waits for the fence of the oldest chunk; it fails only when that chunk has not been
+// retired yet, that is when it is still being recorded into, and the allocator then falls back to pages.
+class LinearAllocatorRingBuffer
+{
+public:
+
+    enum
+    {
+        kRingBufferSize = 0x2000000,    // 32MB
+        kChunkAlignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT
+    };
+
+    bool ReserveChunk( size_t SizeInBytes, size_t& Offset, uint64_t& ChunkID );
+    void RetireChunks( uint64_t FenceID, const std::vector<uint64_t>& ChunkIDs );
+
+    LinearAllocationPage& GetBuffer( void ) { return *m_Buffer; }
+
+    void Destroy( void );
+
+private:
+
+    void ReleaseCompletedChunks( void );
+
+    struct Chunk
+    {
+        size_t Size;        // Including the bytes skipped at the end of the ring to wrap around
+        uint64_t FenceID;   // 0 until retired
+    };
+
+    std::unique_ptr<LinearAllocationPage> m_Buffer;
+    std::deque<Chunk> m_Chunks;
+    uint64_t m_FirstChunkID = 0;
+    size_t m_Head = 0;
+    size_t m_UsedSize = 0;
     std::mutex m_Mutex;
 };
 
 class LinearAllocator
 {
+    friend class LinearAllocatorRingBuffer;
+
 public:
 
-    LinearAllocator(LinearAllocatorType Type) : m_AllocationType(Type), m_PageSize(0), m_CurOffset(~(size_t)0), m_CurPage(nullptr)
+    LinearAllocator(LinearAllocatorType Type, bool UseRingBuffer = false) : m_AllocationType(Type), m_PageSize(0), m_CurOffset(~(size_t)0), m_CurPage(nullptr),
+        m_UseRingBuffer(UseRingBuffer), m_RingOffset(0), m_RingChunkEnd(0)
     {
         ASSERT(Type > kInvalidAllocator && Type < kNumAllocatorTypes);
+        ASSERT(!UseRingBuffer || Type == kCpuWritable, "Only upload memory can come from the ring buffer");
         m_PageSize = (Type == kGpuExclusive ? kGpuAllocatorPageSize : kCpuAllocatorPageSize);
     }
 
@@ -139,8 +307,20 @@ public:
 
     void CleanupUsedPages( uint64_t FenceID );
 
+    // Recycles the pages discarded by both page managers; called once per frame
+    static void ProcessRetiredPages( void )
+    {
+        sm_PageManager[0].ProcessRetiredPages();
+        sm_PageManager[1].ProcessRetiredPages();
+    }
+
+    // Registers the large pages of both page managers with EngineProfiling
+    static void RegisterStats( void );
+    static void UnregisterStats( void );
+
     static void DestroyAll( void )
     {
+        sm_RingBuffer.Destroy();
         sm_PageManager[0].Destroy();
         sm_PageManager[1].Destroy();
     }
@@ -148,8 +328,10 @@ public:
 private:
 
     DynAlloc AllocateLargePage( size_t SizeInBytes );
+    bool AllocateFromRingBuffer( size_t SizeInBytes, size_t Alignment, size_t& Offset );
 
     static LinearAllocatorPageManager sm_PageManager[2];
+    static LinearAllocatorRingBuffer sm_RingBuffer;
 
     LinearAllocatorType m_AllocationType;
     size_t m_PageSize;
@@ -157,4 +339,9 @@ private:
     LinearAllocationPage* m_CurPage;
     std::vector<LinearAllocationPage*> m_RetiredPages;
     std::vector<LinearAllocationPage*> m_LargePageList;
+
+    bool m_UseRingBuffer;
+    size_t m_RingOffset;
+    size_t m_RingChunkEnd;
+    std::vector<uint64_t> m_RingChunks;
 };
@@ -369,6 +369,12 @@ void PixelBuffer::CreateTextureResource( ID3D12Device* Device, const std::wstrin
 
     (void)VidMemPtr;
     
+    if (m_PlacementHeap != nullptr)
+    {
+        ASSERT_SUCCEEDED( Device->CreatePlacedResource( m_PlacementHeap, m_PlacementOffset,
+            &ResourceDesc, D3D12_RESOURCE_STATE_COMMON, &ClearValue, MY_IID_PPV_ARGS(&m_pResource) ));
+    }
+    else
     {
         CD3DX12_HEAP_PROPERTIES HeapProps(D3D12_HEAP_TYPE_DEFAULT);
         ASSERT_SUCCEEDED( Device->CreateCommittedResource( &HeapProps, D3D12_HEAP_FLAG_NONE,
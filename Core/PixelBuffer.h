@@ -20,7 +20,8 @@ class EsramAllocator;
 class PixelBuffer : public GpuResource
 {
 public:
-    PixelBuffer() : m_Dimension(D3D12_RESOURCE_DIMENSION_TEXTURE2D), m_Width(0), m_Height(0), m_ArraySize(0), m_Format(DXGI_FORMAT_UNKNOWN), m_BankRotation(0) {}
+    PixelBuffer() : m_Dimension(D3D12_RESOURCE_DIMENSION_TEXTURE2D), m_Width(0), m_Height(0), m_ArraySize(0), m_Format(DXGI_FORMAT_UNKNOWN), m_BankRotation(0),
+        m_PlacementHeap(nullptr), m_PlacementOffset(0) {}
 
     D3D12_RESOURCE_DIMENSION GetDimension(void) const { return m_Dimension; }
     uint32_t GetWidth(void) const { return m_Width; }
@@ -28,12 +29,22 @@ public:
     uint32_t GetDepth(void) const { return m_ArraySize; }
     const DXGI_FORMAT& GetFormat(void) const { return m_Format; }
 
+    static size_t BytesPerPixel( DXGI_FORMAT Format );
+
     // Has no effect on Desktop
     void SetBankRotation( uint32_t RotationAmount )
     {
         (RotationAmount);
     }
 
+    // Create the texture at an offset of a heap rather than in memory of its own.  Takes effect on the next
+    // Create(); the heap must outlive the texture.  Pass nullptr to go back to committed textures.
+    void SetPlacement( ID3D12Heap* Heap, uint64_t HeapOffset )
+    {
+        m_PlacementHeap = Heap;
+        m_PlacementOffset = HeapOffset;
+    }
+
     // Write the raw pixel buffer contents to a file
     // Note that data is preceded by a 16-byte header:  { DXGI_FORMAT, Pitch (in pixels), Width (in pixels), Height }
     void ExportToFile( const std::wstring& FilePath );
@@ -58,7 +69,6 @@ protected:
     static DXGI_FORMAT GetDSVFormat( DXGI_FORMAT Format );
     static DXGI_FORMAT GetDepthFormat( DXGI_FORMAT Format );
     static DXGI_FORMAT GetStencilFormat( DXGI_FORMAT Format );
-    static size_t BytesPerPixel( DXGI_FORMAT Format );
 
     D3D12_RESOURCE_DIMENSION m_Dimension;
     uint32_t m_Width;
@@ -66,4 +76,6 @@ protected:
     uint32_t m_ArraySize;
     DXGI_FORMAT m_Format;
     uint32_t m_BankRotation;
+    ID3D12Heap* m_PlacementHeap;
+    uint64_t m_PlacementOffset;
 };
@@ -0,0 +1,308 @@
+// Two-level segregated fit (TLSF) index of free blocks, the O(1) backend of VariableSizeAllocationsManager.
+// See M. Masmano et al., "TLSF: a New Dynamic Memory Allocator for Real-Time Systems"
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cassert>
+#include <intrin.h>
+
+namespace LearnRenderer
+{
+	// Free blocks are binned by size: the first level splits sizes into powers of two, the second level splits each
+	// power of two into SLCount equal ranges. A bitmap per level says which bins hold a block, so finding a bin with a
+	// large enough block takes two bit scans. Each bin is a doubly linked list of blocks.
+	//
+	//   m_FLBitmap     0 0 1 0 1 ...          first level: [16, 32), [32, 64), [64, 128), ...
+	//                      |   |
+	//   m_SLBitmaps[2] 0 1 0 0 ...            second level of [64, 128): [64, 68), [68, 72), [72, 76), ...
+	//                    |
+	//   m_Heads[2][1] -> {Offset = 192, Size = 70} <-> {Offset = 520, Size = 69}
+	//
+	// Allocations live in offset space only, so there are no block headers to find the neighbours of a freed range
+	// from. Instead two open-addressing hash tables map the start and the end offset of every free block to it, and
+	// freeing looks up the block ending where the range starts and the one starting where it ends.
+	//
+	// Blocks and tables are kept in vectors that only grow, so once they have reached the largest number of free
+	// blocks no operation allocates memory.
+	class TLSFFreeBlockIndex
+	{
+	public:
+		using OffsetType = size_t;
+		using BlockIndex = uint32_t;
+
+		static constexpr BlockIndex InvalidBlock = ~BlockIndex{ 0 };
+
+		struct Block
+		{
+			OffsetType Offset;
+			OffsetType Size;
+			BlockIndex PrevFree;
+			BlockIndex NextFree;
+		};
+
+		TLSFFreeBlockIndex()
+		{
+			for (auto& Heads : m_Heads)
+				for (auto& Head : Heads)
+					Head = InvalidBlock;
+			Rehash(16);
+		}
+
+		TLSFFreeBlockIndex(TLSFFreeBlockIndex&&) = default;
+		TLSFFreeBlockIndex& operator = (TLSFFreeBlockIndex&&) = default;
+		TLSFFreeBlockIndex(const TLSFFreeBlockIndex&) = delete;
+		TLSFFreeBlockIndex& operator = (const TLSFFreeBlockIndex&) = delete;
+
+		const Block& operator[](BlockIndex Index) const
+		{
+			return m_Blocks[Index];
+		}
+
+		size_t GetNumBlocks() const { return m_NumBlocks; }
+
+		// A block of at least MinSize, or InvalidBlock. The search rounds MinSize up to the next bin so that any
+		// block of the bin it lands in is large enough; the block at the head of the bin MinSize falls into is
+		// also tried, as it may still fit.
+		BlockIndex Find(OffsetType MinSize) const
+		{
+			uint32_t FL, SL;
+			Mapping(MinSize, FL, SL);
+			if (FL >= FLCount)
+				return InvalidBlock;
+
+			uint32_t RoundedFL = FL, RoundedSL = SL;
+			if (MinSize >= SLCount)
+			{
+				Mapping(MinSize + (OffsetType{ 1 } << (BitScanReverse(MinSize) - SLBits)) - 1, RoundedFL, RoundedSL);
+			}
+
+			if (RoundedFL < FLCount)
+			{
+				uint32_t SLMap = m_SLBitmaps[RoundedFL] & (~0u << RoundedSL);
+				if (SLMap == 0)
+				{
+					const uint64_t FLMap = RoundedFL + 1 < FLCount ? m_FLBitmap & (~uint64_t{ 0 } << (RoundedFL + 1)) : 0;
+					if (FLMap != 0)
+					{
+						RoundedFL = BitScanForward(FLMap);
+						SLMap = m_SLBitmaps[RoundedFL];
+					}
+				}
+				if (SLMap != 0)
+					return m_Heads[RoundedFL][BitScanForward(SLMap)];
+			}
+
+			const BlockIndex Head = m_Heads[FL][SL];
+			return Head != InvalidBlock && m_Blocks[Head].Size >= MinSize ? Head : InvalidBlock;
+		}
+
+		// The lowest block of at least MinSize that starts below Limit, or InvalidBlock. Walks all blocks.
+		BlockIndex FindLowest(OffsetType MinSize, OffsetType Limit) const
+		{
+			BlockIndex Lowest = InvalidBlock;
+			for (BlockIndex Index = 0; Index < m_Blocks.size(); ++Index)
+			{
+				const auto& Candidate = m_Blocks[Index];
+				if (Candidate.Size >= MinSize && Candidate.Offset < Limit)
+				{
+					Limit = Candidate.Offset;
+					Lowest = Index;
+				}
+			}
+			return Lowest;
+		}
+
+		// The free block starting or ending at Offset, or InvalidBlock
+		BlockIndex FindByStart(OffsetType Offset) const { return Lookup(m_ByStart, Offset, false); }
+		BlockIndex FindByEnd(OffsetType Offset) const { return Lookup(m_ByEnd, Offset, true); }
+
+		BlockIndex Insert(OffsetType Offset, OffsetType Size)
+		{
+			assert(Size > 0);
+
+			// Keep the tables at most half full
+			if ((m_NumBlocks + 1) * 2 > m_ByStart.size())
+				Rehash(m_ByStart.size() * 2);
+
+			BlockIndex Index;
+			if (!m_UnusedBlocks.empty())
+			{
+				Index = m_UnusedBlocks.back();
+				m_UnusedBlocks.pop_back();
+			}
+			else
+			{
+				Index = static_cast<BlockIndex>(m_Blocks.size());
+				m_Blocks.emplace_back();
+			}
+
+			uint32_t FL, SL;
+			Mapping(Size, FL, SL);
+			auto& NewBlock = m_Blocks[Index];
+			NewBlock.Offset = Offset;
+			NewBlock.Size = Size;
+			NewBlock.PrevFree = InvalidBlock;
+			NewBlock.NextFree = m_Heads[FL][SL];
+			if (NewBlock.NextFree != InvalidBlock)
+				m_Blocks[NewBlock.NextFree].PrevFree = Index;
+			m_Heads[FL][SL] = Index;
+			m_FLBitmap |= uint64_t{ 1 } << FL;
+			m_SLBitmaps[FL] |= 1u << SL;
+
+			++m_NumBlocks;
+			HashInsert(m_ByStart, Index, false);
+			HashInsert(m_ByEnd, Index, true);
+			return Index;
+		}
+
+		void Remove(BlockIndex Index)
+		{
+			auto& OldBlock = m_Blocks[Index];
+			uint32_t FL, SL;
+			Mapping(OldBlock.Size, FL, SL);
+			if (OldBlock.PrevFree != InvalidBlock)
+				m_Blocks[OldBlock.PrevFree].NextFree = OldBlock.NextFree;
+			else
+				m_Heads[FL][SL] = OldBlock.NextFree;
+			if (OldBlock.NextFree != InvalidBlock)
+				m_Blocks[OldBlock.NextFree].PrevFree = OldBlock.PrevFree;
+			if (m_Heads[FL][SL] == InvalidBlock)
+			{
+				m_SLBitmaps[FL] &= ~(1u << SL);
+				if (m_SLBitmaps[FL] == 0)
+					m_FLBitmap &= ~(uint64_t{ 1 } << FL);
+			}
+
+			HashErase(m_ByStart, OldBlock.Offset, false);
+			HashErase(m_ByEnd, OldBlock.Offset + OldBlock.Size, true);
+			OldBlock.Size = 0;
+			--m_NumBlocks;
+			m_UnusedBlocks.push_back(Index);
+		}
+
+		// Not bounded: walks the highest non-empty bin. Meant for statistics.
+		OffsetType GetLargestBlockSize() const
+		{
+			if (m_FLBitmap == 0)
+				return 0;
+			const uint32_t FL = BitScanReverse(m_FLBitmap);
+			OffsetType Largest = 0;
+			for (auto Index = m_Heads[FL][BitScanReverse(m_SLBitmaps[FL])]; Index != InvalidBlock; Index = m_Blocks[Index].NextFree)
+				Largest = std::max(Largest, m_Blocks[Index].Size);
+			return Largest;
+		}
+
+	private:
+		static constexpr uint32_t SLBits = 4;
+		static constexpr uint32_t SLCount = 1u << SLBits;
+		// Sizes below SLCount share the first bin, one second level bin per size
+		static constexpr uint32_t FLCount = 64 - SLBits + 1;
+
+		static uint32_t BitScanReverse(uint64_t Value)
+		{
+			unsigned long Bit = 0;
+			_BitScanReverse64(&Bit, Value);
+			return Bit;
+		}
+
+		static uint32_t BitScanForward(uint64_t Value)
+		{
+			unsigned long Bit = 0;
+			_BitScanForward64(&Bit, Value);
+			return Bit;
+		}
+
+		static void Mapping(OffsetType Size, uint32_t& FL, uint32_t& SL)
+		{
+			if (Size < SLCount)
+			{
+				FL = 0;
+				SL = static_cast<uint32_t>(Size);
+			}
+			else
+			{
+				const uint32_t MSB = BitScanReverse(Size);
+				FL = MSB - SLBits + 1;
+				SL = static_cast<uint32_t>(Size >> (MSB - SLBits)) - SLCount;
+			}
+		}
+
+		OffsetType Key(BlockIndex Index, bool ByEnd) const
+		{
+			return ByEnd ? m_Blocks[Index].Offset + m_Blocks[Index].Size : m_Blocks[Index].Offset;
+		}
+
+		size_t Slot(OffsetType Offset) const
+		{
+			return static_cast<size_t>((uint64_t{ Offset } * 0x9E3779B97F4A7C15ull) >> m_HashShift);
+		}
+
+		BlockIndex Lookup(const std::vector<BlockIndex>& Table, OffsetType Offset, bool ByEnd) const
+		{
+			const size_t Mask = Table.size() - 1;
+			for (size_t i = Slot(Offset); Table[i] != InvalidBlock; i = (i + 1) & Mask)
+			{
+				if (Key(Table[i], ByEnd) == Offset)
+					return Table[i];
+			}
+			return InvalidBlock;
+		}
+
+		void HashInsert(std::vector<BlockIndex>& Table, BlockIndex Index, bool ByEnd)
+		{
+			const size_t Mask = Table.size() - 1;
+			size_t i = Slot(Key(Index, ByEnd));
+			while (Table[i] != InvalidBlock)
+				i = (i + 1) & Mask;
+			Table[i] = Index;
+		}
+
+		// Linear probing: entries after the erased one that probed past it are shifted back into the hole
+		void HashErase(std::vector<BlockIndex>& Table, OffsetType Offset, bool ByEnd)
+		{
+			const size_t Mask = Table.size() - 1;
+			size_t Hole = Slot(Offset);
+			while (Key(Table[Hole], ByEnd) != Offset)
+				Hole = (Hole + 1) & Mask;
+
+			for (size_t i = (Hole + 1) & Mask; Table[i] != InvalidBlock; i = (i + 1) & Mask)
+			{
+				const size_t Home = Slot(Key(Table[i], ByEnd));
+				// Move the entry unless its home slot lies cyclically in (Hole, i]
+				if (((i - Home) & Mask) >= ((i - Hole) & Mask))
+				{
+					Table[Hole] = Table[i];
+					Hole = i;
+				}
+			}
+			Table[Hole] = InvalidBlock;
+		}
+
+		void Rehash(size_t NewSize)
+		{
+			m_HashShift = 64 - BitScanReverse(NewSize);
+			m_ByStart.assign(NewSize, InvalidBlock);
+			m_ByEnd.assign(NewSize, InvalidBlock);
+			for (BlockIndex Index = 0; Index < m_Blocks.size(); ++Index)
+			{
+				if (m_Blocks[Index].Size == 0)
+					continue;
+				HashInsert(m_ByStart, Index, false);
+				HashInsert(m_ByEnd, Index, true);
+			}
+		}
+
+		std::vector<Block>      m_Blocks;
+		std::vector<BlockIndex> m_UnusedBlocks;
+		std::vector<BlockIndex> m_ByStart;
+		std::vector<BlockIndex> m_ByEnd;
+		uint32_t                m_HashShift = 0;
+		size_t                  m_NumBlocks = 0;
+
+		uint64_t   m_FLBitmap = 0;
+		uint32_t   m_SLBitmaps[FLCount] = {};
+		BlockIndex m_Heads[FLCount][SLCount];
+	};
+}
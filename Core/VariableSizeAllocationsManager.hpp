@@ -33,6 +33,8 @@
 #include <algorithm>
 #include <cassert>
 #include "Math/Common.h"
+#include "AllocatorStats.h"
+#include "TLSFFreeBlockIndex.hpp"
 
 namespace LearnRenderer
 {
@@ -57,6 +59,11 @@ namespace LearnRenderer
 	//
 	//                32 ------------------> 104 ---------->  {size = 32, &m_FreeBlocksBySize[3]}
 	//
+	// Both maps cost O(log n) and a node allocation per operation. Managers created with BackendType::TLSF keep the
+	// free blocks in a TLSFFreeBlockIndex instead, which takes constant time and does not allocate once warmed up, at
+	// the price of a good fit rather than the best one: a block is only picked over one from a larger size class
+	// if it sits at the head of its own. Alignment handling is the same for both.
+	//
 	class VariableSizeAllocationsManager
 	{
 	public:
@@ -83,8 +90,14 @@ namespace LearnRenderer
 		};
 
 	public:
-		VariableSizeAllocationsManager(OffsetType MaxSize) :
-			m_MaxSize(MaxSize), m_FreeSize(MaxSize)
+		enum class BackendType : uint8_t
+		{
+			OrderedMaps,
+			TLSF
+		};
+
+		VariableSizeAllocationsManager(OffsetType MaxSize, BackendType Backend = BackendType::OrderedMaps) :
+			m_Backend(Backend), m_MaxSize(MaxSize), m_FreeSize(MaxSize)
 		{
 			// Insert single maximum-size block
 			AddNewBlock(0, m_MaxSize);
@@ -96,13 +109,23 @@ namespace LearnRenderer
 		VariableSizeAllocationsManager(VariableSizeAllocationsManager&& rhs) noexcept :
 			m_FreeBlocksByOffset{ std::move(rhs.m_FreeBlocksByOffset) },
 			m_FreeBlocksBySize{ std::move(rhs.m_FreeBlocksBySize) },
+			m_TLSFBlocks{ std::move(rhs.m_TLSFBlocks) },
+			m_Backend{ rhs.m_Backend },
 			m_MaxSize{ rhs.m_MaxSize },
 			m_FreeSize{ rhs.m_FreeSize },
-			m_CurrAlignment{ rhs.m_CurrAlignment }
+			m_CurrAlignment{ rhs.m_CurrAlignment },
+			m_PeakUsedSize{ rhs.m_PeakUsedSize },
+			m_PaddingSize{ rhs.m_PaddingSize },
+			m_AllocationCount{ rhs.m_AllocationCount },
+			m_FreeCount{ rhs.m_FreeCount }
 		{
 			rhs.m_MaxSize = 0;
 			rhs.m_FreeSize = 0;
 			rhs.m_CurrAlignment = 0;
+			rhs.m_PeakUsedSize = 0;
+			rhs.m_PaddingSize = 0;
+			rhs.m_AllocationCount = 0;
+			rhs.m_FreeCount = 0;
 		}
 
 		VariableSizeAllocationsManager& operator = (VariableSizeAllocationsManager&& rhs) = default;
@@ -139,45 +162,85 @@ namespace LearnRenderer
 
 			OffsetType UnalignedOffset = InvalidOffset;
 			OffsetType Size = 0;
+			// Part of Size beyond the size requested, lost to rounding up and aligning
+			OffsetType Padding = 0;
 		};
 
-		Allocation Allocate(OffsetType Size, OffsetType Alignment)
+		// With a Limit, takes the lowest free block that starts below it instead of the best fitting one, so that
+		// the allocation lies entirely below Limit. That walks the free blocks; it is meant for compacting the
+		// space, not for every allocation.
+		Allocation Allocate(OffsetType Size, OffsetType Alignment, OffsetType Limit = Allocation::InvalidOffset)
 		{
 			assert(Size > 0);
 			assert(Math::IsPowerOfTwo(Alignment));
+			const auto RequestedSize = Size;
 			Size = Math::AlignUp(Size, Alignment);
 			if (m_FreeSize < Size)
 				return Allocation::InvalidAllocation();
 
 			auto AlignmentReserve = (Alignment > m_CurrAlignment) ? Alignment - m_CurrAlignment : 0;
-			// Get the first block that is large enough to encompass Size + AlignmentReserve bytes
-			// lower_bound() returns an iterator pointing to the first element that
-			// is not less (i.e. >= ) than key
-			auto SmallestBlockItIt = m_FreeBlocksBySize.lower_bound(Size + AlignmentReserve);
-			if (SmallestBlockItIt == m_FreeBlocksBySize.end())
-				return Allocation::InvalidAllocation();
-
-			auto SmallestBlockIt = SmallestBlockItIt->second;
-			assert(Size + AlignmentReserve <= SmallestBlockIt->second.Size);
-			assert(SmallestBlockIt->second.Size == SmallestBlockItIt->first);
+			OffsetType Offset, BlockSize;
+			if (m_Backend == BackendType::TLSF)
+			{
+				auto Block = Limit == Allocation::InvalidOffset ?
+					m_TLSFBlocks.Find(Size + AlignmentReserve) :
+					m_TLSFBlocks.FindLowest(Size + AlignmentReserve, Limit);
+				if (Block == TLSFFreeBlockIndex::InvalidBlock)
+					return Allocation::InvalidAllocation();
+
+				Offset = m_TLSFBlocks[Block].Offset;
+				BlockSize = m_TLSFBlocks[Block].Size;
+				assert(Size + AlignmentReserve <= BlockSize);
+				m_TLSFBlocks.Remove(Block);
+			}
+			else if (Limit == Allocation::InvalidOffset)
+			{
+				// Get the first block that is large enough to encompass Size + AlignmentReserve bytes
+				// lower_bound() returns an iterator pointing to the first element that
+				// is not less (i.e. >= ) than key
+				auto SmallestBlockItIt = m_FreeBlocksBySize.lower_bound(Size + AlignmentReserve);
+				if (SmallestBlockItIt == m_FreeBlocksBySize.end())
+					return Allocation::InvalidAllocation();
+
+				auto SmallestBlockIt = SmallestBlockItIt->second;
+				assert(Size + AlignmentReserve <= SmallestBlockIt->second.Size);
+				assert(SmallestBlockIt->second.Size == SmallestBlockItIt->first);
+
+				Offset = SmallestBlockIt->first;
+				BlockSize = SmallestBlockIt->second.Size;
+				assert(SmallestBlockItIt == SmallestBlockIt->second.OrderBySizeIt);
+				m_FreeBlocksBySize.erase(SmallestBlockItIt);
+				m_FreeBlocksByOffset.erase(SmallestBlockIt);
+			}
+			else
+			{
+				// First fit in offset order
+				auto LowestBlockIt = m_FreeBlocksByOffset.begin();
+				while (LowestBlockIt != m_FreeBlocksByOffset.end() && LowestBlockIt->first < Limit &&
+					LowestBlockIt->second.Size < Size + AlignmentReserve)
+					++LowestBlockIt;
+				if (LowestBlockIt == m_FreeBlocksByOffset.end() || LowestBlockIt->first >= Limit)
+					return Allocation::InvalidAllocation();
+
+				Offset = LowestBlockIt->first;
+				BlockSize = LowestBlockIt->second.Size;
+				m_FreeBlocksBySize.erase(LowestBlockIt->second.OrderBySizeIt);
+				m_FreeBlocksByOffset.erase(LowestBlockIt);
+			}
 
-			//     SmallestBlockIt.Offset
+			//     Offset
 			//        |                                  |
-			//        |<------SmallestBlockIt.Size------>|
+			//        |<-----------BlockSize------------>|
 			//        |<------Size------>|<---NewSize--->|
 			//        |                  |
 			//      Offset              NewOffset
 			//
-			auto Offset = SmallestBlockIt->first;
 			assert(Offset % m_CurrAlignment == 0);
 			auto AlignedOffset = Math::AlignUp(Offset, Alignment);
 			auto AdjustedSize = Size + (AlignedOffset - Offset);
 			assert(AdjustedSize <= Size + AlignmentReserve);
 			auto NewOffset = Offset + AdjustedSize;
-			auto NewSize = SmallestBlockIt->second.Size - AdjustedSize;
-			assert(SmallestBlockItIt == SmallestBlockIt->second.OrderBySizeIt);
-			m_FreeBlocksBySize.erase(SmallestBlockItIt);
-			m_FreeBlocksByOffset.erase(SmallestBlockIt);
+			auto NewSize = BlockSize - AdjustedSize;
 			if (NewSize > 0)
 			{
 				AddNewBlock(NewOffset, NewSize);
@@ -198,20 +261,34 @@ namespace LearnRenderer
 				}
 			}
 
-			return Allocation{ Offset, AdjustedSize };
+			Allocation NewAllocation{ Offset, AdjustedSize };
+			NewAllocation.Padding = AdjustedSize - RequestedSize;
+			m_PaddingSize += NewAllocation.Padding;
+			m_PeakUsedSize = std::max(m_PeakUsedSize, GetUsedSize());
+			++m_AllocationCount;
+
+			return NewAllocation;
 		}
 
 		void Free(Allocation&& allocation)
 		{
 			assert(allocation.IsValid());
-			Free(allocation.UnalignedOffset, allocation.Size);
+			Free(allocation.UnalignedOffset, allocation.Size, allocation.Padding);
 			allocation = Allocation{};
 		}
 
-		void Free(OffsetType Offset, OffsetType Size)
+		// Padding is that of the allocation, which only matters to the statistics
+		void Free(OffsetType Offset, OffsetType Size, OffsetType Padding = 0)
 		{
 			assert(Offset != Allocation::InvalidOffset && Offset + Size <= m_MaxSize);
 
+			if (m_Backend == BackendType::TLSF)
+			{
+				FreeTLSF(Offset, Size);
+				OnFree(Size, Padding);
+				return;
+			}
+
 			// Find the first element whose offset is greater than the specified offset.
 			// upper_bound() returns an iterator pointing to the first element in the
 			// container whose key is considered to go after k.
@@ -284,15 +361,7 @@ namespace LearnRenderer
 			}
 
 			AddNewBlock(NewOffset, NewSize);
-
-			m_FreeSize += Size;
-			if (IsEmpty())
-			{
-				// Reset current alignment
-				assert(GetNumFreeBlocks() == 1);
-				ResetCurrAlignment();
-			}
-
+			OnFree(Size, Padding);
 		}
 
 		bool IsFull() const { return m_FreeSize == 0; };
@@ -301,9 +370,32 @@ namespace LearnRenderer
 		OffsetType GetFreeSize()const { return m_FreeSize; }
 		OffsetType GetUsedSize()const { return m_MaxSize - m_FreeSize; }
 
+		BackendType GetBackend() const { return m_Backend; }
+
 		size_t GetNumFreeBlocks() const
 		{
-			return m_FreeBlocksByOffset.size();
+			return m_Backend == BackendType::TLSF ? m_TLSFBlocks.GetNumBlocks() : m_FreeBlocksByOffset.size();
+		}
+
+		OffsetType GetLargestFreeBlockSize() const
+		{
+			if (m_Backend == BackendType::TLSF)
+				return m_TLSFBlocks.GetLargestBlockSize();
+			return m_FreeBlocksBySize.empty() ? 0 : m_FreeBlocksBySize.rbegin()->first;
+		}
+
+		AllocatorStats GetStats() const
+		{
+			AllocatorStats Stats;
+			Stats.Capacity = m_MaxSize;
+			Stats.UsedSize = GetUsedSize();
+			Stats.PeakUsedSize = m_PeakUsedSize;
+			Stats.PaddingSize = m_PaddingSize;
+			Stats.FreeBlockCount = GetNumFreeBlocks();
+			Stats.LargestFreeBlock = GetLargestFreeBlockSize();
+			Stats.AllocationCount = m_AllocationCount;
+			Stats.FreeCount = m_FreeCount;
+			return Stats;
 		}
 
 		void Extend(size_t ExtraSize)
@@ -311,7 +403,18 @@ namespace LearnRenderer
 			size_t NewBlockOffset = m_MaxSize;
 			size_t NewBlockSize = ExtraSize;
 
-			if (!m_FreeBlocksByOffset.empty())
+			if (m_Backend == BackendType::TLSF)
+			{
+				auto LastBlock = m_TLSFBlocks.FindByEnd(m_MaxSize);
+				if (LastBlock != TLSFFreeBlockIndex::InvalidBlock)
+				{
+					// Extend the last block
+					NewBlockOffset = m_TLSFBlocks[LastBlock].Offset;
+					NewBlockSize += m_TLSFBlocks[LastBlock].Size;
+					m_TLSFBlocks.Remove(LastBlock);
+				}
+			}
+			else if (!m_FreeBlocksByOffset.empty())
 			{
 				auto LastBlockIt = m_FreeBlocksByOffset.end();
 				--LastBlockIt;
@@ -341,9 +444,61 @@ namespace LearnRenderer
 #endif
 		}
 
+	protected:
+		// Frees a range made of NumAllocations adjacent allocations at once; Padding is theirs summed up
+		void FreeRange(OffsetType Offset, OffsetType Size, OffsetType Padding, size_t NumAllocations)
+		{
+			assert(NumAllocations > 0);
+			Free(Offset, Size, Padding);
+			m_FreeCount += NumAllocations - 1;
+		}
+
 	private:
+		// Same cases as the ordered maps: merge with the free blocks that end where the range starts and that start
+		// where it ends, if any. Overlaps with free blocks are not detected.
+		void FreeTLSF(OffsetType Offset, OffsetType Size)
+		{
+			OffsetType NewOffset = Offset, NewSize = Size;
+
+			auto PrevBlock = m_TLSFBlocks.FindByEnd(Offset);
+			if (PrevBlock != TLSFFreeBlockIndex::InvalidBlock)
+			{
+				NewOffset = m_TLSFBlocks[PrevBlock].Offset;
+				NewSize += m_TLSFBlocks[PrevBlock].Size;
+				m_TLSFBlocks.Remove(PrevBlock);
+			}
+
+			auto NextBlock = m_TLSFBlocks.FindByStart(Offset + Size);
+			if (NextBlock != TLSFFreeBlockIndex::InvalidBlock)
+			{
+				NewSize += m_TLSFBlocks[NextBlock].Size;
+				m_TLSFBlocks.Remove(NextBlock);
+			}
+
+			m_TLSFBlocks.Insert(NewOffset, NewSize);
+		}
+
+		void OnFree(OffsetType Size, OffsetType Padding)
+		{
+			m_FreeSize += Size;
+			m_PaddingSize -= std::min(Padding, m_PaddingSize);
+			++m_FreeCount;
+			if (IsEmpty())
+			{
+				// Reset current alignment
+				assert(GetNumFreeBlocks() == 1);
+				ResetCurrAlignment();
+			}
+		}
+
 		void AddNewBlock(OffsetType Offset, OffsetType Size)
 		{
+			if (m_Backend == BackendType::TLSF)
+			{
+				m_TLSFBlocks.Insert(Offset, Size);
+				return;
+			}
+
 			auto NewBlockIt = m_FreeBlocksByOffset.emplace(Offset, Size);
 			auto OrderIt = m_FreeBlocksBySize.emplace(Size, NewBlockIt.first);
 			NewBlockIt.first->second.OrderBySizeIt = OrderIt;
@@ -358,10 +513,19 @@ namespace LearnRenderer
 
 		TFreeBlocksByOffsetMap m_FreeBlocksByOffset;
 		TFreeBlocksBySizeMap   m_FreeBlocksBySize;
+		TLSFFreeBlockIndex     m_TLSFBlocks;
+
+		BackendType m_Backend = BackendType::OrderedMaps;
 
 		OffsetType m_MaxSize = 0;
 		OffsetType m_FreeSize = 0;
 		OffsetType m_CurrAlignment = 0;
+
+		// Statistics
+		OffsetType m_PeakUsedSize = 0;
+		OffsetType m_PaddingSize = 0;
+		uint64_t m_AllocationCount = 0;
+		uint64_t m_FreeCount = 0;
 		// When adding new members, do not forget to update move ctor
 	};
 
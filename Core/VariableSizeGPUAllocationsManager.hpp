@@ -31,30 +31,58 @@
 
 #pragma once
 
-#include <deque>
+#include <vector>
+#include <algorithm>
 #include "VariableSizeAllocationsManager.hpp"
 
 namespace LearnRenderer
 {
 	// Class extends basic variable-size memory block allocator by deferring deallocation
-	// of freed blocks until the corresponding frame is completed
+	// of freed blocks until the corresponding frame is completed.
+	// A freed block may be in use by several queues, so it waits on a fence value per queue in its queue mask.
+	// Queues are indexed like D3D12_COMMAND_LIST_TYPE, which CommandListManager keeps in the top byte of the
+	// fence values it hands out, so a single fence value tells its queue. Queues retire their work out of
+	// order relative to each other, so stale blocks are not kept ordered by fence.
 	class VariableSizeGPUAllocationsManager : public VariableSizeAllocationsManager
 	{
+	public:
+		static constexpr uint32_t MaxQueues = 4;
+
+		static uint32_t GetQueueIndex(uint64_t FenceValue)
+		{
+			const auto QueueIndex = static_cast<uint32_t>(FenceValue >> 56);
+			assert(QueueIndex < MaxQueues);
+			return QueueIndex;
+		}
+
 	private:
 		struct StaleAllocationAttribs
 		{
 			OffsetType Offset;
 			OffsetType Size;
-			uint64_t     FenceValue;
-			StaleAllocationAttribs(OffsetType _Offset, OffsetType _Size, uint64_t _FenceValue) :
-				Offset{ _Offset }, Size{ _Size }, FenceValue{ _FenceValue }
-			{}
+			OffsetType Padding;
+			uint32_t   QueueMask;
+			uint64_t   FenceValues[MaxQueues];
+			StaleAllocationAttribs(OffsetType _Offset, OffsetType _Size, uint32_t _QueueMask, const uint64_t(&_FenceValues)[MaxQueues], OffsetType _Padding = 0) :
+				Offset{ _Offset }, Size{ _Size }, Padding{ _Padding }, QueueMask{ _QueueMask }
+			{
+				std::copy(std::begin(_FenceValues), std::end(_FenceValues), FenceValues);
+			}
+
+			bool IsComplete(const uint64_t(&CompletedFenceValues)[MaxQueues]) const
+			{
+				for (uint32_t Queue = 0; Queue < MaxQueues; ++Queue)
+				{
+					if ((QueueMask & (1u << Queue)) != 0 && FenceValues[Queue] > CompletedFenceValues[Queue])
+						return false;
+				}
+				return true;
+			}
 		};
 
 	public:
-		VariableSizeGPUAllocationsManager(OffsetType MaxSize) :
-			VariableSizeAllocationsManager{ MaxSize },
-			m_StaleAllocations{ 0, StaleAllocationAttribs(0, 0, 0) }
+		VariableSizeGPUAllocationsManager(OffsetType MaxSize, BackendType Backend = BackendType::OrderedMaps) :
+			VariableSizeAllocationsManager{ MaxSize, Backend }
 		{}
 
 		~VariableSizeGPUAllocationsManager()
@@ -67,6 +95,7 @@ namespace LearnRenderer
 		VariableSizeGPUAllocationsManager(VariableSizeGPUAllocationsManager&& rhs) noexcept :
 			VariableSizeAllocationsManager(std::move(rhs)),
 			m_StaleAllocations(std::move(rhs.m_StaleAllocations)),
+			m_ReleasedAllocations(std::move(rhs.m_ReleasedAllocations)),
 			m_StaleAllocationsSize(rhs.m_StaleAllocationsSize)
 		{
 			rhs.m_StaleAllocationsSize = 0;
@@ -78,38 +107,148 @@ namespace LearnRenderer
 
 		void Free(VariableSizeAllocationsManager::Allocation&& allocation, uint64_t FenceValue)
 		{
-			Free(allocation.UnalignedOffset, allocation.Size, FenceValue);
+			Free(allocation.UnalignedOffset, allocation.Size, FenceValue, allocation.Padding);
 			allocation = VariableSizeAllocationsManager::Allocation{};
 		}
 
-		void Free(OffsetType Offset, OffsetType Size, uint64_t FenceValue)
+		void Free(OffsetType Offset, OffsetType Size, uint64_t FenceValue, OffsetType Padding = 0)
 		{
+			uint64_t FenceValues[MaxQueues] = {};
+			const auto QueueIndex = GetQueueIndex(FenceValue);
+			FenceValues[QueueIndex] = FenceValue;
+			Free(Offset, Size, 1u << QueueIndex, FenceValues, Padding);
+		}
+
+		void Free(VariableSizeAllocationsManager::Allocation&& allocation, uint32_t QueueMask, const uint64_t(&FenceValues)[MaxQueues])
+		{
+			Free(allocation.UnalignedOffset, allocation.Size, QueueMask, FenceValues, allocation.Padding);
+			allocation = VariableSizeAllocationsManager::Allocation{};
+		}
+
+		// The block is released once every queue in QueueMask has completed its value in FenceValues
+		void Free(OffsetType Offset, OffsetType Size, uint32_t QueueMask, const uint64_t(&FenceValues)[MaxQueues], OffsetType Padding = 0)
+		{
+			assert(QueueMask != 0 && QueueMask < (1u << MaxQueues));
 			// Do not release the block immediately, but add
-			// it to the queue instead
-			m_StaleAllocations.emplace_back(Offset, Size, FenceValue);
+			// it to the list instead
+			m_StaleAllocations.emplace_back(Offset, Size, QueueMask, FenceValues, Padding);
 			m_StaleAllocationsSize += Size;
 		}
 
-		// Releases stale allocation from completed command lists
-		// The method takes the last known completed fence value N
-		// and releases all allocations whose associated fence value
-		// is at most N (n <= N)
+		// Releases stale allocations from completed command lists of the queue LastCompletedFenceValue belongs to.
+		// Allocations that also wait on other queues stay.
 		void ReleaseStaleAllocations(uint64_t LastCompletedFenceValue)
 		{
-			// Free all allocations from the beginning of the queue that belong to completed command lists
-			while (!m_StaleAllocations.empty() && m_StaleAllocations.front().FenceValue <= LastCompletedFenceValue)
+			uint64_t CompletedFenceValues[MaxQueues] = {};
+			CompletedFenceValues[GetQueueIndex(LastCompletedFenceValue)] = LastCompletedFenceValue;
+			ReleaseStaleAllocations(CompletedFenceValues);
+		}
+
+		// Releases all allocations whose fences are at most the last completed fence values of their queues.
+		// Released blocks that are adjacent are freed as one range, so a frame's worth of allocations freed
+		// together costs one free per contiguous run instead of one per allocation.
+		void ReleaseStaleAllocations(const uint64_t(&CompletedFenceValues)[MaxQueues])
+		{
+			auto StaleIt = std::partition(m_StaleAllocations.begin(), m_StaleAllocations.end(),
+				[&CompletedFenceValues](const StaleAllocationAttribs& Stale)
+				{
+					return !Stale.IsComplete(CompletedFenceValues);
+				});
+			if (StaleIt == m_StaleAllocations.end())
+				return;
+
+			m_ReleasedAllocations.assign(StaleIt, m_StaleAllocations.end());
+			m_StaleAllocations.erase(StaleIt, m_StaleAllocations.end());
+			std::sort(m_ReleasedAllocations.begin(), m_ReleasedAllocations.end(),
+				[](const StaleAllocationAttribs& a, const StaleAllocationAttribs& b)
+				{
+					return a.Offset < b.Offset;
+				});
+
+			auto RangeBegin = m_ReleasedAllocations.begin();
+			while (RangeBegin != m_ReleasedAllocations.end())
 			{
-				auto& OldestAllocation = m_StaleAllocations.front();
-				VariableSizeAllocationsManager::Free(OldestAllocation.Offset, OldestAllocation.Size);
-				m_StaleAllocationsSize -= OldestAllocation.Size;
-				m_StaleAllocations.pop_front();
+				OffsetType Size = RangeBegin->Size, Padding = RangeBegin->Padding;
+				auto RangeEnd = RangeBegin + 1;
+				for (; RangeEnd != m_ReleasedAllocations.end() && RangeEnd->Offset == RangeBegin->Offset + Size; ++RangeEnd)
+				{
+					Size += RangeEnd->Size;
+					Padding += RangeEnd->Padding;
+				}
+
+				FreeRange(RangeBegin->Offset, Size, Padding, RangeEnd - RangeBegin);
+				m_StaleAllocationsSize -= Size;
+				RangeBegin = RangeEnd;
 			}
 		}
 
 		size_t GetStaleAllocationsSize() const { return m_StaleAllocationsSize; }
 
+		struct DefragmentationMove
+		{
+			size_t     AllocationIndex; // In the array given to PlanDefragmentation()
+			OffsetType SrcOffset;       // Aligned offsets of the data
+			OffsetType DstOffset;
+			OffsetType Size;            // Bytes to copy
+		};
+
+		// Plans one step of compaction: live allocations are moved, highest first, into the lowest free blocks
+		// below them until ByteBudget bytes have been moved. Every allocation moved is replaced in Allocations with
+		// its new block and the old block is freed with FenceValue, so the copies in Moves must be executed on the
+		// GPU before that fence is signaled, and the data read from the new place afterwards. All the allocations
+		// must have been made with Alignment.
+		// Called every frame, the moved-out blocks come back as their fences complete and coalesce at the top of
+		// the space, which grows the largest free block until nothing fits lower. Returns the bytes moved.
+		OffsetType PlanDefragmentation(Allocation* Allocations, size_t NumAllocations, OffsetType Alignment, OffsetType ByteBudget,
+			uint64_t FenceValue, std::vector<DefragmentationMove>& Moves)
+		{
+			Moves.clear();
+
+			std::vector<size_t> Order;
+			Order.reserve(NumAllocations);
+			for (size_t i = 0; i < NumAllocations; ++i)
+			{
+				if (Allocations[i].IsValid())
+					Order.push_back(i);
+			}
+			std::sort(Order.begin(), Order.end(), [Allocations](size_t a, size_t b)
+			{
+				return Allocations[a].UnalignedOffset > Allocations[b].UnalignedOffset;
+			});
+
+			OffsetType BytesMoved = 0;
+			for (auto Index : Order)
+			{
+				auto& OldAllocation = Allocations[Index];
+				const auto SrcOffset = Math::AlignUp(OldAllocation.UnalignedOffset, Alignment);
+				// Same as the aligned size requested, which the new block will have too
+				const auto DataSize = OldAllocation.UnalignedOffset + OldAllocation.Size - SrcOffset;
+				if (BytesMoved + DataSize > ByteBudget)
+					continue;
+
+				auto NewAllocation = Allocate(OldAllocation.Size - OldAllocation.Padding, Alignment, OldAllocation.UnalignedOffset);
+				if (!NewAllocation.IsValid())
+					continue;
+
+				Moves.push_back({ Index, SrcOffset, Math::AlignUp(NewAllocation.UnalignedOffset, Alignment), DataSize });
+				Free(std::move(OldAllocation), FenceValue);
+				OldAllocation = NewAllocation;
+				BytesMoved += DataSize;
+			}
+			return BytesMoved;
+		}
+
+		AllocatorStats GetStats() const
+		{
+			AllocatorStats Stats = VariableSizeAllocationsManager::GetStats();
+			Stats.PendingFreeSize = m_StaleAllocationsSize;
+			return Stats;
+		}
+
 	private:
-		std::deque<StaleAllocationAttribs> m_StaleAllocations;
+		std::vector<StaleAllocationAttribs> m_StaleAllocations;
+		// Scratch for ReleaseStaleAllocations(), kept to not allocate every frame
+		std::vector<StaleAllocationAttribs> m_ReleasedAllocations;
 		size_t m_StaleAllocationsSize = 0;
 	};
 
@@ -10,8 +10,11 @@
 #include "CommandContext.h"
 #include "BufferManager.h"
 #include "TextureManager.h"
+#include "EngineTuning.h"
 
-#include "FrameGraphImpl.hpp"
+#include "FrameGraphRenderingBuffers.hpp"
+
+#include <sstream>
 
 #include "CompiledShaders/DefaultVS.h"
 #include "CompiledShaders/DefaultPS.h"
@@ -47,10 +50,24 @@ private:
     TextureRef m_TestTexture;
 
     ShadowCamera m_SunShadowCamera;
+
+    // Rebuilt every frame; kept as a member so its compilation cache survives Clear().
+    FG::FrameGraph m_FrameGraph;
 };
 
 CREATE_APPLICATION(LearnViewer)
 
+namespace
+{
+    // Prints the planned static and framegraph-managed rendering buffer memory at 1080p, 1440p and 4K to the debug output
+    CallbackTrigger ReportRenderingBufferMemory("Graphics/Memory/Report Rendering Buffers", [](void*)
+    {
+        ostringstream report;
+        FG::WriteRenderingBufferMemoryReport(report);
+        Utility::Print(report.str().c_str());
+    });
+}
+
 RootSignature m_TestRootSig;
 GraphicsPSO m_TestPSO(L"Renderer: Test PSO");
 //DescriptorHeap s_TextureHeap;
@@ -173,6 +190,8 @@ void LearnViewer::Cleanup(void) {
     m_VertexBuffer.Destroy();
     m_IndexBuffer.Destroy();
 
+    FG::DestroyTransientPools();
+
     TextureManager::Shutdown();
 }
 
@@ -181,8 +200,7 @@ void LearnViewer::Update(float deltaT) {
 }
 
 void LearnViewer::RenderScene(void) {
-    FG::FrameGraph frameGraph;
-    auto retained_resource = frameGraph.AddRetainedResource("Retained Resource 1", FG::ColorBufferDescription(), &g_SceneColorBuffer);
+    auto retained_resource = m_FrameGraph.AddRetainedResource("Retained Resource 1", FG::ColorBufferDescription(), &g_SceneColorBuffer);
 
     // First render task declaration.
     struct render_task_1_data
@@ -192,7 +210,7 @@ void LearnViewer::RenderScene(void) {
     };
 
     // Ʒ
-    auto render_task_1 = frameGraph.AddRenderPass<render_task_1_data>(
+    auto render_task_1 = m_FrameGraph.AddRenderPass<render_task_1_data>(
         "Render Pass 1",
         [&](render_task_1_data& data, FG::FrameGraphBuilder& builder) {
             FG::ColorBufferDescription middleColorBuffer{
@@ -210,17 +228,19 @@ void LearnViewer::RenderScene(void) {
                 g_SceneDepthBuffer.GetFormat()
             };
 
-            data.outputRenderColor = builder.Create<FG::ColorBufferResource>("RenderColor1", middleColorBuffer);
-            data.outputRenderDepth = builder.Create<FG::DepthBufferResource>("RenderDepth1", middleDepthBuffer);
+            data.outputRenderColor = builder.Create<FG::ColorBufferResource>("RenderColor1", middleColorBuffer, FG::ResourceAccess::RenderTarget);
+            data.outputRenderDepth = builder.Create<FG::DepthBufferResource>("RenderDepth1", middleDepthBuffer, FG::ResourceAccess::DepthWrite);
         },
-        [=](const render_task_1_data& data) {
+        [=](const render_task_1_data& data, CommandContext& context) {
             auto actualOutputRenderColor = data.outputRenderColor->Actual();
             auto actualOutputRenderDepth = data.outputRenderDepth->Actual();
 
-            ColorBuffer realRenderColor = std::move(*actualOutputRenderColor);
-            DepthBuffer realRenderDepth = std::move(*actualOutputRenderDepth);
+            // The actuals belong to the framegraph and get recycled once this pass's fence completes.
+            ColorBuffer& realRenderColor = *actualOutputRenderColor;
+            DepthBuffer& realRenderDepth = *actualOutputRenderDepth;
 
-            GraphicsContext& gfxContext = GraphicsContext::Begin(L"Scene Render");
+            // The framegraph has already transitioned the outputs and submits the context after the pass.
+            GraphicsContext& gfxContext = context.GetGraphicsContext();
 
             __declspec(align(16)) struct DefaultVSCB
             {
@@ -230,8 +250,6 @@ void LearnViewer::RenderScene(void) {
             defaultVSCB.Proj = m_Camera.GetProjMatrix();
             defaultVSCB.View = m_Camera.GetViewMatrix();
 
-            gfxContext.TransitionResource(realRenderColor, D3D12_RESOURCE_STATE_RENDER_TARGET);
-            gfxContext.TransitionResource(realRenderDepth, D3D12_RESOURCE_STATE_DEPTH_WRITE);
             gfxContext.ClearColor(realRenderColor);
             gfxContext.ClearDepth(realRenderDepth);
 
@@ -250,10 +268,6 @@ void LearnViewer::RenderScene(void) {
             gfxContext.SetVertexBuffer(0, m_VertexBuffer.VertexBufferView());
 
             gfxContext.DrawIndexed(m_IndexBuffer.GetElementCount());
-
-            int fence = gfxContext.Finish();
-
-            return fence;
         });
 
     auto& data_1 = render_task_1->Data();
@@ -264,22 +278,24 @@ void LearnViewer::RenderScene(void) {
         FG::DepthBufferResource* inputRenderDepth;
     };
 
-    auto render_task_2 = frameGraph.AddRenderPass<render_task_2_data>(
+    auto render_task_2 = m_FrameGraph.AddRenderPass<render_task_2_data>(
         "Render Pass 2",
         [&](render_task_2_data& data, FG::FrameGraphBuilder& builder) {
-            data.inputRenderDepth = builder.Read(data_1.outputRenderDepth);
+            data.inputRenderDepth = builder.Read(data_1.outputRenderDepth, FG::ResourceAccess::ShaderResource);
         },
-        [=](const render_task_2_data& data) {
+        [=](const render_task_2_data& data, CommandContext& context) {
             auto actualRenderDepth = data.inputRenderDepth;
 
             //  g_SceneColor
-
-            return -1;
         });
 
-    frameGraph.Compile();
-    frameGraph.Execute();
-    frameGraph.Clear();
+    if (!m_FrameGraph.Compile())
+        Utility::Printf("Framegraph rejected: %zu passes depend on each other in a cycle\n", m_FrameGraph.CyclicPasses().size());
+    FG::PrepareTransientHeaps(m_FrameGraph.TransientHeapSizes());
+    m_FrameGraph.Execute(FG::g_CommandRecorder);
+    m_FrameGraph.Clear();
+
+    FG::UpdateTransientPools();
 
     /*
     GraphicsContext& gfxContext = GraphicsContext::Begin(L"Scene Render");
@@ -0,0 +1,164 @@
+// Replaces the global operators new and delete of the program it is linked into, counting every allocation and the
+// bytes held.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#ifdef _WIN32
+#include <malloc.h>
+#elif defined(__APPLE__)
+#include <malloc/malloc.h>
+#else
+#include <malloc.h>
+#endif
+
+#include "AllocationCounter.hpp"
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete" // The replaced operators below do pair malloc with free.
+#endif
+
+namespace
+{
+	std::atomic<std::size_t> g_AllocationCount{ 0 };
+	std::atomic<std::size_t> g_AllocatedBytes{ 0 };
+	std::atomic<std::size_t> g_PeakAllocatedBytes{ 0 };
+
+	std::size_t BlockSize(void* pointer)
+	{
+#ifdef _WIN32
+		return _msize(pointer);
+#elif defined(__APPLE__)
+		return malloc_size(pointer);
+#else
+		return malloc_usable_size(pointer);
+#endif
+	}
+	std::size_t AlignedBlockSize(void* pointer, const std::size_t alignment)
+	{
+#ifdef _WIN32
+		return _aligned_msize(pointer, alignment, 0);
+#else
+		return BlockSize(pointer);
+#endif
+	}
+
+	void* Counted(void* pointer, const std::size_t bytes)
+	{
+		if (pointer == nullptr)
+			throw std::bad_alloc();
+		g_AllocationCount.fetch_add(1, std::memory_order_relaxed);
+		const auto allocated = g_AllocatedBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+		auto peak = g_PeakAllocatedBytes.load(std::memory_order_relaxed);
+		while (allocated > peak && !g_PeakAllocatedBytes.compare_exchange_weak(peak, allocated, std::memory_order_relaxed))
+		{
+		}
+		return pointer;
+	}
+
+	void* Allocate(const std::size_t size)
+	{
+		auto pointer = std::malloc(size != 0 ? size : 1);
+		return Counted(pointer, pointer != nullptr ? BlockSize(pointer) : 0);
+	}
+	void* AlignedAllocate(std::size_t size, std::size_t alignment)
+	{
+		size = size != 0 ? size : 1;
+		alignment = std::max(alignment, sizeof(void*));
+#ifdef _WIN32
+		auto pointer = _aligned_malloc(size, alignment);
+#else
+		auto pointer = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+#endif
+		return Counted(pointer, pointer != nullptr ? AlignedBlockSize(pointer, alignment) : 0);
+	}
+
+	void Free(void* pointer)
+	{
+		if (pointer == nullptr)
+			return;
+		g_AllocatedBytes.fetch_sub(BlockSize(pointer), std::memory_order_relaxed);
+		std::free(pointer);
+	}
+	void AlignedFree(void* pointer, const std::size_t alignment)
+	{
+		if (pointer == nullptr)
+			return;
+		g_AllocatedBytes.fetch_sub(AlignedBlockSize(pointer, std::max(alignment, sizeof(void*))), std::memory_order_relaxed);
+#ifdef _WIN32
+		_aligned_free(pointer);
+#else
+		std::free(pointer);
+#endif
+	}
+}
+
+std::size_t AllocationCount()
+{
+	return g_AllocationCount.load(std::memory_order_relaxed);
+}
+
+std::size_t AllocatedBytes()
+{
+	return g_AllocatedBytes.load(std::memory_order_relaxed);
+}
+
+std::size_t PeakAllocatedBytes()
+{
+	return g_PeakAllocatedBytes.load(std::memory_order_relaxed);
+}
+
+void ResetPeakAllocatedBytes()
+{
+	g_PeakAllocatedBytes.store(AllocatedBytes(), std::memory_order_relaxed);
+}
+
+void* operator new(std::size_t size)
+{
+	return Allocate(size);
+}
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+	return AlignedAllocate(size, std::size_t(alignment));
+}
+void* operator new[](std::size_t size)
+{
+	return Allocate(size);
+}
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+	return AlignedAllocate(size, std::size_t(alignment));
+}
+void operator delete(void* pointer) noexcept
+{
+	Free(pointer);
+}
+void operator delete(void* pointer, std::size_t) noexcept
+{
+	Free(pointer);
+}
+void operator delete(void* pointer, std::align_val_t alignment) noexcept
+{
+	AlignedFree(pointer, std::size_t(alignment));
+}
+void operator delete(void* pointer, std::size_t, std::align_val_t alignment) noexcept
+{
+	AlignedFree(pointer, std::size_t(alignment));
+}
+void operator delete[](void* pointer) noexcept
+{
+	Free(pointer);
+}
+void operator delete[](void* pointer, std::size_t) noexcept
+{
+	Free(pointer);
+}
+void operator delete[](void* pointer, std::align_val_t alignment) noexcept
+{
+	AlignedFree(pointer, std::size_t(alignment));
+}
+void operator delete[](void* pointer, std::size_t, std::align_val_t alignment) noexcept
+{
+	AlignedFree(pointer, std::size_t(alignment));
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstddef>
+
+// Heap allocations through operator new since the program started, from every thread. Only counted in programs that
+// link AllocationCounter.cpp.
+std::size_t AllocationCount();
+
+// Bytes the heap holds for operator new, as the C runtime reports the size of each block, and the most it held since
+// the last ResetPeakAllocatedBytes(). Stand-ins for the resident size of a data structure, which the process's own
+// resident size cannot isolate.
+std::size_t AllocatedBytes();
+std::size_t PeakAllocatedBytes();
+void ResetPeakAllocatedBytes();
@@ -0,0 +1,244 @@
+// Replays random allocations and frees of 1 to 64 minimum blocks through BuddyAllocator and, for comparison, through
+// the allocator it replaced: std::set free lists, a heap-allocated block per request and std::bad_alloc thrown and
+// caught when no block is large enough. Prints operations per second, heap allocations and the heap bytes held as
+// comma-separated values. Built against Tests/Stubs, so nothing touches a GPU.
+//
+//     BuddyAllocatorBenchmark [--ops N]
+//
+// BuddyAllocator also pays for its locks and its deferred frees, which come back at the end of every 64 operations as
+// CleanUpAllocations() would return them once per frame; the previous allocator freed at once and took no locks.
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "AllocationCounter.hpp"
+#include "BuddyAllocator.h"
+#include "CommandListManager.h"
+
+namespace
+{
+	constexpr size_t kMinBlockSize = 256;
+	constexpr int kOperationsPerFrame = 64;
+
+	constexpr size_t kInvalidHandle = ~size_t(0);
+
+	// What BuddyAllocator did before, minus the GPU resources: a set of free offsets per order, split and merged
+	// recursively.
+	class FreeListBuddyAllocator
+	{
+	public:
+		explicit FreeListBuddyAllocator(UINT maxOrder) : m_maxOrder(maxOrder), m_freeBlocks(maxOrder + 1)
+		{
+			m_freeBlocks[maxOrder].insert(0);
+		}
+
+		BuddyBlock* Allocate(UINT order)
+		{
+			try
+			{
+				const size_t offset = AllocateBlock(order);
+				return new BuddyBlock(uint32_t(offset), uint32_t(size_t(1) << order), uint32_t(size_t(1) << order));
+			}
+			catch (std::bad_alloc&)
+			{
+				return new BuddyBlock();
+			}
+		}
+
+		void Deallocate(BuddyBlock* block)
+		{
+			DeallocateBlock(block->GetOffset(), Math::Log2(block->GetSize()));
+			delete block;
+		}
+
+	private:
+		size_t AllocateBlock(UINT order)
+		{
+			if (order > m_maxOrder)
+				throw std::bad_alloc();
+
+			auto free = m_freeBlocks[order].begin();
+			if (free == m_freeBlocks[order].end())
+			{
+				const size_t left = AllocateBlock(order + 1);
+				m_freeBlocks[order].insert(left + (size_t(1) << order));
+				return left;
+			}
+			const size_t offset = *free;
+			m_freeBlocks[order].erase(free);
+			return offset;
+		}
+
+		void DeallocateBlock(size_t offset, UINT order)
+		{
+			const size_t buddy = offset ^ (size_t(1) << order);
+			auto free = m_freeBlocks[order].find(buddy);
+			if (free == m_freeBlocks[order].end())
+			{
+				m_freeBlocks[order].insert(offset);
+				return;
+			}
+			DeallocateBlock(std::min(offset, buddy), order + 1);
+			m_freeBlocks[order].erase(free);
+		}
+
+		UINT m_maxOrder;
+		std::vector<std::set<size_t>> m_freeBlocks;
+	};
+
+	struct Result
+	{
+		double seconds = 0.0;
+		size_t heapAllocations = 0;
+		size_t heapBytes = 0;       // Held once constructed
+		size_t peakHeapBytes = 0;   // Held at most during the run
+		size_t failures = 0;
+	};
+
+	// The same sequence for both: 55% allocations of 1 to 64 minimum blocks, the rest frees of a random live block.
+	// live is only scratch, reserved by the caller so that it does not count towards the allocator's heap bytes.
+	template<typename AllocateType, typename FreeType, typename FrameType>
+	void Replay(const size_t operations, const UINT maxOrder, std::vector<std::pair<size_t, UINT>>& live, Result& result,
+		AllocateType&& allocate, FreeType&& free, FrameType&& endFrame)
+	{
+		std::mt19937 random(7);
+		live.clear();
+
+		const auto allocations = AllocationCount();
+		const auto start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < operations; ++i)
+		{
+			if (live.empty() || random() % 100 < 55)
+			{
+				const UINT order = std::min<UINT>(Math::Log2(1 + random() % 64), maxOrder);
+				const size_t handle = allocate(order);
+				if (handle == kInvalidHandle)
+					++result.failures;
+				else
+					live.emplace_back(handle, order);
+			}
+			else
+			{
+				const size_t index = random() % live.size();
+				free(live[index].first, live[index].second);
+				live[index] = live.back();
+				live.pop_back();
+			}
+			if (i % kOperationsPerFrame == kOperationsPerFrame - 1)
+				endFrame();
+		}
+		for (auto& block : live)
+			free(block.first, block.second);
+		endFrame();
+		result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		result.heapAllocations = AllocationCount() - allocations;
+	}
+
+	Result RunBuddyAllocator(const size_t operations, const UINT maxOrder, std::vector<std::pair<size_t, UINT>>& live)
+	{
+		// Handles index the live blocks; freed slots are reused.
+		std::vector<BuddyBlock> blocks;
+		std::vector<size_t> freeSlots;
+		blocks.reserve(operations);
+		freeSlots.reserve(operations);
+
+		Result result;
+		const auto bytes = AllocatedBytes();
+		BuddyAllocator allocator(kManualSubAllocationStrategy, D3D12_HEAP_TYPE_DEFAULT, kMinBlockSize << maxOrder, kMinBlockSize);
+		allocator.Initialize();
+		result.heapBytes = AllocatedBytes() - bytes;
+		ResetPeakAllocatedBytes();
+
+		Replay(operations, maxOrder, live, result,
+			[&](UINT order)
+			{
+				BuddyBlock block = allocator.Allocate(uint32_t(kMinBlockSize << order), 1);
+				if (block.IsNull())
+					return kInvalidHandle;
+				if (freeSlots.empty())
+				{
+					blocks.push_back(block);
+					return blocks.size() - 1;
+				}
+				const size_t slot = freeSlots.back();
+				freeSlots.pop_back();
+				blocks[slot] = block;
+				return slot;
+			},
+			[&](size_t slot, UINT)
+			{
+				allocator.Deallocate(blocks[slot], g_NextStubFence.load());
+				freeSlots.push_back(slot);
+			},
+			[&]()
+			{
+				g_CompletedStubFence = g_NextStubFence++;
+				allocator.CleanUpAllocations();
+			});
+		result.peakHeapBytes = PeakAllocatedBytes() - bytes;
+
+		allocator.Destroy();
+		return result;
+	}
+
+	Result RunFreeLists(const size_t operations, const UINT maxOrder, std::vector<std::pair<size_t, UINT>>& live)
+	{
+		Result result;
+		const auto bytes = AllocatedBytes();
+		FreeListBuddyAllocator allocator(maxOrder);
+		result.heapBytes = AllocatedBytes() - bytes;
+		ResetPeakAllocatedBytes();
+
+		Replay(operations, maxOrder, live, result,
+			[&](UINT order)
+			{
+				BuddyBlock* block = allocator.Allocate(order);
+				if (!block->IsNull())
+					return size_t(block);
+				delete block;
+				return kInvalidHandle;
+			},
+			[&](size_t block, UINT) { allocator.Deallocate(reinterpret_cast<BuddyBlock*>(block)); },
+			[]() {});
+		result.peakHeapBytes = PeakAllocatedBytes() - bytes;
+		return result;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	size_t operations = 2000000;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--ops") == 0 && i + 1 < argc)
+			operations = size_t(std::strtoull(argv[++i], nullptr, 10));
+		else
+		{
+			std::cerr << "usage: " << argv[0] << " [--ops N]\n";
+			return 1;
+		}
+	}
+
+	std::vector<std::pair<size_t, UINT>> live; // Handle and order
+	live.reserve(operations);
+
+	std::cout << "allocator,max_order,ops,mops_per_s,heap_allocations,heap_kb,peak_heap_kb,failures\n";
+	for (UINT maxOrder : { 12u, 16u, 20u })
+	{
+		const auto print = [&](const char* name, const Result& result)
+		{
+			std::cout << name << ',' << maxOrder << ',' << operations << ',' << operations / result.seconds / 1e6 << ','
+				<< result.heapAllocations << ',' << result.heapBytes / 1024 << ',' << result.peakHeapBytes / 1024 << ','
+				<< result.failures << '\n';
+		};
+		print("free_lists", RunFreeLists(operations, maxOrder, live));
+		print("buddy_tree", RunBuddyAllocator(operations, maxOrder, live));
+	}
+	return 0;
+}
@@ -0,0 +1,130 @@
+// Tests of BuddyAllocator built against Tests/Stubs, with the fence of the graphics queue simulated by
+// CommandListManager.h.
+
+#include <random>
+#include <thread>
+
+#include "BuddyAllocator.h"
+#include "Check.hpp"
+#include "CommandListManager.h"
+
+namespace
+{
+	constexpr size_t kMinBlockSize = 64 * 1024;
+	constexpr size_t kUnitCount = 1 << 12;
+
+	// Loader threads allocate and free while a frame loop advances the fence, with the GPU two frames behind, and
+	// cleans up once per frame. Every minimum block records whether a live block holds it and the fence it was last
+	// freed at, so that two blocks sharing memory or a block handed out again before the GPU is done with it show up.
+	void TestConcurrentLoadersAgainstFence(const kBuddyAllocationStrategy strategy, const uint32_t shardCount)
+	{
+		std::vector<std::atomic<int>> owned(kUnitCount);
+		std::vector<std::atomic<uint64_t>> freedAt(kUnitCount);
+		std::atomic<size_t> allocations{ 0 }, overlaps{ 0 }, earlyReuses{ 0 }, unclearedHandles{ 0 };
+		std::atomic<bool> stop{ false };
+
+		BuddyAllocator allocator(strategy, D3D12_HEAP_TYPE_DEFAULT, kMinBlockSize * kUnitCount, kMinBlockSize, 0, shardCount);
+		allocator.Initialize();
+		const int liveBuffers = g_LiveStubBuffers;
+
+		std::vector<std::thread> loaders;
+		for (unsigned seed = 0; seed < 8; ++seed)
+		{
+			loaders.emplace_back([&, seed]()
+			{
+				std::mt19937 random(seed);
+				std::vector<BuddyBlock> live;
+				const auto release = [&](BuddyBlock& block)
+				{
+					for (size_t unit = block.GetOffset() / kMinBlockSize; unit < (block.GetOffset() + block.GetSize()) / kMinBlockSize; ++unit)
+					{
+						freedAt[unit] = g_NextStubFence.load();
+						owned[unit] = 0;
+					}
+					allocator.Deallocate(block);
+					if (!block.IsNull())
+						++unclearedHandles;
+				};
+
+				while (!stop)
+				{
+					if (live.size() < 16 && random() % 3 != 0)
+					{
+						// Mostly small blocks, now and then one spanning several shards
+						const uint32_t bytes = random() % 50 == 0 ? uint32_t(kMinBlockSize << (8 + random() % 3)) : uint32_t(1 + random() % (kMinBlockSize * 8));
+						BuddyBlock block = allocator.Allocate(bytes, 1);
+						if (block.IsNull())
+							continue;
+						++allocations;
+						for (size_t unit = block.GetOffset() / kMinBlockSize; unit < (block.GetOffset() + block.GetSize()) / kMinBlockSize; ++unit)
+						{
+							if (owned[unit].exchange(1) != 0)
+								++overlaps;
+							if (freedAt[unit] > g_CompletedStubFence)
+								++earlyReuses;
+						}
+						live.push_back(block);
+					}
+					else if (!live.empty())
+					{
+						const size_t index = random() % live.size();
+						release(live[index]);
+						live[index] = live.back();
+						live.pop_back();
+					}
+				}
+				for (auto& block : live)
+					release(block);
+			});
+		}
+
+		for (int frame = 0; frame < 100; ++frame)
+		{
+			const uint64_t submitted = g_NextStubFence++;
+			if (submitted > 2 && submitted - 2 > g_CompletedStubFence)
+				g_CompletedStubFence = submitted - 2;
+			allocator.CleanUpAllocations();
+
+			const AllocatorStats stats = allocator.GetStats();
+			CHECK(stats.UsedSize <= stats.Capacity && stats.PeakUsedSize <= stats.Capacity);
+			std::this_thread::yield();
+		}
+		stop = true;
+		for (auto& loader : loaders)
+			loader.join();
+
+		g_CompletedStubFence = g_NextStubFence.load();
+		allocator.CleanUpAllocations();
+
+		std::printf("%s, %u shards: %zu allocations\n", strategy == kPlacedResourceStrategy ? "Placed" : "Manual", shardCount, allocations.load());
+		CHECK(allocations > 0);
+		CHECK(overlaps == 0);
+		CHECK(earlyReuses == 0);
+		CHECK(unclearedHandles == 0);
+
+		// Everything is back: the counters balance and the whole range is one free block again.
+		const AllocatorStats stats = allocator.GetStats();
+		CHECK(stats.UsedSize == 0 && stats.PendingFreeSize == 0 && stats.PaddingSize == 0);
+		CHECK(stats.AllocationCount == stats.FreeCount);
+		CHECK(stats.FreeBlockCount == shardCount);
+		CHECK(stats.LargestFreeBlock == stats.Capacity);
+		CHECK(g_LiveStubBuffers == liveBuffers);
+
+		BuddyBlock whole = allocator.Allocate(uint32_t(kMinBlockSize * kUnitCount), 1);
+		CHECK(!whole.IsNull());
+		allocator.Deallocate(whole, 0);
+		allocator.CleanUpAllocations();
+
+		allocator.Destroy();
+	}
+}
+
+int main()
+{
+	for (auto strategy : { kPlacedResourceStrategy, kManualSubAllocationStrategy })
+	{
+		for (uint32_t shardCount : { 1u, 4u, 16u })
+			TestConcurrentLoadersAgainstFence(strategy, shardCount);
+	}
+	return CheckFailures();
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdio>
+
+// The tests are plain programs: CHECK reports a failed condition and carries on, and main() returns CheckFailures(),
+// which ctest takes as the result.
+inline int& CheckFailures()
+{
+	static int failures = 0;
+	return failures;
+}
+
+#define CHECK(condition) \
+	do \
+	{ \
+		if (!(condition)) \
+		{ \
+			std::printf("%s(%d): CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+			CheckFailures()++; \
+		} \
+	} while (false)
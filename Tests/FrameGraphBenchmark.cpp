@@ -0,0 +1,48 @@
+// Runs the synthetic framegraph workloads of FrameGraphBenchmark.hpp and prints their timings as comma-separated
+// values. Needs no GPU, so CI can run it on any box and keep the output to compare against.
+//
+//     FrameGraphBenchmark [--frames N] [--warmup N] [--workers N] [--reorder] [--compile-sweep]
+//
+// With --compile-sweep it prints the uncached compile time of chains and random graphs of 10 to
+// 10,000 passes instead.
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+class CommandContext {};
+
+#include "AllocationCounter.hpp"
+#include "FrameGraphBenchmark.hpp"
+
+int main(int argc, char** argv)
+{
+	FG::BenchmarkOptions options;
+	options.allocationCount = AllocationCount;
+	auto compileSweep = false;
+	for (int i = 1; i < argc; ++i)
+	{
+		const auto value = [&]() { return i + 1 < argc ? std::size_t(std::strtoull(argv[++i], nullptr, 10)) : std::size_t(0); };
+		if (std::strcmp(argv[i], "--frames") == 0)
+			options.frames = value();
+		else if (std::strcmp(argv[i], "--warmup") == 0)
+			options.warmupFrames = value();
+		else if (std::strcmp(argv[i], "--workers") == 0)
+			options.workers = value();
+		else if (std::strcmp(argv[i], "--reorder") == 0)
+			options.reorderPasses = true;
+		else if (std::strcmp(argv[i], "--compile-sweep") == 0)
+			compileSweep = true;
+		else
+		{
+			std::cerr << "usage: " << argv[0] << " [--frames N] [--warmup N] [--workers N] [--reorder] [--compile-sweep]\n";
+			return 1;
+		}
+	}
+
+	if (compileSweep)
+		FG::RunCompileSweep(std::cout, options.frames);
+	else
+		FG::RunFrameGraphBenchmarks(std::cout, options);
+	return 0;
+}
@@ -0,0 +1,850 @@
+// Tests of the framegraph that need no renderer: the resources and passes are those of FrameGraphBenchmark.hpp, apart
+// from a resource that logs how it is placed.
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+class CommandContext {};
+
+#include "AllocationCounter.hpp"
+#include "Check.hpp"
+#include "FrameGraphBenchmark.hpp"
+#include "TransientResourcePool.hpp"
+
+using namespace FG;
+
+// Logs every realization, activation and derealization, so a test can see placed transients come and go.
+struct LoggedDescription
+{
+	std::size_t size;
+};
+
+struct LoggedActual
+{
+	char name;
+};
+
+inline bool operator==(const LoggedDescription& lhs, const LoggedDescription& rhs)
+{
+	return lhs.size == rhs.size;
+}
+
+inline std::vector<std::string> g_PlacementLog;
+
+namespace FG
+{
+	template<>
+	std::unique_ptr<LoggedActual> Realize(const LoggedDescription&)
+	{
+		g_PlacementLog.push_back("realize");
+		return std::make_unique<LoggedActual>();
+	}
+	template<>
+	void DeRealize(const LoggedDescription&, std::unique_ptr<LoggedActual>& actual_ptr, std::uint64_t)
+	{
+		g_PlacementLog.push_back("derealize");
+		actual_ptr.reset();
+	}
+	template<>
+	std::unique_ptr<LoggedActual> RealizePlaced(const LoggedDescription&, const TransientPlacement& placement)
+	{
+		g_PlacementLog.push_back("place " + std::to_string(placement.heap) + ":" + std::to_string(placement.offset));
+		return std::make_unique<LoggedActual>();
+	}
+	template<>
+	void DeRealizePlaced(const LoggedDescription&, const TransientPlacement&, std::unique_ptr<LoggedActual>& actual_ptr, std::uint64_t)
+	{
+		g_PlacementLog.push_back("unplace");
+		actual_ptr.reset();
+	}
+	template<>
+	void Activate<LoggedDescription, LoggedActual>(CommandContext&, LoggedActual&)
+	{
+		g_PlacementLog.push_back("activate");
+	}
+	template<>
+	TransientMemoryRequirements MemoryRequirements<LoggedDescription, LoggedActual>(const LoggedDescription& description)
+	{
+		return TransientMemoryRequirements{ description.size, 256 };
+	}
+}
+
+using LoggedResource = FrameGraphResource<LoggedDescription, LoggedActual>;
+
+namespace
+{
+	// Once the arena and the containers have grown, declaring, compiling and clearing the same frame again must not
+	// touch the heap.
+	void TestSteadyStateSetupDoesNotAllocate(const char* name, void (*declare)(FrameGraph&))
+	{
+		FrameGraph framegraph;
+		NullCommandRecorder recorder;
+		for (int frame = 0; frame < 4; ++frame)
+		{
+			declare(framegraph);
+			framegraph.Compile();
+			framegraph.Execute(recorder);
+			framegraph.Clear();
+		}
+
+		std::size_t allocations = 0;
+		const auto misses = framegraph.CompileCacheMisses();
+		for (int frame = 0; frame < 16; ++frame)
+		{
+			const auto before = AllocationCount();
+			declare(framegraph);
+			framegraph.Compile();
+			allocations += AllocationCount() - before;
+
+			framegraph.Execute(recorder);
+
+			const auto beforeClear = AllocationCount();
+			framegraph.Clear();
+			allocations += AllocationCount() - beforeClear;
+		}
+		std::printf("%s: %zu allocations in 16 frames of setup and compilation\n", name, allocations);
+		CHECK(allocations == 0);
+		CHECK(framegraph.CompileCacheMisses() == misses);
+	}
+
+	// The pool runs on a fake fence counter: a retired actual comes back only once its fence completed and only for the
+	// same description, and one that nobody picks up is destroyed maxUnusedFrames frames after its release.
+	void TestTransientPoolReuse()
+	{
+		std::uint64_t completedFence = 0;
+		TransientResourcePool<BenchmarkDescription, int> pool([&](const std::uint64_t fence) { return fence <= completedFence; }, 2);
+		const auto small = BenchmarkTexture(64, 64, 4);
+		const auto large = BenchmarkTexture(128, 128, 4);
+
+		auto actual = std::make_unique<int>(1);
+		const int* const address = actual.get();
+		pool.Release(small, std::move(actual), 1);
+		CHECK(pool.Acquire(small) == nullptr);
+		CHECK(pool.Totals().misses == 1 && pool.Totals().pooled == 1);
+
+		completedFence = 1;
+		CHECK(pool.Acquire(large) == nullptr);
+		actual = pool.Acquire(small);
+		CHECK(actual.get() == address);
+		CHECK(pool.Totals().hits == 1 && pool.Totals().misses == 2 && pool.Totals().pooled == 0);
+
+		pool.Release(small, std::move(actual), 2);
+		pool.NextFrame();
+		pool.NextFrame();
+		CHECK(pool.FrameStats().evictions == 0 && pool.FrameStats().pooled == 1);
+		pool.NextFrame(); // Unused for three frames, but the GPU still holds it.
+		CHECK(pool.FrameStats().evictions == 0 && pool.FrameStats().pooled == 1);
+		completedFence = 2;
+		pool.NextFrame();
+		CHECK(pool.FrameStats().evictions == 1 && pool.FrameStats().pooled == 0);
+		CHECK(pool.Totals().evictions == 1 && pool.Totals().hits == 1);
+	}
+
+	// Transients whose lifetimes do not overlap take the same memory, ones that do overlap never share a byte, and
+	// every offset honours the transient's alignment.
+	void TestTransientAliasingPlacement()
+	{
+		auto plan = PlanTransientAliasing({ { 1024, 256, 0, 1 }, { 1024, 256, 2, 3 }, { 0, 1, 0, 3 } });
+		CHECK(plan.placements[0].heap == 0 && plan.placements[0].offset == 0);
+		CHECK(plan.placements[1].heap == 0 && plan.placements[1].offset == 0);
+		CHECK(plan.placements[2].heap == kUnplacedHeap);
+		CHECK(plan.heapSizes.size() == 1 && plan.heapSizes[0] == 1024);
+		CHECK(plan.stats.unaliasedBytes == 2048 && plan.stats.aliasedBytes == 1024 && plan.stats.peakLiveBytes == 1024);
+
+		// The 300 byte allocation goes first, at zero; the others are pushed past it to their alignment.
+		plan = PlanTransientAliasing({ { 100, 1, 0, 2 }, { 300, 256, 1, 3 }, { 10, 512, 2, 2 } });
+		CHECK(plan.placements[1].offset == 0);
+		CHECK(plan.placements[0].offset == 300);
+		CHECK(plan.placements[2].offset == 512);
+
+		std::mt19937 random(5);
+		std::vector<TransientAllocation> allocations;
+		for (int i = 0; i < 300; ++i)
+		{
+			const std::size_t firstStep = random() % 60;
+			allocations.push_back({ std::size_t(1 + random() % 100000), std::size_t(1) << (random() % 17), firstStep, firstStep + random() % 12 });
+		}
+		plan = PlanTransientAliasing(allocations);
+
+		std::size_t misaligned = 0, outside = 0, intersecting = 0;
+		for (std::size_t i = 0; i < allocations.size(); ++i)
+		{
+			const auto& a = allocations[i];
+			const auto& p = plan.placements[i];
+			misaligned += p.offset % a.alignment != 0 ? 1 : 0;
+			outside += p.heap >= plan.heapSizes.size() || p.offset + a.size > plan.heapSizes[p.heap] ? 1 : 0;
+			for (std::size_t j = i + 1; j < allocations.size(); ++j)
+			{
+				const auto& b = allocations[j];
+				const auto& q = plan.placements[j];
+				const bool overlappingLifetimes = a.firstStep <= b.lastStep && b.firstStep <= a.lastStep;
+				const bool overlappingMemory = p.heap == q.heap && p.offset < q.offset + b.size && q.offset < p.offset + a.size;
+				intersecting += overlappingLifetimes && overlappingMemory ? 1 : 0;
+			}
+		}
+		std::printf("Aliasing: %zu KB unaliased, %zu KB aliased, %zu KB peak live\n", plan.stats.unaliasedBytes / 1024, plan.stats.aliasedBytes / 1024, plan.stats.peakLiveBytes / 1024);
+		CHECK(misaligned == 0);
+		CHECK(outside == 0);
+		CHECK(intersecting == 0);
+		CHECK(plan.stats.peakLiveBytes <= plan.stats.aliasedBytes && plan.stats.aliasedBytes < plan.stats.unaliasedBytes);
+	}
+
+	// Whatever does not fit under maxHeapSize next to the live allocations of a heap opens the next heap, and an
+	// allocation larger than the cap gets a heap of its own.
+	void TestTransientAliasingHeapCap()
+	{
+		constexpr std::size_t MB = 1024 * 1024;
+		const auto plan = PlanTransientAliasing({ { MB, MB, 0, 4 }, { MB, MB, 1, 4 }, { MB, MB, 2, 4 }, { 3 * MB, MB, 3, 4 }, { MB, MB, 5, 6 } }, 2 * MB);
+		CHECK(plan.heapSizes.size() == 3);
+		CHECK(plan.placements[3].heap == 0 && plan.placements[3].offset == 0);
+		CHECK(plan.placements[0].heap == 1 && plan.placements[0].offset == 0);
+		CHECK(plan.placements[1].heap == 1 && plan.placements[1].offset == MB);
+		CHECK(plan.placements[2].heap == 2 && plan.placements[2].offset == 0);
+		CHECK(plan.placements[4].heap == 0 && plan.placements[4].offset == 0);
+		CHECK(plan.heapSizes[0] == 3 * MB && plan.heapSizes[1] == 2 * MB && plan.heapSizes[2] == MB);
+		CHECK(plan.stats.heapCount == 3 && plan.stats.aliasedBytes == 6 * MB);
+	}
+
+	// Placed transients are realized at their placement and activated before the barriers of their first use. Those a
+	// compute pass touches keep an allocation of their own, so E takes the memory of A.
+	void TestPlacedTransients()
+	{
+		FrameGraph framegraph;
+		LoggedResource* a = nullptr;
+		LoggedResource* b = nullptr;
+		LoggedResource* c = nullptr;
+		struct Data
+		{
+
+		};
+		const auto logPass = [](const Data&, CommandContext&) { g_PlacementLog.push_back("pass"); };
+		framegraph.AddRenderPass<Data>("A", [&](Data&, FrameGraphBuilder& builder)
+		{
+			a = builder.Create<LoggedResource>("A", LoggedDescription{ 1024 }, ResourceAccess::RenderTarget);
+		}, logPass);
+		framegraph.AddRenderPass<Data>("B", [&](Data&, FrameGraphBuilder& builder)
+		{
+			builder.Read(a, ResourceAccess::ShaderResource);
+			b = builder.Create<LoggedResource>("B", LoggedDescription{ 1024 }, ResourceAccess::RenderTarget);
+		}, logPass);
+		framegraph.AddRenderPass<Data>("C", [&](Data&, FrameGraphBuilder& builder)
+		{
+			builder.SetQueue(QueueType::Compute);
+			builder.Read(b, ResourceAccess::ShaderResource);
+			c = builder.Create<LoggedResource>("C", LoggedDescription{ 1024 }, ResourceAccess::UnorderedAccess);
+		}, logPass);
+		framegraph.AddRenderPass<Data>("D", [&](Data&, FrameGraphBuilder& builder)
+		{
+			builder.Read(c, ResourceAccess::ShaderResource);
+			builder.Create<LoggedResource>("E", LoggedDescription{ 1024 }, ResourceAccess::RenderTarget);
+		}, logPass)->SetCullImmune(true);
+
+		framegraph.Compile();
+		CHECK(a->Placement().heap == 0 && a->Placement().offset == 0);
+		CHECK(b->Placement().heap == kUnplacedHeap);
+		CHECK(c->Placement().heap == kUnplacedHeap);
+		CHECK(framegraph.TransientHeapSizes().size() == 1 && framegraph.TransientHeapSizes()[0] == 1024);
+
+		g_PlacementLog.clear();
+		NullCommandRecorder recorder;
+		framegraph.Execute(recorder);
+		const std::vector<std::string> expected = {
+			"place 0:0", "activate", "pass",
+			"realize", "pass", "unplace",
+			"realize", "pass", "derealize",
+			"place 0:0", "activate", "pass", "unplace", "derealize" };
+		CHECK(g_PlacementLog == expected);
+	}
+
+	// A write after reads and a read after a write each get a transition right before the use; repeated reads in one
+	// state get none, and a UAV after a UAV gets a barrier of its own.
+	void TestPlanBarriersTransitions()
+	{
+		const auto plan = PlanBarriers(1, {
+			{ { 0, ResourceAccess::RenderTarget } },
+			{ { 0, ResourceAccess::ShaderResource } },
+			{ { 0, ResourceAccess::ShaderResource } },
+			{ { 0, ResourceAccess::UnorderedAccess } },
+			{ { 0, ResourceAccess::UnorderedAccess } } });
+		const auto isFull = [](const PlannedBarrier& barrier, const ResourceAccess before, const ResourceAccess after, const std::size_t previousStep)
+		{
+			return barrier.resource == 0 && barrier.before == before && barrier.after == after && barrier.phase == BarrierPhase::Full && barrier.previousStep == previousStep;
+		};
+		CHECK(plan.steps[0].before.size() == 1 && isFull(plan.steps[0].before[0], ResourceAccess::None, ResourceAccess::RenderTarget, kNoStep));
+		CHECK(plan.steps[1].before.size() == 1 && isFull(plan.steps[1].before[0], ResourceAccess::RenderTarget, ResourceAccess::ShaderResource, 0));
+		CHECK(plan.steps[2].before.empty());
+		CHECK(plan.steps[3].before.size() == 1 && isFull(plan.steps[3].before[0], ResourceAccess::ShaderResource, ResourceAccess::UnorderedAccess, 2));
+		CHECK(plan.steps[4].before.size() == 1 && isFull(plan.steps[4].before[0], ResourceAccess::UnorderedAccess, ResourceAccess::UnorderedAccess, 3));
+		for (auto& barriers : plan.steps)
+			CHECK(barriers.after.empty() && barriers.handoff.empty());
+		CHECK(plan.stats.emitted == 4 && plan.stats.avoided == 1 && plan.stats.split == 0);
+		CHECK(plan.states[0] == ResourceAccess::UnorderedAccess && plan.lastSteps[0] == 4);
+	}
+
+	// A transition is split when a step that does not touch the resource lies between its uses: it begins after the
+	// previous use and ends before the next one. Neighbouring uses, or splitting turned off, give a full barrier.
+	void TestPlanBarriersSplit()
+	{
+		const std::vector<std::vector<ResourceUse>> steps = {
+			{ { 0, ResourceAccess::RenderTarget } },
+			{ { 1, ResourceAccess::RenderTarget } },
+			{ { 0, ResourceAccess::ShaderResource }, { 1, ResourceAccess::ShaderResource } } };
+
+		auto plan = PlanBarriers(2, steps);
+		CHECK(plan.steps[0].after.size() == 1);
+		CHECK(plan.steps[0].after[0].resource == 0 && plan.steps[0].after[0].phase == BarrierPhase::Begin);
+		CHECK(plan.steps[0].after[0].before == ResourceAccess::RenderTarget && plan.steps[0].after[0].after == ResourceAccess::ShaderResource);
+		CHECK(plan.steps[1].after.empty());
+		CHECK(plan.steps[2].before.size() == 2);
+		CHECK(plan.steps[2].before[0].resource == 0 && plan.steps[2].before[0].phase == BarrierPhase::End && plan.steps[2].before[0].previousStep == 0);
+		CHECK(plan.steps[2].before[1].resource == 1 && plan.steps[2].before[1].phase == BarrierPhase::Full);
+		CHECK(plan.stats.split == 1 && plan.stats.emitted == 4);
+
+		plan = PlanBarriers(2, steps, false);
+		CHECK(plan.steps[0].after.empty());
+		CHECK(plan.steps[2].before.size() == 2 && plan.steps[2].before[0].phase == BarrierPhase::Full);
+		CHECK(plan.stats.split == 0);
+
+		// Nor is it split across queues.
+		plan = PlanBarriers(2, { { { 0, ResourceAccess::UnorderedAccess } }, { { 1, ResourceAccess::RenderTarget } }, { { 0, ResourceAccess::CopySource } } }, true,
+			{ QueueType::Graphics, QueueType::Graphics, QueueType::Compute });
+		CHECK(plan.steps[0].after.empty());
+		CHECK(plan.steps[2].before.size() == 1 && plan.steps[2].before[0].phase == BarrierPhase::Full);
+	}
+
+	// A transition the queue of a step cannot record goes after the previous use when that ran on the graphics queue,
+	// and to the graphics queue right before the step otherwise.
+	void TestPlanBarriersQueueHandoff()
+	{
+		const std::vector<QueueType> queues = { QueueType::Graphics, QueueType::Compute, QueueType::Compute, QueueType::Compute };
+		const auto plan = PlanBarriers(2, {
+			{ { 0, ResourceAccess::RenderTarget } },
+			{ { 0, ResourceAccess::ShaderResource } },
+			{ { 1, ResourceAccess::UnorderedAccess } },
+			{ { 1, ResourceAccess::ShaderResource } } }, true, queues);
+
+		CHECK(plan.steps[0].after.size() == 1 && plan.steps[0].after[0].resource == 0 && plan.steps[0].after[0].phase == BarrierPhase::Full);
+		CHECK(plan.steps[0].after[0].before == ResourceAccess::RenderTarget && plan.steps[0].after[0].after == ResourceAccess::ShaderResource);
+		CHECK(plan.steps[1].before.empty() && plan.steps[1].handoff.empty());
+
+		// The first use of a resource starts from an unknown state, which only the graphics queue can leave.
+		CHECK(plan.steps[2].before.empty() && plan.steps[2].handoff.size() == 1 && plan.steps[2].handoff[0].after == ResourceAccess::UnorderedAccess);
+		CHECK(plan.steps[3].before.empty() && plan.steps[3].handoff.size() == 1);
+		CHECK(plan.steps[3].handoff[0].before == ResourceAccess::UnorderedAccess && plan.steps[3].handoff[0].after == ResourceAccess::ShaderResource);
+		CHECK(plan.steps[3].handoff[0].previousStep == 2);
+	}
+
+	// Both halves of a split barrier are recorded into one context, so a transition whose uses are submitted apart is
+	// not split; in a graph that is once its passes are submitted one by one.
+	void TestSplitBarriersStayInTheirBatch()
+	{
+		const std::vector<std::vector<ResourceUse>> steps = {
+			{ { 0, ResourceAccess::RenderTarget } },
+			{ { 1, ResourceAccess::RenderTarget } },
+			{ { 0, ResourceAccess::ShaderResource }, { 1, ResourceAccess::ShaderResource } } };
+		auto plan = PlanBarriers(2, steps, true, {}, { 0, 0, 0 });
+		CHECK(plan.stats.split == 1);
+		plan = PlanBarriers(2, steps, true, {}, { 0, 0, 1 });
+		CHECK(plan.stats.split == 0 && plan.steps[0].after.empty());
+		CHECK(plan.steps[2].before.size() == 2 && plan.steps[2].before[0].phase == BarrierPhase::Full);
+
+		const auto compile = [](const std::size_t maxPassesPerSubmission)
+		{
+			FrameGraph framegraph;
+			framegraph.SetMaxPassesPerSubmission(maxPassesPerSubmission);
+			BenchmarkResource* a = nullptr;
+			BenchmarkResource* b = nullptr;
+			AddBenchmarkPass(framegraph, "P0", [&](BenchmarkPassData&, FrameGraphBuilder& builder)
+			{
+				a = builder.Create<BenchmarkResource>("A", BenchmarkTexture(4, 4, 4), ResourceAccess::RenderTarget);
+			});
+			AddBenchmarkPass(framegraph, "P1", [&](BenchmarkPassData&, FrameGraphBuilder& builder)
+			{
+				b = builder.Create<BenchmarkResource>("B", BenchmarkTexture(4, 4, 4), ResourceAccess::RenderTarget);
+			});
+			AddBenchmarkPass(framegraph, "P2", [&](BenchmarkPassData&, FrameGraphBuilder& builder)
+			{
+				builder.Read(a, ResourceAccess::ShaderResource);
+				builder.Read(b, ResourceAccess::ShaderResource);
+			})->SetCullImmune(true);
+			framegraph.Compile();
+			return framegraph.BarrierCounts();
+		};
+		CHECK(compile(0).split == 1);
+		CHECK(compile(1).split == 0 && compile(1).emitted == compile(0).emitted);
+	}
+
+	// Subresources are numbered mips first, resource after resource, and a first use or an untracked one stands for
+	// the whole resource.
+	void TestSubresourceIndexing()
+	{
+		const auto indexing = IndexSubresources({ { 3, 1 }, { 1, 2 }, { 2, 2 } });
+		CHECK((indexing.offsets == std::vector<std::size_t>{ 0, 3, 5, 9 }));
+		CHECK(indexing.Count() == 9);
+		CHECK(indexing.Index(0, 2, 0) == 2 && indexing.Index(1, 0, 1) == 4 && indexing.Index(2, 1, 1) == 8);
+		CHECK(indexing.Resource(0) == 0 && indexing.Resource(3) == 1 && indexing.Resource(4) == 1 && indexing.Resource(8) == 2);
+
+		const auto expanded = ExpandSubresourceUses(indexing, {
+			{ { 2, ResourceAccess::RenderTarget, { 1, 1, 0, 1 } } },
+			{ { 2, ResourceAccess::ShaderResource, { 1, 1, 0, 2 } } },
+			{ { 2, ResourceAccess::None, { 0, 1, 1, 1 } }, { 0, ResourceAccess::CopyDest } },
+			{ { 2, ResourceAccess::UnorderedAccess, { 0, 1, 1, 1 } } } });
+		const auto indices = [](const std::vector<ResourceUse>& uses)
+		{
+			std::vector<std::size_t> indices;
+			for (auto& use : uses)
+				indices.push_back(use.resource);
+			return indices;
+		};
+		CHECK((indices(expanded[0]) == std::vector<std::size_t>{ 5, 6, 7, 8 }));
+		CHECK((indices(expanded[1]) == std::vector<std::size_t>{ 6, 8 }));
+		CHECK((indices(expanded[2]) == std::vector<std::size_t>{ 5, 6, 7, 8, 0, 1, 2 }));
+		CHECK((indices(expanded[3]) == std::vector<std::size_t>{ 5, 6, 7, 8 }));
+		CHECK(expanded[1][0].access == ResourceAccess::ShaderResource && expanded[1][0].range.All());
+	}
+
+	// Generating a mip chain: every pass reads mip N - 1 and renders to mip N. Only the first use transitions the whole
+	// texture; after it each pass transitions the one mip it reads, and the mips end up shader resources, which the
+	// engine is told once the last of them got there. Passes on mips of their own share a dependency level.
+	void TestMipChainBarriers()
+	{
+		const auto indexing = IndexSubresources({ { 4, 1 } });
+		std::vector<std::vector<ResourceUse>> uses = { { { 0, ResourceAccess::RenderTarget, { 0, 1, 0, 1 } } } };
+		for (std::uint32_t mip = 1; mip < 4; ++mip)
+			uses.push_back({ { 0, ResourceAccess::ShaderResource, { mip - 1, 1, 0, 1 } }, { 0, ResourceAccess::RenderTarget, { mip, 1, 0, 1 } } });
+		const auto plan = PlanSubresourceBarriers(indexing, ExpandSubresourceUses(indexing, uses));
+
+		CHECK(plan.steps[0].before.size() == 1 && plan.steps[0].before[0].range.All());
+		CHECK(plan.steps[0].before[0].before == ResourceAccess::None && plan.steps[0].before[0].after == ResourceAccess::RenderTarget);
+		std::size_t wholeResource = 0, misplaced = 0;
+		for (std::uint32_t mip = 1; mip < 4; ++mip)
+		{
+			auto& before = plan.steps[mip].before;
+			for (auto& barrier : before)
+				wholeResource += barrier.range.All() ? 1 : 0;
+			misplaced += before.size() != 1 || before[0].range != SubresourceRange{ mip - 1, 1, 0, 1 } ||
+				before[0].before != ResourceAccess::RenderTarget || before[0].after != ResourceAccess::ShaderResource ? 1 : 0;
+		}
+		CHECK(wholeResource == 0);
+		CHECK(misplaced == 0);
+
+		const auto& last = plan.steps[3].after;
+		CHECK(last.size() == 2);
+		CHECK(last[0].range == (SubresourceRange{ 3, 1, 0, 1 }) && last[0].phase == BarrierPhase::Full && last[0].after == ResourceAccess::ShaderResource);
+		CHECK(last[1].range.All() && last[1].phase == BarrierPhase::Settled && last[1].after == ResourceAccess::ShaderResource);
+		CHECK(plan.stats.emitted == 5 && plan.stats.split == 0);
+		for (auto& state : plan.states)
+			CHECK(state == ResourceAccess::ShaderResource);
+
+		// Compute writes to mips 1 and 2 after the whole texture was rendered to: no barrier orders one after the other.
+		// The mips nobody writes to go straight on to the state of the last use, so the second write settles it.
+		uses = {
+			{ { 0, ResourceAccess::RenderTarget } },
+			{ { 0, ResourceAccess::UnorderedAccess, { 1, 1, 0, 1 } } },
+			{ { 0, ResourceAccess::UnorderedAccess, { 2, 1, 0, 1 } } } };
+		const auto subresourceUses = ExpandSubresourceUses(indexing, uses);
+		CHECK((ComputeDependencyLevels(indexing.Count(), subresourceUses) == std::vector<std::vector<std::size_t>>{ { 0 }, { 1, 2 } }));
+		const auto overlapping = PlanSubresourceBarriers(indexing, subresourceUses);
+		CHECK(overlapping.steps[1].before.size() == 1 && overlapping.steps[1].before[0].range == (SubresourceRange{ 1, 1, 0, 1 }));
+		CHECK(overlapping.steps[2].before.size() == 2 && overlapping.steps[2].before[0].range == (SubresourceRange{ 2, 1, 0, 1 }));
+		CHECK(overlapping.steps[2].before[1].phase == BarrierPhase::Settled && overlapping.steps[2].before[1].after == ResourceAccess::UnorderedAccess);
+	}
+
+	// Reads of a resource in the same state share a level, a different read or a write goes one level further down,
+	// and steps that touch other resources stay as high up as their own uses let them.
+	void TestDependencyLevels()
+	{
+		auto levels = ComputeDependencyLevels(3, {
+			{ { 0, ResourceAccess::RenderTarget } },
+			{ { 1, ResourceAccess::RenderTarget } },
+			{ { 0, ResourceAccess::ShaderResource } },
+			{ { 0, ResourceAccess::ShaderResource } },
+			{ { 0, ResourceAccess::UnorderedAccess } },
+			{ { 1, ResourceAccess::ShaderResource }, { 2, ResourceAccess::RenderTarget } } });
+		CHECK((levels == std::vector<std::vector<std::size_t>>{ { 0, 1 }, { 2, 3, 5 }, { 4 } }));
+
+		levels = ComputeDependencyLevels(1, { { { 0, ResourceAccess::ShaderResource } }, { { 0, ResourceAccess::CopySource } }, { { 0, ResourceAccess::CopySource } } });
+		CHECK((levels == std::vector<std::vector<std::size_t>>{ { 0 }, { 1, 2 } }));
+	}
+
+	// Spins until done() holds, for at most a few seconds so a test that fails does not hang.
+	template<typename DoneType>
+	bool WaitUntil(DoneType&& done)
+	{
+		const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+		while (!done())
+		{
+			if (std::chrono::steady_clock::now() > deadline)
+				return false;
+			std::this_thread::yield();
+		}
+		return true;
+	}
+
+	// Every worker asked for runs the task exactly once per Run(), all of them at the same time, and a single worker
+	// runs it on the calling thread.
+	void TestWorkerPool()
+	{
+		WorkerPool workers(4);
+		CHECK(workers.WorkerCount() == 4);
+
+		std::atomic<std::size_t> missedRendezvous(0);
+		std::size_t wrongCalls = 0;
+		for (int round = 0; round < 50; ++round)
+		{
+			std::atomic<std::size_t> arrived(0);
+			std::atomic<std::size_t> calls[4] = {};
+			workers.Run(8, [&](const std::size_t worker)
+			{
+				calls[worker]++;
+				arrived++;
+				if (!WaitUntil([&arrived]() { return arrived == 4; }))
+					missedRendezvous++;
+			});
+			for (auto& count : calls)
+				wrongCalls += count != 1 ? 1 : 0;
+		}
+		CHECK(missedRendezvous == 0);
+		CHECK(wrongCalls == 0);
+
+		std::thread::id caller;
+		workers.Run(1, [&caller](const std::size_t) { caller = std::this_thread::get_id(); });
+		CHECK(caller == std::this_thread::get_id());
+	}
+
+	// Hands out a context per Begin() and keeps, in submission order, the passes recorded into each submitted context
+	// along with the fence of their submission, and the waits placed ahead of them.
+	class StubRecorder : public CommandRecorder
+	{
+	public:
+		struct RecordedWait
+		{
+			QueueType      queue;
+			std::uint64_t  fence;
+			std::size_t    submission; // Number of passes submitted before it.
+		};
+
+		CommandContext& Begin(const std::string&, const QueueType) override
+		{
+			_contexts.push_back(std::make_unique<CommandContext>());
+			_recorded.emplace_back();
+			return *_contexts.back();
+		}
+		std::uint64_t Finish(CommandContext& context) override
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			for (auto& name : _recorded[IndexOf(context)])
+			{
+				submitted.push_back(name);
+				fences.push_back(_fence + 1);
+			}
+			return ++_fence;
+		}
+		void Wait(const QueueType queue, const std::uint64_t fence) override
+		{
+			waits.push_back(RecordedWait{ queue, fence, submitted.size() });
+		}
+
+		// Called by the passes, from whichever worker records them.
+		void Record(CommandContext& context, const std::string& name)
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_recorded[IndexOf(context)].push_back(name);
+			recorded.push_back(name);
+		}
+
+		std::vector<std::string>    recorded;
+		std::vector<std::string>    submitted;
+		std::vector<std::uint64_t>  fences; // Parallel to submitted.
+		std::vector<RecordedWait>   waits;
+
+	protected:
+		std::size_t IndexOf(const CommandContext& context) const
+		{
+			std::size_t index = 0;
+			while (_contexts[index].get() != &context)
+				++index;
+			return index;
+		}
+
+		std::vector<std::unique_ptr<CommandContext>>  _contexts;
+		std::vector<std::vector<std::string>>         _recorded;
+		std::mutex                                    _mutex;
+		std::uint64_t                                 _fence = 0;
+	};
+
+	// P0 to P3 write resources of their own and form the first level, which the four workers record at once: P0 only
+	// finishes once the other three have. The batches are still submitted in timeline order, and P4, which reads all
+	// four, is recorded after them.
+	void TestParallelRecordingSubmitsInOrder()
+	{
+		FrameGraph framegraph;
+		framegraph.SetMaxPassesPerSubmission(1);
+		StubRecorder recorder;
+		std::atomic<std::size_t> finished(0);
+		bool overlapped = true;
+		struct Data
+		{
+
+		};
+
+		BenchmarkResource* resources[4] = {};
+		for (std::size_t i = 0; i < 4; ++i)
+		{
+			const auto name = "P" + std::to_string(i);
+			framegraph.AddRenderPass<Data>(name, [&resources, i](Data&, FrameGraphBuilder& builder)
+			{
+				resources[i] = builder.Create<BenchmarkResource>("R", BenchmarkTexture(4, 4, 4), ResourceAccess::RenderTarget);
+			}, [&, name, i](const Data&, CommandContext& context)
+			{
+				if (i == 0)
+					overlapped = WaitUntil([&finished]() { return finished == 3; });
+				recorder.Record(context, name);
+				finished++;
+			});
+		}
+		framegraph.AddRenderPass<Data>("P4", [&resources](Data&, FrameGraphBuilder& builder)
+		{
+			for (auto resource : resources)
+				builder.Read(resource, ResourceAccess::ShaderResource);
+		}, [&recorder](const Data&, CommandContext& context)
+		{
+			recorder.Record(context, "P4");
+		})->SetCullImmune(true);
+
+		framegraph.Compile();
+		WorkerPool workers(4);
+		framegraph.Execute(recorder, workers);
+
+		CHECK(overlapped);
+		CHECK(recorder.recorded.size() == 5 && recorder.recorded[3] == "P0" && recorder.recorded[4] == "P4");
+		CHECK((recorder.submitted == std::vector<std::string>{ "P0", "P1", "P2", "P3", "P4" }));
+		std::size_t threads = 0;
+		for (auto& timing : framegraph.StepTimings())
+			threads = std::max(threads, timing.thread + 1);
+		CHECK(threads == 4);
+	}
+
+	// P1 only dispatches compute work on A, so it goes to the compute queue, which waits for P0 first. P2 reads A after
+	// P1 and B after P0: one wait on the fence of P1 covers both, since P1 waited for P0 in turn.
+	void TestComputePassWaits()
+	{
+		FrameGraph framegraph;
+		StubRecorder recorder;
+		BenchmarkResource* a = nullptr;
+		BenchmarkResource* b = nullptr;
+		struct Data
+		{
+
+		};
+		const auto record = [&recorder](const char* name)
+		{
+			return [&recorder, name](const Data&, CommandContext& context) { recorder.Record(context, name); };
+		};
+		framegraph.AddRenderPass<Data>("P0", [&](Data&, FrameGraphBuilder& builder)
+		{
+			a = builder.Create<BenchmarkResource>("A", BenchmarkBuffer(64, 4), ResourceAccess::UnorderedAccess);
+			b = builder.Create<BenchmarkResource>("B", BenchmarkTexture(4, 4, 4), ResourceAccess::RenderTarget);
+		}, record("P0"));
+		framegraph.AddRenderPass<Data>("P1", [&](Data&, FrameGraphBuilder& builder)
+		{
+			builder.SetQueue(QueueType::Compute);
+			a = builder.Write(a, ResourceAccess::UnorderedAccess);
+		}, record("P1"));
+		framegraph.AddRenderPass<Data>("P2", [&](Data&, FrameGraphBuilder& builder)
+		{
+			builder.Read(a, ResourceAccess::ShaderResource);
+			builder.Read(b, ResourceAccess::ShaderResource);
+		}, record("P2"))->SetCullImmune(true);
+
+		framegraph.Compile();
+		const auto& queues = framegraph.Queues();
+		CHECK((queues.timelines[std::size_t(QueueType::Graphics)] == std::vector<std::size_t>{ 0, 2 }));
+		CHECK((queues.timelines[std::size_t(QueueType::Compute)] == std::vector<std::size_t>{ 1 }));
+		CHECK(queues.waits[0].empty());
+		CHECK(queues.waits[1].size() == 1 && queues.waits[1][0].queue == QueueType::Graphics && queues.waits[1][0].step == 0);
+		CHECK(queues.waits[2].size() == 1 && queues.waits[2][0].queue == QueueType::Compute && queues.waits[2][0].step == 1);
+		CHECK(queues.waitCount == 2);
+		CHECK(framegraph.BarrierCounts().emitted == 5);
+
+		framegraph.Execute(recorder);
+		CHECK((recorder.submitted == std::vector<std::string>{ "P0", "P1", "P2" }));
+		CHECK(recorder.waits.size() == 2);
+		CHECK(recorder.waits[0].queue == QueueType::Compute && recorder.waits[0].fence == recorder.fences[0] && recorder.waits[0].submission == 1);
+		CHECK(recorder.waits[1].queue == QueueType::Graphics && recorder.waits[1].fence == recorder.fences[1] && recorder.waits[1].submission == 2);
+	}
+
+	// Two chains declared interleaved, P0 -> P2 on X and P1 -> P3 on Y: run as declared both transients are alive at
+	// once, run chain by chain only one is. Reordering picks the latter and the compiled timeline follows it.
+	void TestMemoryAwareOrderLowersPeak()
+	{
+		const std::vector<DependencyEdge> edges = { { 0, 2, DependencyKind::ReadAfterWrite }, { 1, 3, DependencyKind::ReadAfterWrite } };
+		const std::vector<TransientUsers> transients = { { 100, { 0, 2 } }, { 100, { 1, 3 } } };
+		const std::vector<bool> excluded(4, false);
+		const auto order = MemoryAwareOrder(4, edges, excluded, transients);
+		CHECK((order == std::vector<std::size_t>{ 0, 2, 1, 3 }));
+		CHECK(PeakLiveBytes(4, TopologicalOrder(4, edges, excluded), transients) == 200);
+		CHECK(PeakLiveBytes(4, order, transients) == 100);
+
+		FrameGraph framegraph;
+		framegraph.SetReorderPasses(true);
+		StubRecorder recorder;
+		BenchmarkResource* x = nullptr;
+		BenchmarkResource* y = nullptr;
+		struct Data
+		{
+
+		};
+		const auto record = [&recorder](const char* name)
+		{
+			return [&recorder, name](const Data&, CommandContext& context) { recorder.Record(context, name); };
+		};
+		framegraph.AddRenderPass<Data>("P0", [&](Data&, FrameGraphBuilder& builder)
+		{
+			x = builder.Create<BenchmarkResource>("X", BenchmarkTexture(64, 64, 4), ResourceAccess::RenderTarget);
+		}, record("P0"));
+		framegraph.AddRenderPass<Data>("P1", [&](Data&, FrameGraphBuilder& builder)
+		{
+			y = builder.Create<BenchmarkResource>("Y", BenchmarkTexture(64, 64, 4), ResourceAccess::RenderTarget);
+		}, record("P1"));
+		framegraph.AddRenderPass<Data>("P2", [&](Data&, FrameGraphBuilder& builder)
+		{
+			builder.Read(x, ResourceAccess::ShaderResource);
+		}, record("P2"))->SetCullImmune(true);
+		framegraph.AddRenderPass<Data>("P3", [&](Data&, FrameGraphBuilder& builder)
+		{
+			builder.Read(y, ResourceAccess::ShaderResource);
+		}, record("P3"))->SetCullImmune(true);
+
+		framegraph.Compile();
+		framegraph.Execute(recorder);
+		CHECK(framegraph.PassOrder().scheduledPeak * 2 == framegraph.PassOrder().declarationPeak);
+		CHECK((recorder.submitted == std::vector<std::string>{ "P0", "P2", "P1", "P3" }));
+	}
+
+	// On random graphs the order holds every pass that is not excluded exactly once, puts every producer ahead of its
+	// consumers and comes out the same every time.
+	void TestMemoryAwareOrderRespectsDependencies()
+	{
+		std::mt19937 random(17);
+		std::size_t misordered = 0, incomplete = 0, nondeterministic = 0;
+		for (int graph = 0; graph < 200; ++graph)
+		{
+			const std::size_t passCount = 2 + random() % 40;
+			std::vector<bool> excluded(passCount);
+			for (std::size_t pass = 0; pass < passCount; ++pass)
+				excluded[pass] = random() % 8 == 0;
+			std::vector<DependencyEdge> edges;
+			for (std::size_t i = 0; i < passCount * 2; ++i)
+			{
+				const std::size_t from = random() % passCount;
+				const std::size_t to = random() % passCount;
+				if (from < to)
+					edges.push_back({ from, to, DependencyKind::ReadAfterWrite });
+			}
+			std::vector<TransientUsers> transients(passCount / 2);
+			for (auto& transient : transients)
+			{
+				transient.size = 1 + random() % 1000;
+				for (std::size_t pass = 0; pass < passCount; ++pass)
+					if (random() % 4 == 0)
+						transient.passes.push_back(pass);
+			}
+
+			const auto order = MemoryAwareOrder(passCount, edges, excluded, transients);
+			nondeterministic += order != MemoryAwareOrder(passCount, edges, excluded, transients) ? 1 : 0;
+
+			std::vector<std::size_t> positions(passCount, passCount);
+			for (std::size_t i = 0; i < order.size(); ++i)
+				positions[order[i]] = positions[order[i]] == passCount ? i : passCount + 1;
+			for (std::size_t pass = 0; pass < passCount; ++pass)
+				incomplete += excluded[pass] != (positions[pass] == passCount) || positions[pass] > passCount ? 1 : 0;
+			for (auto& edge : edges)
+				misordered += !excluded[edge.from] && !excluded[edge.to] && positions[edge.from] > positions[edge.to] ? 1 : 0;
+		}
+		CHECK(misordered == 0);
+		CHECK(incomplete == 0);
+		CHECK(nondeterministic == 0);
+	}
+
+	// P1 reads T and writes R while P2 reads the first version of R and writes T: each has to run before the other.
+	// Compilation rejects the graph, from the cache as well, and reports P1, P2 and the sink that depends on them.
+	void TestCyclicGraphIsRejected()
+	{
+		FrameGraph framegraph;
+		BenchmarkResource* r = nullptr;
+		BenchmarkResource* t = nullptr;
+		BenchmarkResource* firstR = nullptr;
+		AddBenchmarkPass(framegraph, "P0", [&](BenchmarkPassData&, FrameGraphBuilder& builder)
+		{
+			r = firstR = builder.Create<BenchmarkResource>("R", BenchmarkTexture(4, 4, 4));
+			t = builder.Create<BenchmarkResource>("T", BenchmarkTexture(4, 4, 4));
+		});
+		AddBenchmarkPass(framegraph, "P1", [&](BenchmarkPassData&, FrameGraphBuilder& builder)
+		{
+			builder.Read(t);
+			r = builder.Write(r);
+		});
+		AddBenchmarkPass(framegraph, "P2", [&](BenchmarkPassData&, FrameGraphBuilder& builder)
+		{
+			builder.Read(firstR);
+			t = builder.Write(t);
+		});
+		AddBenchmarkPass(framegraph, "Sink", [&](BenchmarkPassData&, FrameGraphBuilder& builder)
+		{
+			builder.Read(r);
+			builder.Read(t);
+		})->SetCullImmune(true);
+
+		CHECK(!framegraph.Compile());
+		CHECK((framegraph.CyclicPasses() == std::vector<std::size_t>{ 1, 2, 3 }));
+		CHECK(!framegraph.Compile());
+		CHECK(framegraph.CompileCacheHits() == 1);
+		CHECK((framegraph.CyclicPasses() == std::vector<std::size_t>{ 1, 2, 3 }));
+
+		NullCommandRecorder recorder;
+		framegraph.Execute(recorder);
+		CHECK(recorder.Begun() == 0 && framegraph.StepTimings().empty());
+		CHECK(framegraph.SubmissionsPerFrame() == 0);
+
+		framegraph.Clear();
+		AddBenchmarkPass(framegraph, "Sink", [](BenchmarkPassData&, FrameGraphBuilder& builder)
+		{
+			builder.Create<BenchmarkResource>("R", BenchmarkTexture(4, 4, 4));
+		})->SetCullImmune(true);
+		CHECK(framegraph.Compile());
+		CHECK(framegraph.CyclicPasses().empty());
+	}
+}
+
+int main()
+{
+	TestSteadyStateSetupDoesNotAllocate("Deferred 1080p", [](FrameGraph& framegraph) { DeclareBenchmarkDeferredFrame(framegraph, 1920, 1080); });
+	TestSteadyStateSetupDoesNotAllocate("Post chain 1440p", [](FrameGraph& framegraph) { DeclareBenchmarkPostProcessingFrame(framegraph, 2560, 1440); });
+	TestSteadyStateSetupDoesNotAllocate("Random 256", [](FrameGraph& framegraph) { DeclareBenchmarkRandomFrame(framegraph, 256, 2); });
+	TestCyclicGraphIsRejected();
+	TestTransientPoolReuse();
+	TestTransientAliasingPlacement();
+	TestTransientAliasingHeapCap();
+	TestPlacedTransients();
+	TestPlanBarriersTransitions();
+	TestPlanBarriersSplit();
+	TestPlanBarriersQueueHandoff();
+	TestSplitBarriersStayInTheirBatch();
+	TestSubresourceIndexing();
+	TestMipChainBarriers();
+	TestDependencyLevels();
+	TestWorkerPool();
+	TestParallelRecordingSubmitsInOrder();
+	TestComputePassWaits();
+	TestMemoryAwareOrderLowersPeak();
+	TestMemoryAwareOrderRespectsDependencies();
+	return CheckFailures();
+}
@@ -0,0 +1,225 @@
+// Turns pages over from 1 to 32 threads at once, each with a LinearAllocator of its own as a command context would
+// have, and for comparison through the page manager it replaced, which took its mutex on every request and discard.
+// Prints the time per thread count, the pages created and the pages found handed to two threads at once as
+// comma-separated values. Built against Tests/Stubs, so nothing touches a GPU.
+//
+//     LinearAllocatorBenchmark [--frames N]
+//
+// Every frame of a thread allocates a few whole pages and retires them with the next fence. The simulated GPU keeps
+// 64 fences behind the last one handed out, and a frame thread recycles the retired pages every 200 microseconds as
+// the frame loop would call LinearAllocator::ProcessRetiredPages(); the page managers recycle in between when they run
+// out. The previous page manager hands its pages out directly, without the bookkeeping of LinearAllocator::Allocate(),
+// which flatters it a little; the difference that matters is how the times grow with the threads, given as many cores.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include "LinearAllocator.h"
+#include "CommandListManager.h"
+
+namespace
+{
+	constexpr int kPagesPerFrame = 2;
+	constexpr uint64_t kFencesInFlight = 64;
+
+	// What LinearAllocatorPageManager did before, for the fixed size pages: queues guarded by one mutex, the fences
+	// checked when nothing is available.
+	class MutexPageManager
+	{
+	public:
+		LinearAllocationPage* RequestPage()
+		{
+			std::lock_guard<std::mutex> lockGuard(m_mutex);
+			if (m_availablePages.empty())
+				RecycleRetiredPages();
+			if (!m_availablePages.empty())
+			{
+				LinearAllocationPage* page = m_availablePages.front();
+				m_availablePages.pop();
+				return page;
+			}
+			D3D12_RESOURCE_DESC desc = {};
+			desc.Width = kGpuAllocatorPageSize;
+			m_pagePool.emplace_back(new LinearAllocationPage(new ID3D12Resource(desc), D3D12_RESOURCE_STATE_UNORDERED_ACCESS));
+			return m_pagePool.back().get();
+		}
+
+		void DiscardPages(uint64_t fence, const std::vector<LinearAllocationPage*>& pages)
+		{
+			std::lock_guard<std::mutex> lockGuard(m_mutex);
+			for (auto page : pages)
+				m_retiredPages.emplace(fence, page);
+		}
+
+		void ProcessRetiredPages()
+		{
+			std::lock_guard<std::mutex> lockGuard(m_mutex);
+			RecycleRetiredPages();
+		}
+
+	private:
+		void RecycleRetiredPages()
+		{
+			while (!m_retiredPages.empty() && Graphics::g_CommandManager.IsFenceComplete(m_retiredPages.front().first))
+			{
+				m_availablePages.push(m_retiredPages.front().second);
+				m_retiredPages.pop();
+			}
+		}
+
+		std::vector<std::unique_ptr<LinearAllocationPage>> m_pagePool;
+		std::queue<std::pair<uint64_t, LinearAllocationPage*>> m_retiredPages;
+		std::queue<LinearAllocationPage*> m_availablePages;
+		std::mutex m_mutex;
+	};
+
+	class MutexPageContext
+	{
+	public:
+		explicit MutexPageContext(MutexPageManager& manager) : m_manager(manager) {}
+
+		void* AllocatePage()
+		{
+			m_pages.push_back(m_manager.RequestPage());
+			return m_pages.back()->m_CpuVirtualAddress;
+		}
+
+		void Retire(uint64_t fence)
+		{
+			m_manager.DiscardPages(fence, m_pages);
+			m_pages.clear();
+		}
+
+	private:
+		MutexPageManager& m_manager;
+		std::vector<LinearAllocationPage*> m_pages;
+	};
+
+	class LinearAllocatorContext
+	{
+	public:
+		void* AllocatePage() { return m_allocator.Allocate(kGpuAllocatorPageSize).DataPtr; }
+		void Retire(uint64_t fence) { m_allocator.CleanupUsedPages(fence); }
+
+	private:
+		LinearAllocator m_allocator{ kGpuExclusive };
+	};
+
+	struct Result
+	{
+		double seconds = 0.0;
+		uint64_t pagesCreated = 0;
+		size_t conflicts = 0;   // Pages that another thread tagged while this one still held them
+	};
+
+	// Each thread tags the pages it gets with its index and checks the tags just before retiring them.
+	template<typename ContextFactory, typename ProcessType>
+	Result Run(const int threadCount, const int frames, ContextFactory&& makeContext, ProcessType&& processRetiredPages)
+	{
+		Result result;
+		std::atomic<size_t> conflicts{ 0 };
+		std::atomic<bool> done{ false };
+		const uint64_t created = g_CreatedStubResources.load();
+
+		std::thread frameLoop([&]()
+		{
+			while (!done)
+			{
+				processRetiredPages();
+				std::this_thread::sleep_for(std::chrono::microseconds(200));
+			}
+		});
+
+		const auto start = std::chrono::steady_clock::now();
+		std::vector<std::thread> threads;
+		for (int index = 0; index < threadCount; ++index)
+		{
+			threads.emplace_back([&, index]()
+			{
+				auto context = makeContext();
+				uint64_t* pages[kPagesPerFrame];
+				for (int frame = 0; frame < frames; ++frame)
+				{
+					for (auto& page : pages)
+					{
+						page = static_cast<uint64_t*>(context.AllocatePage());
+						*page = uint64_t(index);
+					}
+					for (auto page : pages)
+						conflicts += *page != uint64_t(index) ? 1 : 0;
+					const uint64_t fence = g_NextStubFence++;
+					context.Retire(fence);
+					if (fence > kFencesInFlight)
+					{
+						uint64_t completed = g_CompletedStubFence.load();
+						while (completed < fence - kFencesInFlight && !g_CompletedStubFence.compare_exchange_weak(completed, fence - kFencesInFlight))
+						{
+						}
+					}
+				}
+			});
+		}
+		for (auto& thread : threads)
+			thread.join();
+		result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		done = true;
+		frameLoop.join();
+		result.pagesCreated = g_CreatedStubResources.load() - created;
+		result.conflicts = conflicts;
+		return result;
+	}
+
+	Result RunLinearAllocator(const int threadCount, const int frames)
+	{
+		const Result result = Run(threadCount, frames, []() { return LinearAllocatorContext(); },
+			[]() { LinearAllocator::ProcessRetiredPages(); });
+		LinearAllocator::DestroyAll();
+		return result;
+	}
+
+	Result RunMutexPageManager(const int threadCount, const int frames)
+	{
+		MutexPageManager manager;
+		return Run(threadCount, frames, [&]() { return MutexPageContext(manager); },
+			[&]() { manager.ProcessRetiredPages(); });
+	}
+}
+
+int main(int argc, char** argv)
+{
+	int frames = 20000;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+			frames = std::atoi(argv[++i]);
+		else
+		{
+			std::cerr << "usage: " << argv[0] << " [--frames N]\n";
+			return 1;
+		}
+	}
+
+	size_t conflicts = 0;
+	std::cout << "page_manager,threads,frames_per_thread,ms,pages_created,conflicts\n";
+	for (int threadCount : { 1, 2, 4, 8, 16, 32 })
+	{
+		const auto print = [&](const char* name, const Result& result)
+		{
+			std::cout << name << ',' << threadCount << ',' << frames << ',' << result.seconds * 1000.0 << ','
+				<< result.pagesCreated << ',' << result.conflicts << '\n';
+			conflicts += result.conflicts;
+		};
+		print("mutex", RunMutexPageManager(threadCount, frames));
+		print("magazines", RunLinearAllocator(threadCount, frames));
+	}
+	return conflicts == 0 ? 0 : 1;
+}
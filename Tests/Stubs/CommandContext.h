@@ -0,0 +1,11 @@
+#pragma once
+
+#include "GpuBuffer.h"
+
+class CommandContext
+{
+public:
+	static void InitializeBuffer(ByteAddressBuffer&, const void*, size_t, size_t = 0)
+	{
+	}
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "pch.h"
+
+#include <thread>
+
+// A simulated graphics queue: tests hand out fences with g_NextStubFence and complete them by advancing
+// g_CompletedStubFence, from any thread.
+inline std::atomic<uint64_t> g_NextStubFence{ 1 };
+inline std::atomic<uint64_t> g_CompletedStubFence{ 0 };
+
+class CommandQueue
+{
+public:
+	uint64_t GetNextFenceValue()
+	{
+		return g_NextStubFence.load();
+	}
+};
+
+class CommandListManager
+{
+public:
+	CommandQueue& GetGraphicsQueue()
+	{
+		return m_GraphicsQueue;
+	}
+	bool IsFenceComplete(uint64_t FenceValue)
+	{
+		return FenceValue <= g_CompletedStubFence.load();
+	}
+	void WaitForFence(uint64_t FenceValue)
+	{
+		while (!IsFenceComplete(FenceValue))
+			std::this_thread::yield();
+	}
+
+private:
+	CommandQueue m_GraphicsQueue;
+};
+
+namespace Graphics
+{
+	inline CommandListManager g_CommandManager;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <functional>
+#include <string>
+
+#include "AllocatorStats.h"
+
+// Nothing displays the registered allocators.
+namespace EngineProfiling
+{
+	inline void RegisterAllocator(const void*, const std::wstring&, std::function<AllocatorStats()>)
+	{
+	}
+	inline void UnregisterAllocator(const void*)
+	{
+	}
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// A tunable that keeps its default value; there is no debug menu to change it from.
+class IntVar
+{
+public:
+	IntVar(const std::string&, int32_t val, int32_t = 0, int32_t = (1 << 24) - 1, int32_t = 1) : m_Value(val)
+	{
+	}
+	operator int32_t() const { return m_Value; }
+
+private:
+	int32_t m_Value;
+};
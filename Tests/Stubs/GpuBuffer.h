@@ -0,0 +1,23 @@
+#pragma once
+
+#include "pch.h"
+
+// Counts the buffers created and not yet destroyed, so tests can check that placed blocks release theirs.
+inline std::atomic<int> g_LiveStubBuffers{ 0 };
+
+class ByteAddressBuffer
+{
+public:
+	void Create(const std::wstring&, uint32_t, uint32_t, const void* = nullptr)
+	{
+		++g_LiveStubBuffers;
+	}
+	void CreatePlaced(const std::wstring&, ID3D12Heap*, uint32_t, uint32_t, uint32_t, const void* = nullptr)
+	{
+		++g_LiveStubBuffers;
+	}
+	void Destroy()
+	{
+		--g_LiveStubBuffers;
+	}
+};
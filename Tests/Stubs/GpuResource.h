@@ -0,0 +1,15 @@
+#pragma once
+
+#include "pch.h"
+
+class GpuResource
+{
+public:
+	ID3D12Resource* GetResource() { return m_pResource.Get(); }
+	const ID3D12Resource* GetResource() const { return m_pResource.Get(); }
+
+protected:
+	Microsoft::WRL::ComPtr<ID3D12Resource> m_pResource;
+	D3D12_RESOURCE_STATES m_UsageState = D3D12_RESOURCE_STATE_COMMON;
+	D3D12_GPU_VIRTUAL_ADDRESS m_GpuVirtualAddress = 0;
+};
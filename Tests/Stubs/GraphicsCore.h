@@ -0,0 +1,25 @@
+#pragma once
+
+#include "pch.h"
+
+class StubDevice
+{
+public:
+	HRESULT CreateHeap(const D3D12_HEAP_DESC*, ID3D12Heap** heap)
+	{
+		*heap = new ID3D12Heap;
+		return 0;
+	}
+	HRESULT CreateCommittedResource(const D3D12_HEAP_PROPERTIES*, D3D12_HEAP_FLAGS, const D3D12_RESOURCE_DESC* desc,
+		D3D12_RESOURCE_STATES, const void*, ID3D12Resource** resource)
+	{
+		*resource = new ID3D12Resource(*desc);
+		return 0;
+	}
+};
+
+namespace Graphics
+{
+	inline StubDevice g_StubDevice;
+	inline StubDevice* g_Device = &g_StubDevice;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+// The MSVC bit scans on compilers that have no <intrin.h>; only added to the include path there.
+
+inline unsigned char _BitScanReverse64(unsigned long* index, unsigned long long mask)
+{
+	if (mask == 0)
+		return 0;
+	*index = 63 - __builtin_clzll(mask);
+	return 1;
+}
+
+inline unsigned char _BitScanForward64(unsigned long* index, unsigned long long mask)
+{
+	if (mask == 0)
+		return 0;
+	*index = __builtin_ctzll(mask);
+	return 1;
+}
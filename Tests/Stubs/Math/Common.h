@@ -0,0 +1,38 @@
+#pragma once
+
+// The helpers of Core/Math/Common.h that the allocators use, without DirectXMath.
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Math
+{
+	template <typename T> inline T AlignUpWithMask(T value, size_t mask)
+	{
+		return (T)(((size_t)value + mask) & ~mask);
+	}
+
+	template <typename T> inline T AlignUp(T value, size_t alignment)
+	{
+		return AlignUpWithMask(value, alignment - 1);
+	}
+
+	template <typename T> inline bool IsPowerOfTwo(T value)
+	{
+		return 0 == (value & (value - 1));
+	}
+
+	template <typename T> inline bool IsDivisible(T value, T divisor)
+	{
+		return (value / divisor) * divisor == value;
+	}
+
+	// Rounds fractions up, like the original.
+	inline uint8_t Log2(uint64_t value)
+	{
+		uint8_t log = 0;
+		while (log < 63 && (uint64_t(1) << log) < value)
+			++log;
+		return log;
+	}
+}
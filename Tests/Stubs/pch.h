@@ -0,0 +1,198 @@
+#pragma once
+
+// Stand-ins for the parts of the Windows and D3D12 headers that the engine sources built by Tests/CMakeLists.txt use.
+// Only what those sources call is here; the GPU objects do nothing.
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Math/Common.h"
+
+typedef unsigned int UINT;
+typedef long HRESULT;
+typedef uint64_t D3D12_GPU_VIRTUAL_ADDRESS;
+
+#define ASSERT(condition, ...) assert(condition)
+// Like the engine's, evaluates the call in release builds too.
+#define ASSERT_SUCCEEDED(hr, ...) do { const HRESULT result_ = (hr); assert(result_ >= 0); (void)result_; } while (0)
+#define MY_IID_PPV_ARGS(pointer) pointer
+
+struct ID3D12Heap
+{
+	void Release() { delete this; }
+};
+
+enum D3D12_HEAP_TYPE
+{
+	D3D12_HEAP_TYPE_DEFAULT = 1,
+	D3D12_HEAP_TYPE_UPLOAD = 2,
+};
+
+enum D3D12_HEAP_FLAGS
+{
+	D3D12_HEAP_FLAG_NONE = 0,
+	D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS = 0xc0,
+};
+
+enum D3D12_CPU_PAGE_PROPERTY
+{
+	D3D12_CPU_PAGE_PROPERTY_UNKNOWN = 0,
+};
+
+enum D3D12_MEMORY_POOL
+{
+	D3D12_MEMORY_POOL_UNKNOWN = 0,
+};
+
+struct D3D12_HEAP_PROPERTIES
+{
+	D3D12_HEAP_TYPE Type;
+	D3D12_CPU_PAGE_PROPERTY CPUPageProperty;
+	D3D12_MEMORY_POOL MemoryPoolPreference;
+	UINT CreationNodeMask;
+	UINT VisibleNodeMask;
+};
+
+struct D3D12_HEAP_DESC
+{
+	uint64_t SizeInBytes;
+	D3D12_HEAP_PROPERTIES Properties;
+	uint64_t Alignment;
+	D3D12_HEAP_FLAGS Flags;
+};
+
+inline D3D12_HEAP_PROPERTIES CD3DX12_HEAP_PROPERTIES(const D3D12_HEAP_TYPE type)
+{
+	return D3D12_HEAP_PROPERTIES{ type, D3D12_CPU_PAGE_PROPERTY_UNKNOWN, D3D12_MEMORY_POOL_UNKNOWN, 1, 1 };
+}
+
+#define D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT 65536
+
+enum D3D12_RESOURCE_DIMENSION
+{
+	D3D12_RESOURCE_DIMENSION_BUFFER = 1,
+};
+
+enum DXGI_FORMAT
+{
+	DXGI_FORMAT_UNKNOWN = 0,
+};
+
+enum D3D12_TEXTURE_LAYOUT
+{
+	D3D12_TEXTURE_LAYOUT_ROW_MAJOR = 1,
+};
+
+enum D3D12_RESOURCE_FLAGS
+{
+	D3D12_RESOURCE_FLAG_NONE = 0,
+	D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS = 0x4,
+};
+
+enum D3D12_RESOURCE_STATES
+{
+	D3D12_RESOURCE_STATE_COMMON = 0,
+	D3D12_RESOURCE_STATE_UNORDERED_ACCESS = 0x8,
+	D3D12_RESOURCE_STATE_GENERIC_READ = 0xac3,
+};
+
+struct DXGI_SAMPLE_DESC
+{
+	UINT Count;
+	UINT Quality;
+};
+
+struct D3D12_RESOURCE_DESC
+{
+	D3D12_RESOURCE_DIMENSION Dimension;
+	uint64_t Alignment;
+	uint64_t Width;
+	UINT Height;
+	uint16_t DepthOrArraySize;
+	uint16_t MipLevels;
+	DXGI_FORMAT Format;
+	DXGI_SAMPLE_DESC SampleDesc;
+	D3D12_TEXTURE_LAYOUT Layout;
+	D3D12_RESOURCE_FLAGS Flags;
+};
+
+// Counts the resources created and not yet released. Mapping one gives a few bytes of its own, enough for tests to
+// tag what they were handed.
+inline std::atomic<int> g_LiveStubResources{ 0 };
+inline std::atomic<uint64_t> g_CreatedStubResources{ 0 };
+
+struct ID3D12Resource
+{
+	explicit ID3D12Resource(const D3D12_RESOURCE_DESC& desc) : m_Desc(desc)
+	{
+		++g_LiveStubResources;
+		++g_CreatedStubResources;
+	}
+	~ID3D12Resource()
+	{
+		--g_LiveStubResources;
+	}
+
+	void Release() { delete this; }
+	void SetName(const wchar_t*) {}
+	D3D12_RESOURCE_DESC GetDesc() const { return m_Desc; }
+	D3D12_GPU_VIRTUAL_ADDRESS GetGPUVirtualAddress() const { return D3D12_GPU_VIRTUAL_ADDRESS(this); }
+	HRESULT Map(UINT, const void*, void** data)
+	{
+		*data = m_Contents;
+		return 0;
+	}
+	void Unmap(UINT, const void*) {}
+
+	D3D12_RESOURCE_DESC m_Desc;
+	uint64_t m_Contents[4] = {};
+};
+
+namespace Microsoft
+{
+	namespace WRL
+	{
+		// Owns one reference, which is all the stub objects have.
+		template <typename T> class ComPtr
+		{
+		public:
+			ComPtr() = default;
+			ComPtr(const ComPtr&) = delete;
+			ComPtr& operator=(const ComPtr&) = delete;
+			~ComPtr() { Reset(); }
+
+			ComPtr& operator=(std::nullptr_t)
+			{
+				Reset();
+				return *this;
+			}
+
+			void Attach(T* pointer)
+			{
+				Reset();
+				m_Pointer = pointer;
+			}
+			void Reset()
+			{
+				if (m_Pointer != nullptr)
+					m_Pointer->Release();
+				m_Pointer = nullptr;
+			}
+			T* Get() const { return m_Pointer; }
+			T* operator->() const { return m_Pointer; }
+
+		private:
+			T* m_Pointer = nullptr;
+		};
+	}
+}
+
+#include "EngineTuning.h"
+#include "EngineProfiling.h"
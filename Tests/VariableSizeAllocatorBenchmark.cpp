@@ -0,0 +1,147 @@
+// Replays allocation traces through both backends of VariableSizeAllocationsManager and prints the time per operation,
+// the heap allocations once warm and the failed allocations as comma-separated values.
+//
+//     VariableSizeAllocatorBenchmark [--frames N]
+//
+// The traces are generated, as nothing records them in the renderer yet, after the two kinds of users: descriptor
+// heaps handing out ranges of 1 to 16 descriptors, short-lived around a few long-lived ones, and buffer sub-allocation
+// of 256 byte aligned constant and vertex data mixed with 64 KB aligned blocks of 64 KB to 2 MB.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "AllocationCounter.hpp"
+#include "VariableSizeAllocationsManager.hpp"
+
+using namespace LearnRenderer;
+
+namespace
+{
+	using BackendType = VariableSizeAllocationsManager::BackendType;
+
+	struct TraceOperation
+	{
+		bool allocate;
+		uint32_t id;
+		size_t size;
+		size_t alignment;
+	};
+
+	struct Trace
+	{
+		const char* name;
+		size_t heapSize;
+		uint32_t allocationCount = 0;
+		std::vector<TraceOperation> operations;
+	};
+
+	// Each frame allocates allocationsPerFrame blocks, then frees random live ones until at most maxLive are left.
+	template<typename DescribeType>
+	Trace GenerateTrace(const char* name, const size_t heapSize, const size_t frames, const int allocationsPerFrame, const size_t maxLive, DescribeType&& describe)
+	{
+		Trace trace{ name, heapSize };
+		std::mt19937 random(7);
+		std::vector<uint32_t> live;
+		for (size_t frame = 0; frame < frames; ++frame)
+		{
+			for (int i = 0; i < allocationsPerFrame; ++i)
+			{
+				const auto id = trace.allocationCount++;
+				const auto block = describe(random);
+				trace.operations.push_back({ true, id, block.first, block.second });
+				live.push_back(id);
+			}
+			while (live.size() > maxLive)
+			{
+				const size_t index = random() % live.size();
+				trace.operations.push_back({ false, live[index], 0, 0 });
+				live[index] = live.back();
+				live.pop_back();
+			}
+		}
+		for (auto id : live)
+			trace.operations.push_back({ false, id, 0, 0 });
+		return trace;
+	}
+
+	Trace DescriptorTrace(const size_t frames)
+	{
+		return GenerateTrace("descriptors", 4096, frames, 200, 250, [](std::mt19937& random)
+		{
+			return std::make_pair(size_t(1 + random() % 16), size_t(1));
+		});
+	}
+
+	Trace BufferTrace(const size_t frames)
+	{
+		return GenerateTrace("buffers", size_t(256) << 20, frames, 100, 400, [](std::mt19937& random)
+		{
+			if (random() % 10 == 0)
+				return std::make_pair((size_t(1) << (16 + random() % 6)) + random() % 65536, size_t(65536));
+			return std::make_pair(size_t(256) * (1 + random() % 64), size_t(256));
+		});
+	}
+
+	// The best of several passes over the trace. The first pass warms up: the TLSF backend grows its tables to the
+	// trace's peak there, so the heap allocations are counted from the second pass on.
+	void Replay(std::ostream& stream, const Trace& trace, const BackendType backend)
+	{
+		constexpr int kPasses = 6;
+
+		VariableSizeAllocationsManager manager(trace.heapSize, backend);
+		std::vector<VariableSizeAllocationsManager::Allocation> allocations(trace.allocationCount);
+		size_t failures = 0, heapAllocations = 0;
+		double best = 0.0;
+		for (int pass = 0; pass < kPasses; ++pass)
+		{
+			const auto allocationCount = AllocationCount();
+			const auto start = std::chrono::steady_clock::now();
+			for (auto& operation : trace.operations)
+			{
+				auto& allocation = allocations[operation.id];
+				if (operation.allocate)
+				{
+					allocation = manager.Allocate(operation.size, operation.alignment);
+					failures += allocation.IsValid() ? 0 : 1;
+				}
+				else if (allocation.IsValid())
+					manager.Free(std::move(allocation));
+			}
+			const auto milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			best = pass == 0 ? milliseconds : std::min(best, milliseconds);
+			if (pass > 0)
+				heapAllocations += AllocationCount() - allocationCount;
+		}
+
+		stream << trace.name << ',' << (backend == BackendType::TLSF ? "tlsf" : "ordered_maps") << ',' << trace.operations.size() << ','
+			<< best * 1e6 / trace.operations.size() << ',' << heapAllocations / (kPasses - 1) << ',' << failures / kPasses << '\n';
+	}
+}
+
+int main(int argc, char** argv)
+{
+	size_t frames = 2000;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+			frames = size_t(std::strtoull(argv[++i], nullptr, 10));
+		else
+		{
+			std::cerr << "usage: " << argv[0] << " [--frames N]\n";
+			return 1;
+		}
+	}
+
+	std::cout << "trace,backend,ops,ns_per_op,heap_allocations_per_pass,failures_per_pass\n";
+	for (const auto& trace : { DescriptorTrace(frames), BufferTrace(frames) })
+	{
+		Replay(std::cout, trace, BackendType::OrderedMaps);
+		Replay(std::cout, trace, BackendType::TLSF);
+	}
+	return 0;
+}
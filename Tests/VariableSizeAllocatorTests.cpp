@@ -0,0 +1,224 @@
+// Tests of VariableSizeGPUAllocationsManager on both backends.
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "Check.hpp"
+#include "VariableSizeGPUAllocationsManager.hpp"
+
+using namespace LearnRenderer;
+
+namespace
+{
+	using GPUAllocationsManager = VariableSizeGPUAllocationsManager;
+
+	// The graphics, compute and copy queues each complete 0 to 3 of their fences per frame, independently of each
+	// other, and every freed block waits on a random subset of them. A block must come back in the release after all
+	// of its queues passed its fences and not before, and nothing still pending may be handed out again. Blocks
+	// allocated together are mostly freed together, so the batched release has adjacent blocks to coalesce.
+	void TestInterleavedQueueCompletion(const GPUAllocationsManager::BackendType backend)
+	{
+		constexpr uint32_t MaxQueues = GPUAllocationsManager::MaxQueues;
+		const uint32_t queues[] = { 0, 2, 3 }; // Indexed like D3D12_COMMAND_LIST_TYPE
+
+		GPUAllocationsManager manager(1 << 20, backend);
+		std::mt19937 random(11);
+
+		// Fence values carry their queue in the top byte, as CommandListManager hands them out.
+		uint64_t nextFences[MaxQueues], completedFences[MaxQueues];
+		for (uint32_t queue = 0; queue < MaxQueues; ++queue)
+		{
+			nextFences[queue] = (uint64_t(queue) << 56) | 1;
+			completedFences[queue] = uint64_t(queue) << 56;
+		}
+
+		struct PendingBlock
+		{
+			size_t offset;
+			size_t size;
+			uint32_t queueMask;
+			uint64_t fences[MaxQueues];
+		};
+		std::vector<PendingBlock> pending, stillPending;
+		std::vector<GPUAllocationsManager::Allocation> live;
+		size_t earlyReleases = 0, lateReleases = 0, reusedWhilePending = 0;
+
+		for (int frame = 0; frame < 3000; ++frame)
+		{
+			for (int i = 0; i < 20; ++i)
+			{
+				auto allocation = manager.Allocate(16 + random() % 2000, 16);
+				if (allocation.IsValid())
+					live.push_back(std::move(allocation));
+			}
+			for (int i = 0; i < 18 && !live.empty(); ++i)
+			{
+				const size_t index = random() % 4 == 0 ? random() % live.size() : live.size() - 1;
+				PendingBlock block{ live[index].UnalignedOffset, live[index].Size, 0, {} };
+				while (block.queueMask == 0)
+				{
+					for (auto queue : queues)
+						block.queueMask |= random() % 2 ? 1u << queue : 0u;
+				}
+				for (auto queue : queues)
+					block.fences[queue] = block.queueMask & (1u << queue) ? nextFences[queue] : 0;
+				pending.push_back(block);
+				manager.Free(std::move(live[index]), block.queueMask, block.fences);
+				live[index] = std::move(live.back());
+				live.pop_back();
+			}
+			for (auto queue : queues)
+			{
+				++nextFences[queue];
+				completedFences[queue] = std::min<uint64_t>(completedFences[queue] + random() % 4, nextFences[queue] - 1);
+			}
+
+			const size_t freeSize = manager.GetFreeSize(), staleSize = manager.GetStaleAllocationsSize();
+			manager.ReleaseStaleAllocations(completedFences);
+
+			size_t releasedSize = 0;
+			stillPending.clear();
+			for (auto& block : pending)
+			{
+				bool complete = true;
+				for (auto queue : queues)
+					complete &= !(block.queueMask & (1u << queue)) || block.fences[queue] <= completedFences[queue];
+				if (complete)
+					releasedSize += block.size;
+				else
+					stillPending.push_back(block);
+			}
+			pending.swap(stillPending);
+			earlyReleases += manager.GetFreeSize() - freeSize > releasedSize ? 1 : 0;
+			lateReleases += manager.GetFreeSize() - freeSize < releasedSize ? 1 : 0;
+			CHECK(staleSize - manager.GetStaleAllocationsSize() == releasedSize);
+
+			for (int i = 0; i < 4; ++i)
+			{
+				auto allocation = manager.Allocate(16 + random() % 500, 16);
+				if (!allocation.IsValid())
+					continue;
+				for (auto& block : pending)
+				{
+					if (allocation.UnalignedOffset < block.offset + block.size && block.offset < allocation.UnalignedOffset + allocation.Size)
+						++reusedWhilePending;
+				}
+				live.push_back(std::move(allocation));
+			}
+		}
+		std::printf("%s: %zu blocks pending at the end of 3000 frames\n", backend == GPUAllocationsManager::BackendType::TLSF ? "TLSF" : "Ordered maps", pending.size());
+		CHECK(earlyReleases == 0);
+		CHECK(lateReleases == 0);
+		CHECK(reusedWhilePending == 0);
+
+		// The single-fence overloads derive the queue from the fence value.
+		manager.ReleaseStaleAllocations(nextFences);
+		CHECK(manager.GetStaleAllocationsSize() == 0);
+		for (auto& allocation : live)
+			manager.Free(std::move(allocation), nextFences[0]);
+		manager.ReleaseStaleAllocations(nextFences[0] - 1);
+		CHECK(manager.GetStaleAllocationsSize() != 0);
+		manager.ReleaseStaleAllocations(nextFences[0]);
+
+		// Everything is back as one free block, and every allocation was freed exactly once.
+		CHECK(manager.IsEmpty());
+		CHECK(manager.GetStaleAllocationsSize() == 0);
+		CHECK(manager.GetNumFreeBlocks() == 1);
+		const AllocatorStats stats = manager.GetStats();
+		CHECK(stats.AllocationCount == stats.FreeCount);
+		CHECK(stats.PaddingSize == 0);
+	}
+
+	// Fills the space with blocks of random sizes, frees two thirds of them at random and then compacts the rest a
+	// budget at a time, the moved-out blocks coming back two frames later. Every move copies into a block below its
+	// source, no destination overlaps the source of a move of the same frame, the data of every block survives the
+	// copies, and the largest free block grows until nothing moves anymore.
+	void TestDefragmentation(const GPUAllocationsManager::BackendType backend)
+	{
+		constexpr size_t SpaceSize = 1 << 20, Alignment = 16;
+		GPUAllocationsManager manager(SpaceSize, backend);
+		std::mt19937 random(23);
+
+		// The allocation each byte of the space belongs to, standing in for its contents.
+		std::vector<uint32_t> memory(SpaceSize, 0);
+		std::vector<GPUAllocationsManager::Allocation> live;
+		std::vector<uint32_t> ids;
+		for (uint32_t id = 1;; ++id)
+		{
+			auto allocation = manager.Allocate(16 * (1 + random() % 64), Alignment);
+			if (!allocation.IsValid())
+				break;
+			live.push_back(std::move(allocation));
+			ids.push_back(id);
+		}
+		for (size_t i = 0; i < live.size(); )
+		{
+			if (random() % 3 != 0)
+			{
+				manager.Free(std::move(live[i]), 0);
+				live[i] = std::move(live.back());
+				live.pop_back();
+				ids[i] = ids.back();
+				ids.pop_back();
+			}
+			else
+				++i;
+		}
+		manager.ReleaseStaleAllocations(0);
+		for (size_t i = 0; i < live.size(); ++i)
+			std::fill(memory.begin() + live[i].UnalignedOffset, memory.begin() + live[i].UnalignedOffset + live[i].Size, ids[i]);
+
+		const auto initialLargest = manager.GetLargestFreeBlockSize();
+		const auto freeSize = manager.GetFreeSize();
+		auto largest = initialLargest;
+		size_t upwards = 0, overlapping = 0, corrupted = 0, shrinking = 0, frames = 0;
+		std::vector<GPUAllocationsManager::DefragmentationMove> moves;
+		for (uint64_t frame = 1; frame < 1000; ++frame)
+		{
+			const auto bytesMoved = manager.PlanDefragmentation(live.data(), live.size(), Alignment, 16 << 10, frame, moves);
+			for (size_t i = 0; i < moves.size(); ++i)
+			{
+				upwards += moves[i].DstOffset + moves[i].Size > moves[i].SrcOffset ? 1 : 0;
+				for (size_t j = 0; j < moves.size(); ++j)
+					overlapping += moves[i].DstOffset < moves[j].SrcOffset + moves[j].Size && moves[j].SrcOffset < moves[i].DstOffset + moves[i].Size ? 1 : 0;
+				for (size_t j = 0; j < i; ++j)
+					overlapping += moves[i].DstOffset < moves[j].DstOffset + moves[j].Size && moves[j].DstOffset < moves[i].DstOffset + moves[i].Size ? 1 : 0;
+			}
+			for (auto& move : moves)
+				std::copy(memory.begin() + move.SrcOffset, memory.begin() + move.SrcOffset + move.Size, memory.begin() + move.DstOffset);
+			for (size_t i = 0; i < live.size(); ++i)
+			{
+				const auto dataOffset = (live[i].UnalignedOffset + Alignment - 1) / Alignment * Alignment;
+				corrupted += std::any_of(memory.begin() + dataOffset, memory.begin() + live[i].UnalignedOffset + live[i].Size, [&](uint32_t id) { return id != ids[i]; }) ? 1 : 0;
+			}
+
+			if (frame > 2)
+				manager.ReleaseStaleAllocations(frame - 2);
+			if (frame > 3)
+				shrinking += manager.GetLargestFreeBlockSize() < largest ? 1 : 0;
+			largest = manager.GetLargestFreeBlockSize();
+			if (bytesMoved == 0 && manager.GetStaleAllocationsSize() == 0)
+				break;
+			frames = frame;
+		}
+		std::printf("%s: largest free block %zu KB -> %zu KB of %zu KB free after %zu frames\n", backend == GPUAllocationsManager::BackendType::TLSF ? "TLSF" : "Ordered maps",
+			size_t(initialLargest) >> 10, size_t(largest) >> 10, size_t(freeSize) >> 10, frames);
+		CHECK(upwards == 0);
+		CHECK(overlapping == 0);
+		CHECK(corrupted == 0);
+		CHECK(shrinking == 0);
+		CHECK(largest > 4 * initialLargest);
+		CHECK(manager.GetFreeSize() == freeSize && manager.GetStaleAllocationsSize() == 0);
+	}
+}
+
+int main()
+{
+	TestInterleavedQueueCompletion(GPUAllocationsManager::BackendType::OrderedMaps);
+	TestInterleavedQueueCompletion(GPUAllocationsManager::BackendType::TLSF);
+	TestDefragmentation(GPUAllocationsManager::BackendType::OrderedMaps);
+	TestDefragmentation(GPUAllocationsManager::BackendType::TLSF);
+	return CheckFailures();
+}